@@ -257,6 +257,11 @@ void android_switchCallbacks(callbacks *new) {
   last_callback = current_callback;
   current_callback = new;
 
+  // The menu and pause screens only redraw when something changes
+  redrawOnDemand(new);
+  // Rounds are played on the simulation thread
+  simScreen(new);
+
   // Get elapsed time for timing
   extern int getElapsedTime(void);
   extern int lasttime;
@@ -391,11 +396,8 @@ void gltron_init(void) {
   }
   
   // Load menu.txt similar to desktop gltron.c
-  char *path = getFullPath("menu.txt");
-  if (path) {
-    pMenuList = loadMenuFile(path);
-    free(path);
-  } else {
+  pMenuList = loadMenuFile("menu.txt");
+  if (!pMenuList) {
     if (g_android_asset_mgr) {
       AAsset* asset = AAssetManager_open(g_android_asset_mgr, "menu.txt", AASSET_MODE_STREAMING);
       if (asset) {
@@ -584,16 +586,14 @@ static void draw_rect(int x, int y, int w, int h, float r, float g, float b, flo
   // Use shader program
   GLuint shaderProgram = shader_get_basic();
   if (!shaderProgram) return;
-  glUseProgram(shaderProgram);
+  useShaderProgram(shaderProgram);
 
   // Set up matrices
-  GLint projectionLoc = glGetUniformLocation(shaderProgram, "projectionMatrix");
   GLint modelViewLoc = glGetUniformLocation(shaderProgram, "modelView");
-  GLint colorLoc = glGetUniformLocation(shaderProgram, "color");
 
-  glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projection);
+  setProjectionMatrix(shaderProgram, projection);
   glUniformMatrix4fv(modelViewLoc, 1, GL_FALSE, modelView);
-  glUniform4f(colorLoc, r, g, b, a);
+  setColor(shaderProgram, r, g, b, a);
 
   // Set up vertex attribute
   GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
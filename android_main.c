@@ -393,6 +393,9 @@ static int init_egl(ANativeWindow* window, struct android_app* app) {
     return 0;
   }
 
+  // Fresh context: nothing we shadowed in shaders.c is valid anymore
+  invalidateStateCache();
+
   // Query actual surface size
   eglQuerySurface(s_display, s_surface, EGL_WIDTH, &s_width);
   eglQuerySurface(s_display, s_surface, EGL_HEIGHT, &s_height);
@@ -496,6 +499,9 @@ static int32_t handle_input(struct android_app* app, AInputEvent* event) {
     (void)app;
     int32_t type = AInputEvent_getType(event);
 
+    // Any input may change what the menu or pause screen shows
+    redrawInput();
+
     if (type == AINPUT_EVENT_TYPE_MOTION) {
         int32_t action = AMotionEvent_getAction(event) & AMOTION_EVENT_ACTION_MASK;
         float x = AMotionEvent_getX(event, 0);
@@ -558,7 +564,7 @@ void gltron_frame(void) {
   // Ensure shader is bound before rendering
   GLuint prog = shader_get_basic();
   if (prog) {
-    glUseProgram(prog);
+    useShaderProgram(prog);
     __android_log_print(ANDROID_LOG_DEBUG, "gltron", "Shader program bound: %u", prog);
   } else {
     __android_log_print(ANDROID_LOG_WARN, "gltron", "No basic shader available");
@@ -594,6 +600,9 @@ void gltron_frame(void) {
 static void handle_cmd(struct android_app* app, int32_t cmd) {
   int new_width = 0, new_height = 0; // Declare outside switch to avoid redefinition
 
+  // A new, resized or uncovered window needs a frame even at rest
+  redrawInput();
+
   switch (cmd) {
     case APP_CMD_INIT_WINDOW:
       __android_log_print(ANDROID_LOG_INFO, "gltron", "APP_CMD_INIT_WINDOW");
@@ -683,8 +692,13 @@ void android_main(struct android_app* state) {
     struct android_poll_source* source;
 
   while (1) {
-    // Use ALooper_pollOnce with timeout 0 for non-blocking poll
-    while ((ALooper_pollOnce(0, NULL, &events, (void**)&source)) >= 0) {
+    // Block until the next frame is due; a menu or pause screen at rest,
+    // or an app without a surface, blocks until the next event
+    int ready = s_display != EGL_NO_DISPLAY && s_surface != EGL_NO_SURFACE;
+    int timeout = ready ? redrawTimeout() : -1;
+    if (timeout == 0) timeout = frameTimeout();
+    while ((ALooper_pollOnce(timeout, NULL, &events, (void**)&source)) >= 0) {
+      timeout = 0;
       if (source != NULL) {
         source->process(state, source);
       }
@@ -696,14 +710,12 @@ void android_main(struct android_app* state) {
       }
     }
 
-    // Render frame if surface is ready
-    if (s_display != EGL_NO_DISPLAY && s_surface != EGL_NO_SURFACE) {
+    // Render frame if surface is ready, something changed and the frame
+    // is due (events wake us early); gltron_frame() swaps the buffers
+    if (s_display != EGL_NO_DISPLAY && s_surface != EGL_NO_SURFACE &&
+        redrawTimeout() == 0 && frameTimeout() == 0) {
+      frameWait();
       gltron_frame();
-      EGLBoolean ok = eglSwapBuffers(s_display, s_surface);
-      if (!ok) {
-        EGLint e = eglGetError();
-        __android_log_print(ANDROID_LOG_ERROR, "gltron", "eglSwapBuffers failed: 0x%04x", e);
-      }
       if (g_finish_requested) {
         __android_log_print(ANDROID_LOG_INFO, "gltron", "Finishing activity on BACK at top-level");
         finish_activity(state);
@@ -0,0 +1,81 @@
+/*
+  linear allocators
+
+  An arena hands out memory by bumping an offset into one block and
+  takes it all back at once with arenaReset(), there is no freeing of
+  single allocations. match_arena holds what lives for one round and is
+  reset by initData(), frame_arena holds what a frame builds and throws
+  away (the world vertex buffer) and is reset as a frame starts.
+
+  An arena starts out empty. What doesn't fit goes into extra blocks
+  until the next reset, which then replaces the block by one large
+  enough for everything, so after the first round or frame the game
+  does no malloc() or free() at all. Arenas are only used by the main
+  thread.
+*/
+
+#include "gltron.h"
+
+#define ARENA_ALIGN 16
+/* blocks are sized in whole pages */
+#define ARENA_PAGE 4096
+
+typedef struct ArenaSpill {
+  struct ArenaSpill *next;
+  size_t size; /* header included */
+} ArenaSpill;
+/* the data after the header stays aligned */
+#define SPILL_HEADER ((sizeof(ArenaSpill) + ARENA_ALIGN - 1) & \
+                      ~(size_t) (ARENA_ALIGN - 1))
+
+Arena match_arena = { "match" };
+Arena frame_arena = { "frame" };
+
+void* arenaAlloc(Arena *a, size_t bytes) {
+  ArenaSpill *spill;
+  void *p;
+
+  bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+  if(a->used + bytes <= a->size) {
+    p = a->base + a->used;
+    a->used += bytes;
+  } else {
+    /* once anything has spilled, everything after does as well */
+    spill = malloc(SPILL_HEADER + bytes);
+    if(spill == NULL) {
+      fprintf(stderr, "can't allocate %lu bytes in the %s arena\n",
+              (unsigned long) bytes, a->name);
+      return NULL;
+    }
+    spill->size = SPILL_HEADER + bytes;
+    spill->next = a->spill;
+    a->spill = spill;
+    a->used += bytes;
+    p = (unsigned char*) spill + SPILL_HEADER;
+    memAccount(MEM_ARENA, spill->size);
+  }
+  if(a->used > a->peak)
+    a->peak = a->used;
+  return p;
+}
+
+void arenaReset(Arena *a) {
+  ArenaSpill *spill;
+  size_t size;
+
+  while((spill = a->spill) != NULL) {
+    a->spill = spill->next;
+    memAccount(MEM_ARENA, -(ptrdiff_t) spill->size);
+    free(spill);
+  }
+  if(a->used > a->size) {
+    size = (a->used + ARENA_PAGE - 1) & ~(size_t) (ARENA_PAGE - 1);
+    free(a->base);
+    memAccount(MEM_ARENA, -(ptrdiff_t) a->size);
+    a->base = malloc(size);
+    a->size = a->base ? size : 0;
+    memAccount(MEM_ARENA, a->size);
+    a->grown++;
+  }
+  a->used = 0;
+}
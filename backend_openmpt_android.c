@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include "sound_backend.h"
 #include "gltron.h" // for getFullPath declaration
+#include "pack.h"
 
 #include "android-dependencies/openmpt/libopenmpt/libopenmpt.h"
 
@@ -32,8 +33,20 @@ static int enable_sound = 1;
 static int enable_music = 1;
 
 static openmpt_module* mod = NULL;
+static long mod_bytes = 0; // the module file, as an estimate of what openmpt keeps
 static Sfx sfx[SFX_MAX];
 
+static void close_music(void) {
+  if (mod) { openmpt_module_destroy(mod); mod = NULL; }
+  memAccount(MEM_SOUND, -mod_bytes); mod_bytes = 0;
+}
+
+static void free_sfx(Sfx* s) {
+  if (!s->data) return;
+  memAccount(MEM_SOUND, -(ptrdiff_t)s->frames * s->channels * 2);
+  free(s->data); s->data = NULL;
+}
+
 static void mix(short* out, int frames) {
   memset(out, 0, sizeof(short) * frames * 2);
   // music
@@ -146,6 +159,30 @@ static int load_wav(const char* path, short** out_data, int* out_frames, int* ou
   return 1;
 }
 
+// Same for a PCM16 WAV in memory
+static int parse_wav(const unsigned char* p, size_t sz, const char* path, short** out_data, int* out_frames, int* out_channels) {
+  if (sz < 44 || memcmp(p, "RIFF", 4) != 0 || memcmp(p+8, "WAVE", 4) != 0) return 0;
+  unsigned short channels = *(const unsigned short*)(p+22);
+  unsigned int sampleRate = *(const unsigned int*)(p+24);
+  unsigned short bits = *(const unsigned short*)(p+34);
+  if (bits != 16 || channels == 0) return 0;
+  // find 'data' chunk from byte 12
+  size_t off = 12; unsigned int csz = 0; int found = 0;
+  while (off + 8 <= sz) {
+    if (memcmp(p+off, "data", 4) == 0) { csz = *(const unsigned int*)(p+off+4); off += 8; found = 1; break; }
+    unsigned int skip = *(const unsigned int*)(p+off+4); off += 8 + skip;
+  }
+  if (!found || csz > sz - off) return 0;
+  short* data = (short*)malloc(csz);
+  if (!data) return 0;
+  memcpy(data, p+off, csz);
+  *out_data = data; *out_frames = (int)(csz / (2 * channels)); *out_channels = channels;
+  if (sampleRate != SAMPLE_RATE) {
+    __android_log_print(ANDROID_LOG_WARN, "gltron", "WAV %s sampleRate %u differs from %d; pitch may be off", path, sampleRate, SAMPLE_RATE);
+  }
+  return 1;
+}
+
 // Backend interface
 int sb_init(void) {
   memset(sfx, 0, sizeof(sfx));
@@ -155,13 +192,25 @@ int sb_init(void) {
 }
 
 void sb_shutdown(void) {
-  if (mod) { openmpt_module_destroy(mod); mod = NULL; }
-  for (int i=0;i<SFX_MAX;++i){ if (sfx[i].data) { free(sfx[i].data); sfx[i].data=NULL; } }
+  close_music();
+  for (int i=0;i<SFX_MAX;++i) free_sfx(&sfx[i]);
   destroy_audio();
 }
 
 int sb_load_music(const char* path) {
-  if (mod) { openmpt_module_destroy(mod); mod = NULL; }
+  close_music();
+  // openmpt copies what it needs, so a packed module is read in place
+  size_t packed_sz;
+  const void* packed = packData(path, &packed_sz);
+  if (packed && packed_sz > 0) {
+    mod = openmpt_module_create_from_memory2(packed, packed_sz, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    if (mod) {
+      mod_bytes = (long)packed_sz;
+      memAccount(MEM_SOUND, mod_bytes);
+      __android_log_print(ANDROID_LOG_INFO, "gltron", "sb_load_music: loaded '%s' from the pack (%ld bytes)", path, mod_bytes);
+      return 1;
+    }
+  }
   char* full = getFullPath((char*)path);
   void* buf = NULL; long sz = 0;
   FILE* f = NULL;
@@ -203,6 +252,8 @@ int sb_load_music(const char* path) {
   if (!mod) {
     __android_log_print(ANDROID_LOG_ERROR, "gltron", "sb_load_music: openmpt_module_create_from_memory2 failed for '%s'", path ? path : "(null)");
   } else {
+    mod_bytes = sz;
+    memAccount(MEM_SOUND, mod_bytes);
 #ifdef ANDROID
     const char* title = openmpt_module_get_metadata(mod, "title");
     __android_log_print(ANDROID_LOG_INFO, "gltron", "sb_load_music: loaded '%s' (title='%s', %ld bytes)", path ? path : "(null)", title ? title : "", sz);
@@ -218,7 +269,7 @@ void sb_play_music(void) {
 }
 
 void sb_stop_music(void) {
-  if (mod) { openmpt_module_destroy(mod); mod = NULL; }
+  close_music();
 }
 
 void sb_set_enabled(int sound_on, int music_on) {
@@ -228,11 +279,17 @@ void sb_set_enabled(int sound_on, int music_on) {
 
 int sb_load_sfx(int id, const char* path) {
   if (id < 0 || id >= SFX_MAX) return 0;
-  char* full = getFullPath((char*)path);
   short* data=NULL; int frames=0; int ch=0; int ok = 0;
-  if (full) {
-    ok = load_wav(full, &data, &frames, &ch);
-    free(full);
+  size_t packed_sz;
+  const unsigned char* packed = packData(path, &packed_sz);
+  if (packed)
+    ok = parse_wav(packed, packed_sz, path, &data, &frames, &ch);
+  if (!ok) {
+    char* full = getFullPath((char*)path);
+    if (full) {
+      ok = load_wav(full, &data, &frames, &ch);
+      free(full);
+    }
   }
 #ifdef ANDROID
   if (!ok) {
@@ -248,35 +305,8 @@ int sb_load_sfx(int id, const char* path) {
           int total = 0; int r;
           while (total < sz && (r = AAsset_read(asset, (char*)buf + total, (size_t)(sz - total))) > 0) total += r;
         }
-        // load_wav expects a file; for simplicity, write to a temp file in internal storage
-        // but to avoid file I/O, implement a small load_wav_from_memory clone here
         if (buf) {
-          // Minimal parser for PCM16 WAV in memory
-          unsigned char* p = (unsigned char*)buf;
-          if (sz >= 44 && memcmp(p, "RIFF", 4) == 0 && memcmp(p+8, "WAVE", 4) == 0) {
-            unsigned short channels = *(unsigned short*)(p+22);
-            unsigned int sampleRate = *(unsigned int*)(p+24);
-            unsigned short bits = *(unsigned short*)(p+34);
-            if (bits == 16) {
-              // find 'data' chunk from byte 12
-              size_t off = 12; unsigned int csz = 0; int found = 0;
-              while (off + 8 <= (size_t)sz) {
-                if (memcmp(p+off, "data", 4) == 0) { csz = *(unsigned int*)(p+off+4); off += 8; found = 1; break; }
-                unsigned int skip = *(unsigned int*)(p+off+4); off += 8 + skip;
-              }
-              if (found && off + csz <= (size_t)sz) {
-                frames = (int)(csz / (2 * channels));
-                data = (short*)malloc(csz);
-                if (data) {
-                  memcpy(data, p+off, csz);
-                  ch = channels; ok = 1;
-                  if (sampleRate != SAMPLE_RATE) {
-                    __android_log_print(ANDROID_LOG_WARN, "gltron", "WAV %s sampleRate %u differs from %d; pitch may be off", path, sampleRate, SAMPLE_RATE);
-                  }
-                }
-              }
-            }
-          }
+          ok = parse_wav((const unsigned char*)buf, (size_t)sz, path, &data, &frames, &ch);
           free(buf);
         }
         AAsset_close(asset);
@@ -285,8 +315,9 @@ int sb_load_sfx(int id, const char* path) {
   }
 #endif
   if (!ok) return 0;
-  if (sfx[id].data) free(sfx[id].data);
+  free_sfx(&sfx[id]);
   sfx[id].data = data; sfx[id].frames = frames; sfx[id].channels = ch; sfx[id].playing = 0; sfx[id].pos = 0;
+  memAccount(MEM_SOUND, (ptrdiff_t)frames * ch * 2);
   return 1;
 }
 
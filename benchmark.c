@@ -0,0 +1,190 @@
+/*
+  benchmark mode
+
+  gltron --benchmark[=SECONDS[,SEED]] skips the menu and plays all-AI
+  rounds back to back, seeded, without vsync or a frame rate cap and
+  without sound, for SECONDS (default 60) of wall time. The rounds tick
+  at a fixed rate on the simulation thread, so every machine plays the
+  same rounds; only the number of frames drawn of them differs. At the
+  end it prints the frames, the average, 99th percentile and worst
+  frame times, the time a simulation tick took, the peak memory use and,
+  in COUNT_DRAWS builds, the draw calls per frame, then exits.
+*/
+
+#include "gltron.h"
+#include "switchCallbacks.h"
+
+#include <string.h>
+
+#define BENCH_SECONDS 60
+
+#ifdef COUNT_DRAWS
+int drawcalls = 0;
+#endif
+
+static int benching = 0;
+/* the user's values of what a benchmark overrides */
+static int user_screenSaver, user_vsync, user_frame_rate;
+static int user_playSound, user_playMusic;
+static int overridden = 0;
+static int bench_seconds = BENCH_SECONDS;
+static unsigned int bench_seed = 1;
+
+static double start = 0;  /* when the first frame was done */
+static double last = 0;
+static int start_ticks;
+static double start_busy;
+#ifdef COUNT_DRAWS
+static int start_draws;
+#endif
+static int rounds = 0;
+
+/* frame to frame times in ms */
+static float *times = NULL;
+static int nTimes = 0, maxTimes = 0;
+
+int benchmarkArg(char *arg) {
+  char *end;
+
+  if(strncmp(arg, "--benchmark", 11) != 0 ||
+     (arg[11] != '=' && arg[11] != 0))
+    return 0;
+  if(arg[11] == '=') {
+    bench_seconds = strtol(arg + 12, &end, 10);
+    if(*end == ',')
+      bench_seed = strtoul(end + 1, &end, 10);
+    if(*end != 0 || bench_seconds <= 0) {
+      fprintf(stderr, "benchmark: expected --benchmark[=SECONDS[,SEED]]\n");
+      exit(1);
+    }
+  }
+  benching = 1;
+  return 1;
+}
+
+/* called after the menu is loaded: an unattended match, as fast as it
+   draws. saveSettings() turns the overrides off while it writes, so they
+   never reach ~/.gltronrc */
+void benchmarkSettings(int on) {
+  Settings *s = game->settings;
+
+  if(!benching || on == overridden)
+    return;
+  overridden = on;
+  if(on) {
+    user_screenSaver = s->screenSaver;
+    user_vsync = s->vsync;
+    user_frame_rate = s->frame_rate;
+    user_playSound = s->playSound;
+    user_playMusic = s->playMusic;
+    s->screenSaver = 1;
+    s->vsync = 0;
+    s->frame_rate = 0;
+    s->playSound = 0;
+    s->playMusic = 0;
+  } else {
+    s->screenSaver = user_screenSaver;
+    s->vsync = user_vsync;
+    s->frame_rate = user_frame_rate;
+    s->playSound = user_playSound;
+    s->playMusic = user_playMusic;
+  }
+}
+
+int benchmarking(void) {
+  return benching;
+}
+
+void benchmarkStart(void) {
+  printf("benchmark: %d s, seed %u\n", bench_seconds, bench_seed);
+  srand(bench_seed);
+  initData();
+  switchCallbacks(&gameCallbacks);
+}
+
+int benchmarkRound(void) {
+  if(!benching)
+    return 0;
+  /* through the pause screen, which stops the simulation thread */
+  switchCallbacks(&pauseCallbacks);
+  initData();
+  switchCallbacks(&gameCallbacks);
+  rounds++;
+  return 1;
+}
+
+static int compareTimes(const void *a, const void *b) {
+  float x = *(const float*) a, y = *(const float*) b;
+  return (x > y) - (x < y);
+}
+
+static void benchmarkReport(double seconds) {
+  size_t cpu, cpu_peak, gpu, gpu_peak;
+  double sum = 0;
+  int i, p99;
+
+  if(nTimes == 0) {
+    printf("benchmark: no frames drawn\n");
+    return;
+  }
+  qsort(times, nTimes, sizeof(float), compareTimes);
+  for(i = 0; i < nTimes; i++)
+    sum += times[i];
+  /* the time 99% of the frames took at most */
+  p99 = (nTimes * 99 + 99) / 100 - 1;
+  memTotal(0, &cpu, &cpu_peak);
+  memTotal(1, &gpu, &gpu_peak);
+
+  printf("benchmark: %.1f s, %d rounds finished\n", seconds, rounds);
+  printf("benchmark: %d frames, %.1f fps\n", nTimes, nTimes / seconds);
+  printf("benchmark: frame ms average %.2f, p99 %.2f, worst %.2f\n",
+         sum / nTimes, times[p99], times[nTimes - 1]);
+  /* the ticks come at a fixed rate, what they cost is what differs;
+     only timed on the simulation thread */
+  if(simBusyMs() > start_busy)
+    printf("benchmark: sim ms per tick %.3f\n",
+           (simBusyMs() - start_busy) / (simTicks() - start_ticks));
+#ifdef COUNT_DRAWS
+  printf("benchmark: %.1f draw calls/frame\n",
+         (double) (drawcalls - start_draws) / nTimes);
+#endif
+  printf("benchmark: peak memory %lu kB cpu, %lu kB gpu\n",
+         (unsigned long) (cpu_peak + 1023) / 1024,
+         (unsigned long) (gpu_peak + 1023) / 1024);
+}
+
+void benchmarkFrame(void) {
+  double now = frameClock();
+  float *grown;
+
+  if(!benching)
+    return;
+  /* timed from the end of the first frame, after the loading */
+  if(start == 0) {
+    start = last = now;
+    start_ticks = simTicks();
+    start_busy = simBusyMs();
+#ifdef COUNT_DRAWS
+    start_draws = drawcalls;
+#endif
+    return;
+  }
+
+  if(nTimes == maxTimes) {
+    maxTimes = maxTimes ? maxTimes * 2 : 4096;
+    grown = realloc(times, maxTimes * sizeof(float));
+    if(grown == NULL) {
+      fprintf(stderr, "benchmark: out of memory after %d frames\n", nTimes);
+      benchmarkReport((last - start) / 1000);
+      exit(1);
+    }
+    times = grown;
+  }
+  times[nTimes++] = now - last;
+  last = now;
+
+  if(now - start >= bench_seconds * 1000.0) {
+    benchmarkReport((now - start) / 1000);
+    exit(0);
+  }
+}
@@ -0,0 +1,300 @@
+/*
+  offscreen capture mode
+
+  Renders a seeded all-AI match into an EGL pbuffer instead of a GLUT
+  window, so it runs on machines without a display (e.g. with Mesa's
+  llvmpipe). Every frame is written as a binary PPM, together with a CSV
+  of per-frame render times. Game time advances by a fixed step per
+  frame, so the same seed always produces the same images.
+
+  gltron --capture=DIR [--frames=N] [--size=WxH] [--seed=N] [--fps=N]
+
+  The stress options of stress.c and the --perf runs of perf.c use the
+  same offscreen setup.
+*/
+
+#include "gltron.h"
+#include "switchCallbacks.h"
+
+#ifdef CAPTURE
+
+#include <string.h>
+#include <time.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static char *capture_dir = NULL;
+static int capture_frames = 300;
+static int capture_frames_set = 0;
+static int capture_fps = 60;
+static unsigned int capture_seed = 1;
+static int capture_w = 640;
+static int capture_h = 480;
+static int capture_clock = 0;
+
+static EGLDisplay egl_dpy = EGL_NO_DISPLAY;
+static EGLSurface egl_surface = EGL_NO_SURFACE;
+static EGLContext egl_context = EGL_NO_CONTEXT;
+
+int captureArgs(int argc, char *argv[]) {
+  int i;
+  char *arg;
+
+  for(i = 1; i < argc; i++) {
+    arg = argv[i];
+    if(strncmp(arg, "--capture=", 10) == 0) {
+      capture_dir = arg + 10;
+      capturing = 1;
+    } else if(strncmp(arg, "--frames=", 9) == 0) {
+      capture_frames = atoi(arg + 9);
+      capture_frames_set = 1;
+    }
+    else if(strncmp(arg, "--fps=", 6) == 0)
+      capture_fps = atoi(arg + 6);
+    else if(strncmp(arg, "--seed=", 7) == 0)
+      capture_seed = strtoul(arg + 7, NULL, 10);
+    else if(strncmp(arg, "--size=", 7) == 0) {
+      if(sscanf(arg + 7, "%dx%d", &capture_w, &capture_h) != 2) {
+        fprintf(stderr, "capture: bad size '%s', expected WxH\n", arg + 7);
+        exit(1);
+      }
+    } else if(stressArg(arg) || perfArg(arg))
+      capturing = 1;
+  }
+
+  if(capture_frames <= 0 || capture_fps <= 0 ||
+     capture_w <= 0 || capture_h <= 0) {
+    fprintf(stderr, "capture: frames, fps and size must be positive\n");
+    exit(1);
+  }
+  return capturing;
+}
+
+/* called after the settings are loaded: an unattended, windowless match */
+void captureSettings() {
+  game->settings->width = capture_w;
+  game->settings->height = capture_h;
+  game->settings->fullscreen = 0;
+  game->settings->screenSaver = 1;
+  game->settings->mouse_warp = 0;
+  game->settings->playSound = 0;
+}
+
+int captureClock(void) {
+  return capture_clock;
+}
+
+static int initEGL(int w, int h) {
+  EGLint major, minor, n;
+  EGLConfig config;
+  EGLint config_attribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+    EGL_DEPTH_SIZE, 24,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLint pbuffer_attribs[] = { EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE };
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+
+  /* prefer Mesa's surfaceless platform, it needs neither X nor a GPU */
+  getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+    eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  if(getPlatformDisplay)
+    egl_dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, NULL);
+#endif
+  if(egl_dpy == EGL_NO_DISPLAY)
+    egl_dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  if(egl_dpy == EGL_NO_DISPLAY || !eglInitialize(egl_dpy, &major, &minor)) {
+    fprintf(stderr, "capture: can't initialize EGL (0x%x)\n", eglGetError());
+    return 0;
+  }
+  /* the desktop renderer uses fixed function GL */
+  if(!eglBindAPI(EGL_OPENGL_API)) {
+    fprintf(stderr, "capture: EGL has no desktop OpenGL\n");
+    return 0;
+  }
+  if(!eglChooseConfig(egl_dpy, config_attribs, &config, 1, &n) || n == 0) {
+    fprintf(stderr, "capture: no pbuffer config\n");
+    return 0;
+  }
+  egl_surface = eglCreatePbufferSurface(egl_dpy, config, pbuffer_attribs);
+  egl_context = eglCreateContext(egl_dpy, config, EGL_NO_CONTEXT, NULL);
+  if(egl_surface == EGL_NO_SURFACE || egl_context == EGL_NO_CONTEXT ||
+     !eglMakeCurrent(egl_dpy, egl_surface, egl_surface, egl_context)) {
+    fprintf(stderr, "capture: can't create %dx%d pbuffer (0x%x)\n",
+            w, h, eglGetError());
+    return 0;
+  }
+  printf("capture: EGL %d.%d, %dx%d pbuffer\n", major, minor, w, h);
+  return 1;
+}
+
+static void shutdownEGL() {
+  eglMakeCurrent(egl_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if(egl_context != EGL_NO_CONTEXT) eglDestroyContext(egl_dpy, egl_context);
+  if(egl_surface != EGL_NO_SURFACE) eglDestroySurface(egl_dpy, egl_surface);
+  eglTerminate(egl_dpy);
+}
+
+static int writeFrame(int frame, unsigned char *pixels, int w, int h) {
+  char name[1024];
+  FILE *f;
+  int y;
+
+  snprintf(name, sizeof(name), "%s%cframe_%05d.ppm",
+           capture_dir, SEPERATOR, frame);
+  f = fopen(name, "wb");
+  if(f == NULL) {
+    fprintf(stderr, "capture: can't write %s\n", name);
+    return 0;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", w, h);
+  /* GL rows start at the bottom */
+  for(y = h - 1; y >= 0; y--)
+    fwrite(pixels + y * w * 3, 3, w, f);
+  fclose(f);
+  return 1;
+}
+
+double captureMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* what's allocated once the run is over, for comparing runs */
+static void writeMemory() {
+  char name[1024];
+  FILE *f;
+
+  snprintf(name, sizeof(name), "%s%cmemory.csv", capture_dir, SEPERATOR);
+  f = fopen(name, "w");
+  if(f == NULL) {
+    fprintf(stderr, "capture: can't write %s\n", name);
+    return;
+  }
+  memDump(f);
+  fclose(f);
+}
+
+/* with --capture=DIR the stress results also go to DIR/stress.csv */
+static void runStressCapture() {
+  char name[1024];
+  FILE *csv = NULL;
+
+  if(capture_dir != NULL) {
+    snprintf(name, sizeof(name), "%s%cstress.csv", capture_dir, SEPERATOR);
+    csv = fopen(name, "w");
+    if(csv == NULL) {
+      fprintf(stderr, "capture: can't write %s\n", name);
+      exit(1);
+    }
+  }
+  runStress(capture_frames_set ? capture_frames : 60, csv);
+  if(csv != NULL)
+    fclose(csv);
+  if(capture_dir != NULL)
+    writeMemory();
+}
+
+void runCapture() {
+  char name[1024];
+  unsigned char *pixels;
+  FILE *times;
+  double t, total = 0;
+  double cpu[PASSES], gpu[PASSES];
+  int frame, i;
+  gDisplay *d = game->screen;
+
+  if(!initEGL(capture_w, capture_h))
+    exit(1);
+
+  d->win_id = 0;
+  d->w = capture_w;
+  d->h = capture_h;
+  initGameScreen();
+  changeDisplay();
+
+  printf("loading fonts...\n");
+  initFonts();
+  printf("loading textures...\n");
+  initTexture(d);
+  initGLGame();
+
+  if(stressEnabled()) {
+    runStressCapture();
+    shutdownEGL();
+    return;
+  }
+  if(perfEnabled()) {
+    i = runPerf(capture_dir, capture_seed);
+    shutdownEGL();
+    if(i)
+      exit(i);
+    return;
+  }
+
+  pixels = malloc(capture_w * capture_h * 3);
+  snprintf(name, sizeof(name), "%s%ctimes.csv", capture_dir, SEPERATOR);
+  times = fopen(name, "w");
+  if(pixels == NULL || times == NULL) {
+    fprintf(stderr, "capture: can't write to %s\n", capture_dir);
+    exit(1);
+  }
+  fprintf(times, "frame,game_ms,render_ms,polys,draws");
+  for(i = 0; i < PASSES; i++)
+    fprintf(times, ",%s_cpu,%s_gpu", profileName(i), profileName(i));
+  fprintf(times, "\n");
+
+  srand(capture_seed);
+  initData();
+  switchCallbacks(&gameCallbacks);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+  for(frame = 0; frame < capture_frames; frame++) {
+    capture_clock += 1000 / capture_fps;
+
+    /* a finished round goes straight into the next one */
+    if(current_callback != &gameCallbacks) {
+      initData();
+      switchCallbacks(&gameCallbacks);
+    }
+    idleGame();
+
+    drawcalls = 0;
+    t = captureMs();
+    displayGame();
+    glFinish();
+    t = captureMs() - t;
+    total += t;
+    /* after glFinish() this frame's GPU times are in already */
+    profileFrame();
+    profileTimes(0, cpu, gpu);
+
+    fprintf(times, "%d,%d,%.3f,%d,%d",
+            frame, capture_clock, t, polycount, drawcalls);
+    for(i = 0; i < PASSES; i++) {
+      if(gpu[i] < 0)
+        fprintf(times, ",%.3f,", cpu[i]);
+      else
+        fprintf(times, ",%.3f,%.3f", cpu[i], gpu[i]);
+    }
+    fprintf(times, "\n");
+    glReadPixels(0, 0, capture_w, capture_h, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    if(!writeFrame(frame, pixels, capture_w, capture_h))
+      exit(1);
+  }
+
+  fclose(times);
+  free(pixels);
+  writeMemory();
+  printf("capture: %d frames, %.3f ms/frame average render time\n",
+         capture_frames, total / capture_frames);
+  shutdownEGL();
+}
+
+#endif
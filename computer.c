@@ -36,13 +36,13 @@ void doComputer(Player *me, Data *him) {
     return;
   }
   
-  data = me->data;
+  data = me->sim;
   ai = me->ai;
   ai->moves++;
 
   if(ai->danger <= 0) {
     for(i = 0; i < dn; i++) {
-      getDistPoint(me->data, dtest[i], &x, &y);
+      getDistPoint(me->sim, dtest[i], &x, &y);
       if(getCol(x, y)) ai->danger = dtest[i];
     }
   }
@@ -59,7 +59,7 @@ void doComputer(Player *me, Data *him) {
       else if(s2 > fd && s1 - ai->tdiff < s2)
 	tvalue = 3;
       else tvalue = (s1 > s2) ? 1 : 3;
-      turn(data, tvalue);
+      turn(data, tvalue, simTime());
       ai->tdiff += (tvalue == 1) ? 1 : -1;
       ai->danger = 0;
     } else {
@@ -74,7 +74,7 @@ void doComputer(Player *me, Data *him) {
       abs(data->posy + dirsY[dir2] - him->posy);
     tvalue = (d1 < d2) ? 1 : 3;
     if(freeway(data, (data->dir + tvalue) % 4) > fd) {
-      turn(data, tvalue);
+      turn(data, tvalue, simTime());
       ai->tdiff += (tvalue == 1) ? 1 : -1;
       ai->moves = 0;
     } else {
@@ -48,7 +48,7 @@ int getCol(int x, int y) {
   return *(colmap + offset) & mask;
 }
 
-void turn(Data* data, int direction) {
+void turn(Data* data, int direction, int time) {
   line *new;
 
   /* Validate input parameters */
@@ -71,7 +71,7 @@ void turn(Data* data, int direction) {
 
     /* smooth turning */
     data->last_dir = data->dir;
-    data->turn_time = getElapsedTime();
+    data->turn_time = time;
 
     /* Update direction (ensure it's always 0-3) */
     data->dir = ((data->dir + direction) % 4 + 4) % 4;
@@ -133,10 +133,10 @@ void initGameStructures() { /* called only once */
   /* Model *m; */
   AI *ai;
   Player *p;
-  char *path;
 
   game->winner = -1;
   game->screen = (gDisplay*) malloc(sizeof(gDisplay));
+  memAccount(MEM_PLAYERS, sizeof(gDisplay));
   d = game->screen;
   d->h = game->settings->height; d->w = game->settings->width;
   d->vp_x = 0; d->vp_y = 0;
@@ -153,22 +153,23 @@ void initGameStructures() { /* called only once */
     p->display = (gDisplay*) malloc(sizeof(gDisplay));
     p->ai = (AI*) malloc(sizeof(AI));
     p->data = (Data*) malloc(sizeof(Data));
+    p->sim = (Data*) malloc(sizeof(Data));
     p->camera = (Camera*) malloc(sizeof(Camera));
+    /* the trails live inline in both Data copies */
+    memAccount(MEM_PLAYERS, sizeof(Model) + sizeof(gDisplay) + sizeof(AI) +
+               2 * sizeof(Data) + sizeof(Camera));
 
     // init model & display & ai
 
     // load player mesh, currently only one type
-    path = getFullPath("t-u-low.obj");
-    // path = getFullPath("tron-med.obj");
-    if(path != 0)
-      // model size == CYCLE_HEIGHT
-      p->model->mesh = loadModel(path, CYCLE_HEIGHT, 1);
-    else {
+    // model size == CYCLE_HEIGHT
+    // the players share the geometry, each has its own colors
+    p->model->mesh = getModel("t-u-low.obj", CYCLE_HEIGHT, 1);
+    // p->model->mesh = getModel("tron-med.obj", CYCLE_HEIGHT, 1);
+    if(p->model->mesh == NULL) {
       printf("fatal: could not load model - exiting...\n");
       exit(1);
     }
-    
-    free(path);
 
     /* copy contents from colors_a[] to model struct */
     for(j = 0; j < 4; j++) {
@@ -248,9 +249,15 @@ void initData() {
 
   game->running = game->players; /* everyone is alive */
   game->winner = -1;
+  /* everything of the last round goes at once */
+  arenaReset(&match_arena);
   /* colmap */
   colwidth = (GSIZE + 7) / 8;
-  if(colmap == NULL) colmap = (unsigned char*) malloc(colwidth * GSIZE);
+  colmap = (unsigned char*) arenaAlloc(&match_arena, colwidth * GSIZE);
+  if(colmap == NULL) {
+    fprintf(stderr, "fatal: no memory for the collision map\n");
+    exit(1);
+  }
   for(i = 0; i < colwidth * GSIZE; i++)
     *(colmap + i) = 0;
 
@@ -360,7 +367,7 @@ void fixTrails() {
   Data *d;
   line *t;
   for(i = 0; i < game->players; i++) {
-    d = game->player[i].data;
+    d = game->player[i].sim;
     if(d->speed > 0) {
       t = &(d->trails[0]);
       while(t != d->trail) {
@@ -452,9 +459,38 @@ void chaseCamMove() {
   }
 }
 
-void idleGame( void ) {
+/* steps per tick: with only AI players left a fast finish plays the
+   rest of the round at FAST_FINISH times the speed */
+static int tickLoops(void) {
+  int i;
+
+  if(game->settings->fast_finish != 1)
+    return 1;
+  for(i = 0; i < game->players; i++)
+    if(game->player[i].ai->active != 1 &&
+       game->player[i].sim->exp_radius < EXP_RADIUS_MAX)
+      /* game->player[i].sim->speed > 0) */
+      return 1;
+  return FAST_FINISH;
+}
+
+void tickGame(double step) {
   int i, j;
-  int loop; 
+  int loop = tickLoops();
+
+  for(j = 0; j < loop; j++) {
+    movePlayers(loop == FAST_FINISH ? 20 : step);
+
+    /* do AI */
+    for(i = 0; i < game->players; i++)
+      if(game->player[i].ai != NULL)
+	if(game->player[i].ai->active == 1)
+	  doComputer(&(game->player[i]), game->player[i].sim);
+  }
+}
+
+void idleGame( void ) {
+  int loop;
 
   /* Apply any pending display changes right away in game loop */
   applyDisplaySettingsDeferred();
@@ -465,38 +501,34 @@ void idleGame( void ) {
   soundIdle();
 #endif
 
-  if(game->settings->fast_finish == 1) {
-    loop = FAST_FINISH;
-    for(i = 0; i < game->players; i++)
-      if(game->player[i].ai->active != 1 &&
-	 game->player[i].data->exp_radius < EXP_RADIUS_MAX)
-	 /* game->player[i].data->speed > 0) */
-	loop = 1;
-  } else loop = 1;
+  /* the sim thread does its own fast finish */
+  loop = simThreaded() ? 1 : tickLoops();
 
   // Ensure we don't have huge time jumps on first frame
   if(getElapsedTime() - lasttime > 1000) {
     lasttime = getElapsedTime() - 20; // Reset to reasonable delta
   }
-  if(getElapsedTime() - lasttime < 10 && loop == 1) return;
+#ifndef ANDROID
+  /* sleep until the frame is due; the Android loop does its own waiting */
+  if(loop == 1)
+    frameWait();
+#endif
   timediff();
-  for(j = 0; j < loop; j++) {
-    if(loop == FAST_FINISH)
-      dt = 20;
-    movePlayers();
-
-    /* do AI */
-    for(i = 0; i < game->players; i++)
-      if(game->player[i].ai != NULL)
-	if(game->player[i].ai->active == 1)
-	  doComputer(&(game->player[i]), game->player[i].data);
-  }
+  if(loop == 1)
+    dt = frameSmooth(dt);
+  else
+    dt = 20;
+  if(!simThreaded())
+    simTick(dt);
+  /* draw the newest tick */
+  simView();
 
   /* chase-cam movement here */
   camMove();
   chaseCamMove();
 #ifndef ANDROID
-  glutPostRedisplay();
+  if(!capturing)
+    glutPostRedisplay();
 #else
   /* Android: frame rendering should be requested by the app's loop */
 #endif
@@ -536,7 +568,7 @@ void resetScores() {
     game->player[i].data->score = 0;
 }
 
-void movePlayers() {
+void movePlayers(double step) {
   int i, j;
   float newx, newy;
   int x, y;
@@ -546,10 +578,10 @@ void movePlayers() {
 
   /* do movement and collision */
   for(i = 0; i < game->players; i++) {
-    data = game->player[i].data;
+    data = game->player[i].sim;
     if(data->speed > 0) { /* still alive */
-      newx = data->posx + dt / 100 * data->speed * dirsX[data->dir];
-      newy = data->posy + dt / 100 * data->speed * dirsY[data->dir];
+      newx = data->posx + step / 100 * data->speed * dirsX[data->dir];
+      newy = data->posy + step / 100 * data->speed * dirsY[data->dir];
       
       if((int)data->posx != newx || (int)data->posy != newy) {
 	/* collision-test here */
@@ -557,9 +589,7 @@ void movePlayers() {
 	col = colldetect(data->posx, data->posy, newx, newy,
 			 data->dir, &x, &y);
 	if (col) {
-#ifdef SOUND
-	  playSampleEffect(crash_sfx);
-#endif
+	  simEvent(SIM_CRASH);
 	  /* set endpoint to collision coordinates */
 	  newx = x;
 	  newy = y;
@@ -567,8 +597,8 @@ void movePlayers() {
 	  /* update scores; */
 	  if(game->settings->screenSaver != 1) {
 	    for(j = 0; j < game->players; j++) {
-	      if(j != i && game->player[j].data && game->player[j].data->speed > 0)
-	        game->player[j].data->score++;
+	      if(j != i && game->player[j].sim->speed > 0)
+	        game->player[j].sim->score++;
 	    }
 	  }
 	  
@@ -580,10 +610,6 @@ void movePlayers() {
 	    
 	    /* Set speed to crashed state */
 	    data->speed = SPEED_CRASHED;
-	    
-	    /* Ensure we don't process input during crash animation */
-	    extern int lasttime;
-	    lasttime = getElapsedTime();
 	  }
 #else
 	  data->speed = SPEED_CRASHED;
@@ -609,56 +635,60 @@ void movePlayers() {
       }
     } else { /* do trail countdown && explosion */
       if(data->exp_radius < EXP_RADIUS_MAX)
-	data->exp_radius += (float)dt * EXP_RADIUS_DELTA;
+	data->exp_radius += (float)step * EXP_RADIUS_DELTA;
       else if (data->speed == SPEED_CRASHED) {
 	data->speed = SPEED_GONE;
-	game->running--;
 	
-	if(game->running <= 1) { /* all dead, find survivor */
+	if(simGone() <= 1) { /* all dead, find survivor */
 	  /* Find the winner (if any) */
 	  for(winner = 0; winner < game->players; winner++) {
-	    if(game->player[winner].data && game->player[winner].data->speed > 0) 
+	    if(game->player[winner].sim->speed > 0)
 	      break;
 	  }
-	  
-	  /* Set winner index or -1 if no survivors */
-	  game->winner = (winner == game->players) ? -1 : winner;
 	  printf("winner: %d\n", winner);
 	  
-	  /* Set pause flag before switching callbacks to ensure proper state */
-	  game->pauseflag = PAUSE_GAME_FINISHED;
-	  
-#ifdef ANDROID
-	  /* On Android, we need to be more careful with callback switching */
-	  extern callbacks pauseCallbacks;
-	  
-	  /* Log the game end for debugging */
-	  printf("Game finished, winner: %d, running: %d\n", game->winner, game->running);
-	  
-	  /* Update timing before switching callbacks */
-	  extern int lasttime;
-	  lasttime = getElapsedTime();
-	  
-	  /* Try to use a safer approach for Android to prevent crashes */
-	  android_updateCallbacks(); /* Update timing to avoid huge jumps */
-	  
-	  /* Switch to pause callbacks */
-	  android_switchCallbacks(&pauseCallbacks);
-	  
-	  /* Double-check that pause flag is still set */
-	  game->pauseflag = PAUSE_GAME_FINISHED;
-#else
-	  switchCallbacks(&pauseCallbacks);
-#endif
+	  /* winner index or -1 if no survivors */
+	  simFinished((winner == game->players) ? -1 : winner);
 	  /* screenSaverCheck(0); */
 	}
       }
       if(game->settings->erase_crashed == 1 && data->trail_height > 0)
-	data->trail_height -= (float)(dt * TRAIL_HEIGHT) / 1000;
+	data->trail_height -= (float)(step * TRAIL_HEIGHT) / 1000;
     }
   }
 }
 
+/* leaves a finished round for the pause screen */
+void finishGame() {
+  game->pauseflag = PAUSE_GAME_FINISHED;
+
+#ifdef ANDROID
+  /* On Android, we need to be more careful with callback switching */
+  extern callbacks pauseCallbacks;
+
+  /* Log the game end for debugging */
+  printf("Game finished, winner: %d, running: %d\n", game->winner, game->running);
+
+  /* Update timing before switching callbacks */
+  extern int lasttime;
+  lasttime = getElapsedTime();
+
+  /* Try to use a safer approach for Android to prevent crashes */
+  android_updateCallbacks(); /* Update timing to avoid huge jumps */
+
+  /* Switch to pause callbacks */
+  android_switchCallbacks(&pauseCallbacks);
+
+  /* Double-check that pause flag is still set */
+  game->pauseflag = PAUSE_GAME_FINISHED;
+#else
+  /* benchmarks go straight on with the next round */
+  if(benchmarkRound())
+    return;
+  switchCallbacks(&pauseCallbacks);
+#endif
+}
+
 void timediff() {
   int t;
   t = getElapsedTime();
@@ -0,0 +1,257 @@
+/*
+  procedural floor
+
+  The whole arena floor is a single quad; the grid lines, the texture
+  tiling and the fade into the distance are worked out per fragment.
+  Drawing it costs the same for any arena size and line spacing, unlike
+  the per cell geometry in drawFloor(), which stays as the fallback for
+  GLs without shaders.
+*/
+
+/* GL 2.0 entry points from the desktop headers */
+#define GL_GLEXT_PROTOTYPES
+#include "gltron.h"
+#include "shaders.h"
+#include <string.h>
+
+#ifdef WIN32
+/* opengl32.dll only exports GL 1.1 */
+int drawShaderFloor(int textured, GLuint texture, float spacing) {
+  return 0;
+}
+#else
+
+#ifdef ANDROID
+static const char *vertexSource =
+  "attribute vec3 position;\n"
+  "uniform mat4 projectionMatrix;\n"
+  "uniform mat4 viewMatrix;\n"
+  "varying vec2 vWorld;\n"
+  "varying vec3 vEye;\n"
+  "void main() {\n"
+  "  vec4 eye = viewMatrix * vec4(position, 1.0);\n"
+  "  vWorld = position.xy;\n"
+  "  vEye = eye.xyz;\n"
+  "  gl_Position = projectionMatrix * eye;\n"
+  "}\n";
+#else
+static const char *vertexSource =
+  "#version 110\n"
+  "varying vec2 vWorld;\n"
+  "varying vec3 vEye;\n"
+  "void main() {\n"
+  "  vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+  "  vWorld = gl_Vertex.xy;\n"
+  "  vEye = eye.xyz;\n"
+  "  gl_Position = gl_ProjectionMatrix * eye;\n"
+  "}\n";
+#endif
+
+/* without derivatives the line width is estimated from the distance
+   alone, which is too thin where the floor is seen at a flat angle */
+static const char *fragmentSource =
+  "uniform sampler2D floorTexture;\n"
+  "uniform float textured;\n"
+  "uniform float spacing;\n"
+  "uniform vec4 lineColor;\n"
+  "uniform vec2 fade;\n"
+  "uniform float pixel;\n"
+  "varying vec2 vWorld;\n"
+  "varying vec3 vEye;\n"
+  "void main() {\n"
+  "  vec2 coord = vWorld / spacing;\n"
+  "  float distance = length(vEye);\n"
+  "  float f = 1.0 - smoothstep(fade.x, fade.y, distance);\n"
+  "  if(textured > 0.5) {\n"
+  "    gl_FragColor = vec4(texture2D(floorTexture, coord).rgb * f, 1.0);\n"
+  "  } else {\n"
+  "#ifdef DERIVATIVES\n"
+  "    vec2 w = fwidth(coord);\n"
+  "#else\n"
+  "    vec2 w = vec2(distance * pixel / spacing);\n"
+  "#endif\n"
+  "    vec2 g = abs(fract(coord - 0.5) - 0.5) / w;\n"
+  "    float line = 1.0 - min(min(g.x, g.y), 1.0);\n"
+  "    /* lines closer than a few pixels would only flicker */\n"
+  "    line *= 1.0 - smoothstep(0.15, 0.3, max(w.x, w.y));\n"
+  "    if(line * f < 0.004)\n"
+  "      discard;\n"
+  "    gl_FragColor = vec4(lineColor.rgb, lineColor.a * line * f);\n"
+  "  }\n"
+  "}\n";
+
+static GLuint program = 0;
+static int failed = 0;
+static GLint u_textured, u_spacing, u_lineColor, u_fade, u_pixel, u_texture;
+#ifdef ANDROID
+static GLint u_proj, u_view;
+static GLuint quad_vbo = 0;
+#endif
+
+static GLuint compileFloorShader(GLenum type, const char *header,
+                                 const char *source) {
+  const char *sources[2];
+  GLuint shader = glCreateShader(type);
+  GLint ok = GL_FALSE;
+
+  sources[0] = header;
+  sources[1] = source;
+  glShaderSource(shader, 2, sources, NULL);
+  glCompileShader(shader);
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if(!ok) {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+    LOGE("floor shader: %s\n", log);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+static int createFloorProgram(void) {
+  const char *extensions = (const char*) glGetString(GL_EXTENSIONS);
+  const char *header;
+  GLuint vs, fs;
+  GLint ok = GL_FALSE;
+
+#ifdef ANDROID
+  if(extensions && strstr(extensions, "GL_OES_standard_derivatives"))
+    header = "#extension GL_OES_standard_derivatives : enable\n"
+      "#define DERIVATIVES\n"
+      "precision mediump float;\n";
+  else
+    header = "precision mediump float;\n";
+#else
+  const char *version = (const char*) glGetString(GL_VERSION);
+
+  /* glCreateShader and friends are core since 2.0 */
+  if(version == NULL || version[0] < '2')
+    return 0;
+  header = "#version 110\n#define DERIVATIVES\n";
+  (void) extensions;
+#endif
+
+  vs = compileFloorShader(GL_VERTEX_SHADER, "", vertexSource);
+  if(vs == 0)
+    return 0;
+  fs = compileFloorShader(GL_FRAGMENT_SHADER, header, fragmentSource);
+  if(fs == 0) {
+    glDeleteShader(vs);
+    return 0;
+  }
+
+  program = glCreateProgram();
+#ifdef ANDROID
+  glBindAttribLocation(program, 0, "position");
+#endif
+  glAttachShader(program, vs);
+  glAttachShader(program, fs);
+  glLinkProgram(program);
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+  glGetProgramiv(program, GL_LINK_STATUS, &ok);
+  if(!ok) {
+    char log[512];
+    glGetProgramInfoLog(program, sizeof(log), NULL, log);
+    LOGE("floor shader: %s\n", log);
+    glDeleteProgram(program);
+    program = 0;
+    return 0;
+  }
+
+  u_textured = glGetUniformLocation(program, "textured");
+  u_spacing = glGetUniformLocation(program, "spacing");
+  u_lineColor = glGetUniformLocation(program, "lineColor");
+  u_fade = glGetUniformLocation(program, "fade");
+  u_pixel = glGetUniformLocation(program, "pixel");
+  u_texture = glGetUniformLocation(program, "floorTexture");
+#ifdef ANDROID
+  u_proj = glGetUniformLocation(program, "projectionMatrix");
+  u_view = glGetUniformLocation(program, "viewMatrix");
+#endif
+  return 1;
+}
+
+int drawShaderFloor(int textured, GLuint texture, float spacing) {
+  GLfloat proj[16];
+  GLint viewport[4];
+  float far;
+#ifdef ANDROID
+  GLfloat view[16];
+  static const GLfloat quad[] = {
+    0, 0, 0,   GSIZE, 0, 0,   GSIZE, GSIZE, 0,   0, GSIZE, 0
+  };
+#endif
+
+  if(failed)
+    return 0;
+  if(program == 0 && !createFloorProgram()) {
+    LOGI("no floor shader, drawing the floor as geometry\n");
+    failed = 1;
+    return 0;
+  }
+
+#ifdef ANDROID
+  /* the floor is drawn in the unified shader's space */
+  if(!getShadowMatrix(MATRIX_PROJECTION, proj) ||
+     !getShadowMatrix(MATRIX_VIEW, view))
+    return 0;
+#else
+  glGetFloatv(GL_PROJECTION_MATRIX, proj);
+#endif
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+#ifdef ANDROID
+  useShaderProgram(program);
+  glUniformMatrix4fv(u_proj, 1, GL_FALSE, proj);
+  glUniformMatrix4fv(u_view, 1, GL_FALSE, view);
+#else
+  glUseProgram(program);
+#endif
+  /* fade out over the far part of the view volume */
+  far = proj[14] / (proj[10] + 1);
+  glUniform2f(u_fade, far * 0.6f, far);
+  /* world size of a pixel at distance 1 */
+  glUniform1f(u_pixel, 2.0f / (proj[5] * (viewport[3] > 0 ? viewport[3] : 1)));
+  glUniform1f(u_spacing, spacing);
+  glUniform1f(u_textured, textured ? 1.0f : 0.0f);
+  if(textured) {
+    setActiveTexture(GL_TEXTURE0);
+    bindTexture2D(texture);
+    glUniform1i(u_texture, 0);
+  } else {
+    glUniform4f(u_lineColor, 0.0f, 0.0f, 1.0f, 1.0f);
+    setBlend(1);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  }
+
+#ifdef ANDROID
+  if(quad_vbo == 0) {
+    glGenBuffers(1, &quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    memGpuObject(MEM_GPU_BUFFER, quad_vbo, sizeof(quad));
+  } else
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  glDisableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+#else
+  glBegin(GL_QUADS);
+  glVertex2f(0, 0);
+  glVertex2f(GSIZE, 0);
+  glVertex2f(GSIZE, GSIZE);
+  glVertex2f(0, GSIZE);
+  glEnd();
+  glUseProgram(0);
+#endif
+  polycount += 2;
+
+  if(!textured && game->settings->show_alpha != 1)
+    setBlend(0);
+  return 1;
+}
+#endif
@@ -1,15 +1,16 @@
 #include "fonttex.h"
+#include "pack.h"
+#include "memstat.h"
 #include <string.h>
 
 #ifdef ANDROID
 #include <GLES2/gl2.h>
-#include "shaders.h"
 #else
 #include <GL/gl.h>
 #endif
+#include "shaders.h"
 
 #define FTX_ERR "[fonttex error]: "
-extern char *getFullPath(char*);
 
 void getLine(char *buf, int size, FILE *f) {
   do {
@@ -17,8 +18,15 @@ void getLine(char *buf, int size, FILE *f) {
   } while( buf[0] == '\n' || buf[0] == '#');
 }
 
+/* glyph pages count as fonts rather than textures */
+static void accountPage(sgi_texture *page, int sign) {
+  ptrdiff_t bytes = sizeof(sgi_texture) +
+    (ptrdiff_t) page->width * page->height * page->channels;
+  memAccount(MEM_TEXTURE, -sign * bytes);
+  memAccount(MEM_FONT, sign * bytes);
+}
+
 fonttex *ftxLoadFont(char *filename) {
-  char *path;
   FILE *file;
   char buf[100];
   char texname[100];
@@ -26,20 +34,11 @@ fonttex *ftxLoadFont(char *filename) {
 
   fonttex *ftx;
 
-  path = (char*)getFullPath(filename);  // Explicit cast
-  if(path == 0) {
-    fprintf(stderr, FTX_ERR "can't load font file '%s'\n", filename);
-    return 0;
-  }
-
-  file = fopen(path, "rb");
+  file = openAsset(filename);
   if(!file) {
-    fprintf(stderr, FTX_ERR "fopen failed for font '%s'\n", filename);
-    perror(FTX_ERR "fopen");
-    free(path);
+    fprintf(stderr, FTX_ERR "can't load font file '%s'\n", filename);
     return 0;
   }
-  free(path);
 
   // TODO(5): check for EOF errors in the following code
 
@@ -66,20 +65,6 @@ fonttex *ftxLoadFont(char *filename) {
         texname[--L] = '\0';
       }
     }
-    // resolve the parsed texture filename, not the .ftx file name
-    path = (char*)getFullPath(texname);  // Explicit cast
-    if(path == 0) {
-      // clean up allocated memory & spit out error
-      int j;
-      for(j = 0; j < i; j++)
-        unload_sgi_texture(*(ftx->textures + j));
-      free(ftx->textures);
-      free(ftx->fontname);
-      free(ftx);
-      fprintf(stderr, FTX_ERR "can't resolve texture file '%s'\n", texname);
-      fclose(file);
-      return 0;
-    }
     // sanity check: avoid passing .ftx here
     {
       const char *dot = strrchr(texname, '.');
@@ -88,27 +73,32 @@ fonttex *ftxLoadFont(char *filename) {
       }
       fprintf(stderr, "[fonttex] loading texture '%s'\n", texname);
     }
-    *(ftx->textures + i) = load_sgi_texture(path);
-    free(path);
+    *(ftx->textures + i) = load_sgi_texture(texname);
     if(!*(ftx->textures + i)) {
       int j;
       fprintf(stderr, FTX_ERR "Failed to load texture '%s' listed in font file '%s'\n", texname, filename);
-      for(j = 0; j < i; j++)
+      for(j = 0; j < i; j++) {
+        accountPage(*(ftx->textures + j), -1);
         unload_sgi_texture(*(ftx->textures + j));
+      }
       free(ftx->textures);
       free(ftx->fontname);
       free(ftx);
       fclose(file);
       return 0;
     }
+    accountPage(*(ftx->textures + i), 1);
   }
+  fclose(file);
   return ftx;
 }
 
 void ftxUnloadFont(fonttex *ftx) {
   int i;
-  for(i = 0; i < ftx->nTextures; i++)
+  for(i = 0; i < ftx->nTextures; i++) {
+    accountPage(*(ftx->textures + i), -1);
     unload_sgi_texture(*(ftx->textures + i));
+  }
   free(ftx->textures);
   free(ftx->texID);
   free(ftx->fontname);
@@ -117,32 +107,46 @@ void ftxUnloadFont(fonttex *ftx) {
 
 void ftxEstablishTexture(fonttex *ftx, unsigned char setupMipmaps) {
     /* TODO(1): add support for mipmaps */
+    /* all glyph pages are stacked vertically into a single atlas, so a */
+    /* string (or a whole frame of text) never has to switch textures */
     int i;
+    int pw, ph;
+    unsigned char *atlas;
 
-    ftx->texID = (unsigned int*) malloc(ftx->nTextures * sizeof(unsigned int));
-    glGenTextures(ftx->nTextures, ftx->texID);
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    pw = (*(ftx->textures))->width;
+    ph = (*(ftx->textures))->height;
+    atlas = (unsigned char*) calloc(pw * ph * ftx->nTextures, 4);
     for(i = 0; i < ftx->nTextures; i++) {
-        glBindTexture(GL_TEXTURE_2D, ftx->texID[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                     (*(ftx->textures + i))->width, (*(ftx->textures + i))->height,
-                     0, GL_RGBA, GL_UNSIGNED_BYTE,
-                     (*(ftx->textures + i))->data);
-        // Removed glTexEnvi calls
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // Changed from GL_CLAMP
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);  // Changed from GL_CLAMP
+        sgi_texture *page = *(ftx->textures + i);
+        if(page->width != pw || page->height != ph || page->channels != 4) {
+            fprintf(stderr, FTX_ERR "glyph page %d of font '%s' doesn't match "
+                    "page 0, leaving it blank\n", i, ftx->fontname);
+            continue;
+        }
+        memcpy(atlas + i * pw * ph * 4, page->data, pw * ph * 4);
     }
+
+    ftx->texID = (unsigned int*) malloc(sizeof(unsigned int));
+    glGenTextures(1, ftx->texID);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bindTexture2D(ftx->texID[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pw, ph * ftx->nTextures,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas);
+    memGpuObject(MEM_GPU_TEXTURE, ftx->texID[0],
+                 (size_t) pw * ph * ftx->nTextures * 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    free(atlas);
 }
 
-void ftxRenderString(fonttex *ftx, char *string, int len) {
-    int i;
-    int bound = -1;
+/* atlas texture coordinates of character c, returns 0 if there's no glyph */
+static int ftxGlyphCoords(fonttex *ftx, char c,
+                          float *s0, float *t0, float *s1, float *t1) {
     int index;
-
-    int tex;
+    int page;
     int w;
     float cw;
     float cx, cy;
@@ -151,14 +155,33 @@ void ftxRenderString(fonttex *ftx, char *string, int len) {
     if (w <= 0) w = 1;
     cw = (float)ftx->width / (float)ftx->texwidth;
 
+    index = c - ftx->lower + 1;
+    if(index < 0 || index >= ftx->upper)
+        return 0;
+    page = index / (w * w);
+    if(page >= ftx->nTextures)
+        return 0;
+
+    index = index % (w * w);
+    cx = (float)(index % w) / (float)w;
+    cy = (float)(index / w) / (float)w;
+
+    *s0 = cx;
+    *s1 = cx + cw;
+    *t0 = (page + 1 - cy - cw) / ftx->nTextures;
+    *t1 = (page + 1 - cy) / ftx->nTextures;
+    return 1;
+}
+
+void ftxRenderString(fonttex *ftx, char *string, int len) {
+    int i;
+    float s0, t0, s1, t1;
+
 #ifdef ANDROID
     GLuint sp = shader_get_basic();
     if (!sp) return;
     useShaderProgram(sp);
     setColor(sp, 1.0f, 1.0f, 1.0f, 1.0f);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, (ftx && ftx->texID) ? ftx->texID[0] : 0);
     setTexture(sp, 0);
 
     GLint positionLoc = glGetAttribLocation(sp, "position");
@@ -171,31 +194,16 @@ void ftxRenderString(fonttex *ftx, char *string, int len) {
     GLfloat texCoords[8];
 #endif
 
-    /* Ensure texture is bound */
-    glActiveTexture(GL_TEXTURE0);
+    setActiveTexture(GL_TEXTURE0);
     if (ftx && ftx->texID) {
-        glBindTexture(GL_TEXTURE_2D, ftx->texID[0]);
+        bindTexture2D(ftx->texID[0]);
     }
 
     for(i = 0; i < len; i++) {
-        /* find out which texture it's in */
-        index = string[i] - ftx->lower + 1;
-        if(index >= ftx->upper) {
+        if(!ftxGlyphCoords(ftx, string[i], &s0, &t0, &s1, &t1)) {
             fprintf(stderr, FTX_ERR " index out of bounds");
             continue;
         }
-        tex = index / (w * w);
-
-        /* bind texture */
-        if(tex != bound) {
-            glBindTexture(GL_TEXTURE_2D, ftx->texID[tex]);
-            bound = tex;
-        }
-
-        /* find texture coordinates */
-        index = index % (w * w);
-        cx = (float)(index % w) / (float)w;
-        cy = (float)(index / w) / (float)w;
 
 #ifdef ANDROID
         /* Unit quad; caller scales via model matrix */
@@ -204,10 +212,10 @@ void ftxRenderString(fonttex *ftx, char *string, int len) {
         vertices[4] = (float)i + 1; vertices[5] = 1.0f;
         vertices[6] = (float)i;     vertices[7] = 1.0f;
 
-        texCoords[0] = cx; texCoords[1] = 1 - cy - cw;
-        texCoords[2] = cx + cw; texCoords[3] = 1 - cy - cw;
-        texCoords[4] = cx + cw; texCoords[5] = 1 - cy;
-        texCoords[6] = cx; texCoords[7] = 1 - cy;
+        texCoords[0] = s0; texCoords[1] = t0;
+        texCoords[2] = s1; texCoords[3] = t0;
+        texCoords[4] = s1; texCoords[5] = t1;
+        texCoords[6] = s0; texCoords[7] = t1;
 
         glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE, 0, vertices);
         glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
@@ -215,13 +223,13 @@ void ftxRenderString(fonttex *ftx, char *string, int len) {
 #else
         // For desktop, use immediate mode with unit quad
         glBegin(GL_QUADS);
-        glTexCoord2f(cx, 1 - cy - cw);
+        glTexCoord2f(s0, t0);
         glVertex2f(i, 0);
-        glTexCoord2f(cx + cw, 1 - cy - cw);
+        glTexCoord2f(s1, t0);
         glVertex2f(i + 1, 0);
-        glTexCoord2f(cx + cw, 1 - cy);
+        glTexCoord2f(s1, t1);
         glVertex2f(i + 1, 1);
-        glTexCoord2f(cx, 1 - cy);
+        glTexCoord2f(s0, t1);
         glVertex2f(i, 1);
         glEnd();
 #endif
@@ -232,3 +240,191 @@ void ftxRenderString(fonttex *ftx, char *string, int len) {
     glDisableVertexAttribArray(texCoordLoc);
 #endif
 }
+
+/* text batching: strings are collected as quads in window coordinates */
+/* (origin bottom left) and drawn with the atlas in ftxBatchFlush */
+
+typedef struct {
+    float x, y;
+    float s, t;
+    float r, g, b, a;
+} ftxVertex;
+
+static ftxVertex ftx_batch[FTX_BATCH_MAX * 4];
+static int ftx_batch_glyphs = 0;
+static float ftx_batch_color[4] = { 1.0, 1.0, 1.0, 1.0 };
+static int ftx_batch_x = 0, ftx_batch_y = 0;
+
+void ftxBatchColor(float r, float g, float b, float a) {
+    ftx_batch_color[0] = r;
+    ftx_batch_color[1] = g;
+    ftx_batch_color[2] = b;
+    ftx_batch_color[3] = a;
+}
+
+void ftxBatchOrigin(int x, int y) {
+    ftx_batch_x = x;
+    ftx_batch_y = y;
+}
+
+int ftxBatchString(fonttex *ftx, float x, float y, float size,
+                   const char *string, int len) {
+    int i, j;
+    int added = 0;
+    float s0, t0, s1, t1;
+    ftxVertex *v;
+
+    if(ftx == NULL || string == NULL)
+        return 0;
+
+    x += ftx_batch_x;
+    y += ftx_batch_y;
+    for(i = 0; i < len && ftx_batch_glyphs < FTX_BATCH_MAX; i++) {
+        if(!ftxGlyphCoords(ftx, string[i], &s0, &t0, &s1, &t1))
+            continue;
+
+        v = ftx_batch + ftx_batch_glyphs * 4;
+        v[0].x = x + i * size;       v[0].y = y;
+        v[0].s = s0;                 v[0].t = t0;
+        v[1].x = x + (i + 1) * size; v[1].y = y;
+        v[1].s = s1;                 v[1].t = t0;
+        v[2].x = x + (i + 1) * size; v[2].y = y + size;
+        v[2].s = s1;                 v[2].t = t1;
+        v[3].x = x + i * size;       v[3].y = y + size;
+        v[3].s = s0;                 v[3].t = t1;
+        for(j = 0; j < 4; j++) {
+            v[j].r = ftx_batch_color[0];
+            v[j].g = ftx_batch_color[1];
+            v[j].b = ftx_batch_color[2];
+            v[j].a = ftx_batch_color[3];
+        }
+        ftx_batch_glyphs++;
+        added++;
+    }
+    return added;
+}
+
+int ftxBatchFlush(fonttex *ftx, int width, int height) {
+    int n = ftx_batch_glyphs;
+    int draws = 0;
+
+    ftx_batch_glyphs = 0;
+    ftx_batch_x = ftx_batch_y = 0;
+    if(n == 0 || ftx == NULL || ftx->texID == NULL)
+        return 0;
+
+#ifdef ANDROID
+    {
+        /* the basic shader only has a color uniform, so each run of */
+        /* glyphs sharing a color is one draw */
+        static GLushort indices[FTX_BATCH_MAX * 6];
+        static int indices_ready = 0;
+        int i, j;
+        GLuint sp;
+        GLint positionLoc, texCoordLoc;
+        GLfloat proj[16] = {
+            2.0f / (GLfloat)width, 0.0f, 0.0f, 0.0f,
+            0.0f, 2.0f / (GLfloat)height, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            -1.0f, -1.0f, 0.0f, 1.0f
+        };
+        GLfloat identity[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+
+        if(!indices_ready) {
+            for(i = 0; i < FTX_BATCH_MAX; i++) {
+                indices[i * 6]     = i * 4;
+                indices[i * 6 + 1] = i * 4 + 1;
+                indices[i * 6 + 2] = i * 4 + 2;
+                indices[i * 6 + 3] = i * 4;
+                indices[i * 6 + 4] = i * 4 + 2;
+                indices[i * 6 + 5] = i * 4 + 3;
+            }
+            indices_ready = 1;
+        }
+
+        sp = shader_get_basic();
+        if(!sp) return 0;
+        useShaderProgram(sp);
+        setRenderMode2D(sp, 1);
+        setProjectionMatrix(sp, proj);
+        setViewMatrix(sp, identity);
+        setModelMatrix(sp, identity);
+
+        glViewport(0, 0, width, height);
+        setDepthTest(0);
+        setBlend(1);
+        setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        setActiveTexture(GL_TEXTURE0);
+        bindTexture2D(ftx->texID[0]);
+        setTexture(sp, 0);
+
+        positionLoc = glGetAttribLocation(sp, "position");
+        texCoordLoc = glGetAttribLocation(sp, "texCoord");
+        if(positionLoc < 0 || texCoordLoc < 0) return 0;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glEnableVertexAttribArray(positionLoc);
+        glEnableVertexAttribArray(texCoordLoc);
+        glVertexAttribPointer(positionLoc, 2, GL_FLOAT, GL_FALSE,
+                              sizeof(ftxVertex), &ftx_batch[0].x);
+        glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE,
+                              sizeof(ftxVertex), &ftx_batch[0].s);
+
+        for(i = 0; i < n; i = j) {
+            ftxVertex *c = ftx_batch + i * 4;
+            for(j = i + 1; j < n; j++) {
+                ftxVertex *o = ftx_batch + j * 4;
+                if(o->r != c->r || o->g != c->g || o->b != c->b || o->a != c->a)
+                    break;
+            }
+            setColor(sp, c->r, c->g, c->b, c->a);
+            glDrawElements(GL_TRIANGLES, (j - i) * 6, GL_UNSIGNED_SHORT,
+                           indices + i * 6);
+            draws++;
+        }
+
+        glDisableVertexAttribArray(positionLoc);
+        glDisableVertexAttribArray(texCoordLoc);
+        setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+#else
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT |
+                 GL_TRANSFORM_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0f, (GLfloat) width, 0.0f, (GLfloat) height, 0.0f, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_FOG);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, ftx->texID[0]);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(ftxVertex), &ftx_batch[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(ftxVertex), &ftx_batch[0].s);
+    glColorPointer(4, GL_FLOAT, sizeof(ftxVertex), &ftx_batch[0].r);
+    glDrawArrays(GL_QUADS, 0, n * 4);
+    draws++;
+
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    glPopClientAttrib();
+    glPopAttrib();
+#endif
+    return draws;
+}
@@ -26,7 +26,7 @@ typedef struct fonttex {
   int lower; /* lowest ascii character (normally: 32) */
   int upper; /* highest ascii character (normally: 126) */
 
-  unsigned int *texID;
+  unsigned int *texID; /* texID[0]: all glyph pages packed into one atlas */
 
   char *fontname;
 } fonttex;
@@ -47,6 +47,24 @@ void ftxEstablishTexture(fonttex *ftx,	unsigned char setupMipmaps);
 
 extern void ftxRenderString(fonttex *ftx, char *string, int len);
 
+/* text batching: queue strings during a frame, then draw all of them */
+/* with the atlas texture in as few calls as possible */
+
+#define FTX_BATCH_MAX 4096 /* glyphs per frame, further text is dropped */
+
+/* color and window offset for the following ftxBatchString calls */
+extern void ftxBatchColor(float r, float g, float b, float a);
+extern void ftxBatchOrigin(int x, int y);
+
+/* queues len characters as size x size quads at (x, y), returns the */
+/* number of glyphs added */
+extern int ftxBatchString(fonttex *ftx, float x, float y, float size,
+                          const char *string, int len);
+
+/* draws the queued text in a width x height pixel window and empties */
+/* the batch, returns the number of draw calls used */
+extern int ftxBatchFlush(fonttex *ftx, int width, int height);
+
 /* extern void ftxGetStringWidth(fontTex *ftx, */
 /*                               char *string, int len, int *width); */
 /* can't get max_ascent, max_descent yet */
@@ -0,0 +1,174 @@
+/*
+  frame scheduler
+
+  Frames are due every 1000 / frame_rate ms. Until then the main thread
+  sleeps; the OS sleep is only trusted up to the last fraction of a
+  millisecond, the rest is waited out yielding the CPU. With vsync on
+  the swap blocks until the display refresh, so we only sleep until
+  half a period before the deadline and let the swap line the frame up.
+
+  The measured frame times jitter with the scheduler and the driver;
+  the game gets an average instead, with whatever the average didn't
+  hand out paid back over the next frames so game time keeps up with
+  the clock.
+*/
+
+#include "gltron.h"
+
+#ifdef WIN32
+#include <windows.h>
+#include <mmsystem.h>
+/* Sleep() is only good to the 1 ms timer period set in frameInit() */
+#define FRAME_SPIN_MS 2.0
+#else
+#include <sched.h>
+#include <time.h>
+#define FRAME_SPIN_MS 0.5
+#endif
+
+#ifdef ANDROID
+#include <EGL/egl.h>
+#elif defined(__APPLE__)
+#include <OpenGL/OpenGL.h>
+#elif !defined(WIN32)
+#include <GL/glx.h>
+#endif
+
+/* frame times above this are stalls (loading, debugger), not jitter */
+#define FRAME_MAX_MS 100.0
+
+static double next = 0; /* when the next frame is due */
+static double average = 0;
+static double owed = 0;
+
+double frameClock(void) {
+#ifdef WIN32
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER now;
+  if(frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&now);
+  return now.QuadPart * 1000.0 / frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static double framePeriod(void) {
+  int rate = game->settings->frame_rate;
+  return rate > 0 ? 1000.0 / rate : 0;
+}
+
+/* when the scheduler has to be awake for the next frame */
+static double frameWake(void) {
+  return game->settings->vsync ? next - framePeriod() / 2 : next;
+}
+
+static void sleepUntil(double when) {
+  double left = when - frameClock();
+
+  if(left > FRAME_SPIN_MS) {
+#ifdef WIN32
+    Sleep((DWORD) (left - FRAME_SPIN_MS));
+#else
+    struct timespec ts;
+    left -= FRAME_SPIN_MS;
+    ts.tv_sec = (time_t) (left / 1000);
+    ts.tv_nsec = (long) ((left - ts.tv_sec * 1000.0) * 1000000);
+    nanosleep(&ts, NULL);
+#endif
+  }
+  while(frameClock() < when) {
+#ifdef WIN32
+    Sleep(0);
+#else
+    sched_yield();
+#endif
+  }
+}
+
+void frameInit(void) {
+  int interval = game->settings->vsync ? 1 : 0;
+
+#ifdef WIN32
+  {
+    typedef BOOL (WINAPI *SwapInterval)(int);
+    SwapInterval swapInterval =
+      (SwapInterval) wglGetProcAddress("wglSwapIntervalEXT");
+    static int period = 0;
+    if(swapInterval)
+      swapInterval(interval);
+    if(!period)
+      period = timeBeginPeriod(1) == TIMERR_NOERROR;
+  }
+#elif defined(ANDROID)
+  if(eglGetCurrentDisplay() != EGL_NO_DISPLAY)
+    eglSwapInterval(eglGetCurrentDisplay(), interval);
+#elif defined(__APPLE__)
+  {
+    GLint swap = interval;
+    CGLSetParameter(CGLGetCurrentContext(), kCGLCPSwapInterval, &swap);
+  }
+#else
+  {
+    /* GLX_SGI_swap_control can't turn vsync off, MESA's can */
+    int (*swapMesa)(unsigned int) = (int (*)(unsigned int))
+      glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalMESA");
+    int (*swapSgi)(int) = (int (*)(int))
+      glXGetProcAddressARB((const GLubyte*) "glXSwapIntervalSGI");
+    if(swapMesa)
+      swapMesa(interval);
+    else if(swapSgi && interval)
+      swapSgi(interval);
+  }
+#endif
+  next = 0;
+  LOGI("frame scheduler: %d fps%s\n", game->settings->frame_rate,
+       interval ? ", vsync" : "");
+}
+
+int frameTimeout(void) {
+  double left;
+
+  if(capturing || framePeriod() == 0)
+    return 0;
+  left = frameWake() - frameClock() - FRAME_SPIN_MS;
+  return left > 1 ? (int) left : 0;
+}
+
+void frameWait(void) {
+  double period = framePeriod(), now;
+
+  if(capturing || period == 0)
+    return;
+  if(next == 0)
+    next = frameClock();
+  sleepUntil(frameWake());
+
+  /* more than a frame behind: start over instead of catching up */
+  now = frameClock();
+  next += period;
+  if(next < now)
+    next = now + period;
+}
+
+double frameSmooth(double ms) {
+  double step;
+
+  if(capturing)
+    return ms;
+  if(ms > FRAME_MAX_MS || average == 0) {
+    average = ms < FRAME_MAX_MS ? ms : FRAME_MAX_MS;
+    owed = 0;
+    return ms;
+  }
+  average += (ms - average) / 8;
+  owed += ms;
+  step = average + (owed - average) / 4;
+  if(step < 0)
+    step = 0;
+  owed -= step;
+  return step;
+}
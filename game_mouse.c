@@ -22,10 +22,10 @@ static void handle_swipe(int dx, int dy) {
 
   if (dx > 0) {
     /* right */
-    turn(game->player[0].data, 1);
+    simTurn(0, 1);
   } else {
     /* left */
-    turn(game->player[0].data, 3);
+    simTurn(0, 3);
   }
 }
 
@@ -14,11 +14,11 @@ void drawGlow(Player *p, gDisplay *d, float dim);
 #ifdef ANDROID
 #include <GLES2/gl2.h>
 #include <android/log.h>
-#include "shaders.h"
 #else
 #include <GL/gl.h>
 #include <GL/glu.h>
 #endif
+#include "shaders.h"
 
 #ifndef GL_TEXTURE_WIDTH
 #define GL_TEXTURE_WIDTH 0x1000
@@ -229,6 +229,7 @@ void drawDebugTex(gDisplay *d) {
   }
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, vbo, sizeof(vertices));
 
   // Create and bind index buffer
   GLuint ibo = 0;
@@ -236,17 +237,21 @@ void drawDebugTex(gDisplay *d) {
   if (ibo == 0) {
     checkGLError("glGenBuffers for ibo");
     __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to create EBO for debug texture");
+    memGpuObject(MEM_GPU_BUFFER, vbo, 0);
     glDeleteBuffers(1, &vbo);
     return;
   }
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, ibo, sizeof(indices));
 
   // Use shader program
   GLuint shaderProgram = ensure_basic_shader_bound();
   if (!shaderProgram) {
     __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to bind shader for debug texture");
+    memGpuObject(MEM_GPU_BUFFER, vbo, 0);
     glDeleteBuffers(1, &vbo);
+    memGpuObject(MEM_GPU_BUFFER, ibo, 0);
     glDeleteBuffers(1, &ibo);
     return;
   }
@@ -278,12 +283,12 @@ void drawDebugTex(gDisplay *d) {
   setColor(shaderProgram, 0.0f, 1.0f, 0.0f, 1.0f); // Green color like desktop
 
   // Bind texture
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   GLuint texToUse = 0;
   
   if (game && game->screen && game->screen->texFloor > 0) {
     texToUse = game->screen->texFloor;
-    glBindTexture(GL_TEXTURE_2D, texToUse);
+    bindTexture2D(texToUse);
     __android_log_print(ANDROID_LOG_INFO, "GLTron", "Bound floor texture for debug: ID=%u", texToUse);
   } else {
     // Create a simple checkerboard pattern for debug
@@ -301,14 +306,14 @@ void drawDebugTex(gDisplay *d) {
         }
       }
       glGenTextures(1, &debugTex);
-      glBindTexture(GL_TEXTURE_2D, debugTex);
+      bindTexture2D(debugTex);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
       glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, pattern);
     }
-    glBindTexture(GL_TEXTURE_2D, debugTex);
+    bindTexture2D(debugTex);
     texToUse = debugTex;
     __android_log_print(ANDROID_LOG_INFO, "GLTron", "Created debug checkerboard texture: ID=%u", debugTex);
   }
@@ -324,7 +329,9 @@ void drawDebugTex(gDisplay *d) {
   if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  memGpuObject(MEM_GPU_BUFFER, vbo, 0);
   glDeleteBuffers(1, &vbo);
+  memGpuObject(MEM_GPU_BUFFER, ibo, 0);
   glDeleteBuffers(1, &ibo);
   
   polycount++;
@@ -348,97 +355,8 @@ void drawScore(Player *p, gDisplay *d) {
 
   sprintf(tmp, "%d", p->data->score);
   rasonly(d);
-
-#ifdef ANDROID
-  // For Android, render score text using font texture
-  GLuint shaderProgram = ensure_basic_shader_bound();
-  if (!shaderProgram) return;
-  ensure2D(shaderProgram, game->screen->vp_w, game->screen->vp_h);
-
-  // Set color (yellow like desktop)
-  setColor(shaderProgram, 1.0f, 1.0f, 0.2f, 1.0f);
-
-  // Ensure font texture exists
-  glActiveTexture(GL_TEXTURE0);
-  if (game->screen->texFont == 0) {
-    game->screen->texFont = createFontTexture();
-  }
-  glBindTexture(GL_TEXTURE_2D, game->screen->texFont);
-  setTexture(shaderProgram, 0);
-
-  // Get attribute locations once
-  GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-  GLint texCoordLoc = glGetAttribLocation(shaderProgram, "texCoord");
-
-  if (positionLoc < 0 || texCoordLoc < 0) {
-    __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to get attributes for score rendering");
-    return;
-  }
-
-  // Enable attributes for all characters
-  glEnableVertexAttribArray(positionLoc);
-  glEnableVertexAttribArray(texCoordLoc);
-
-  // Render each character of the score
-  float x = 5.0f;
-  float y = 5.0f;
-  float charSize = 32.0f; // Match desktop size
-  
-  for (int i = 0; tmp[i] != '\0'; i++) {
-    char c = tmp[i];
-    
-    // Calculate texture coordinates for this character
-    // Assuming font texture has 16x6 grid of ASCII characters (32-127)
-    if (c < 32 || c > 127) c = '?'; // Fallback for invalid chars
-    
-    int charIndex = c - 32;
-    float texX = (float)(charIndex % 16) / 16.0f;
-    float texY = (float)(charIndex / 16) / 6.0f;
-    float texW = 1.0f / 16.0f;
-    float texH = 1.0f / 6.0f;
-
-    // Create vertices for this character
-    GLfloat vertices[] = {
-      // Position (x,y,z)         // TexCoord (u,v)
-      x,            y,            0.0f,   texX,        texY,
-      x + charSize, y,            0.0f,   texX + texW, texY,
-      x + charSize, y + charSize, 0.0f,   texX + texW, texY + texH,
-      x,            y + charSize, 0.0f,   texX,        texY + texH
-    };
-
-    // Create and bind vertex buffer for this character
-    GLuint vbo = 0;
-    glGenBuffers(1, &vbo);
-    if (vbo == 0) {
-      checkGLError("glGenBuffers for score char");
-      continue;
-    }
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Set up vertex attributes
-    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
-    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-    // Draw this character
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-    // Clean up buffer for this character
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDeleteBuffers(1, &vbo);
-
-    // Move to next character position (with some spacing)
-    x += charSize * 0.8f; // Slightly overlap for better spacing
-  }
-
-  // Disable attributes after all characters are drawn
-  glDisableVertexAttribArray(positionLoc);
-  glDisableVertexAttribArray(texCoordLoc);
-#else
-  // For desktop OpenGL
-  glColor4f(1.0, 1.0, 0.2, 1.0);
+  setTextColor(1.0, 1.0, 0.2, 1.0);
   drawText(5, 5, 32, tmp);
-#endif
 }
   
 void drawFloor(gDisplay *d) {
@@ -451,21 +369,20 @@ void drawFloor(gDisplay *d) {
             return;
         }
 
+        // One quad, tiled in the fragment shader
+        if (drawShaderFloor(1, game->screen->texFloor, (float)(GSIZE / 4) / 5))
+            return;
+
         GLuint shaderProgram = ensure_basic_shader_bound();
         if (!shaderProgram) return;
         ensure3D(shaderProgram);
         setIdentityMatrix(shaderProgram, MATRIX_MODEL);
 
         // Setup texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, game->screen->texFloor);
+        setActiveTexture(GL_TEXTURE0);
+        bindTexture2D(game->screen->texFloor);
         setTexture(shaderProgram, 0);
-
-        // Set texture parameters for proper rendering
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        /* filtering and wrap modes are set once in initTexture() */
 
         // Set lighting uniforms
         setAmbientLight(shaderProgram, 0.2f, 0.2f, 0.2f);
@@ -526,11 +443,13 @@ void drawFloor(gDisplay *d) {
             }
             glBindBuffer(GL_ARRAY_BUFFER, floor_vbo);
             glBufferData(GL_ARRAY_BUFFER, floor_quad_count * 4 * 5 * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+            memGpuObject(MEM_GPU_BUFFER, floor_vbo, floor_quad_count * 4 * 5 * sizeof(GLfloat));
 
             // Create EBO
             glGenBuffers(1, &floor_ebo);
             if (floor_ebo == 0) {
                 __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to create floor EBO");
+                memGpuObject(MEM_GPU_BUFFER, floor_vbo, 0);
                 glDeleteBuffers(1, &floor_vbo);
                 floor_vbo = 0;
                 free(vertices);
@@ -539,6 +458,7 @@ void drawFloor(gDisplay *d) {
             }
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, floor_ebo);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, floor_index_count * sizeof(GLushort), indices, GL_STATIC_DRAW);
+            memGpuObject(MEM_GPU_BUFFER, floor_ebo, floor_index_count * sizeof(GLushort));
 
             glBindBuffer(GL_ARRAY_BUFFER, 0);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -604,35 +524,48 @@ void drawFloor(gDisplay *d) {
             return;
         }
 
-        // Set texture parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // One quad, tiled in the fragment shader
+        if (drawShaderFloor(1, game->screen->texFloor, (float)(GSIZE / 4) / 5)) {
+            glDisable(GL_TEXTURE_2D);
+            return;
+        }
 
         glColor4f(1.0, 1.0, 1.0, 1.0);
         
         l = GSIZE / 4;
         t = 5;
-        
-        for(j = 0; j < GSIZE; j += l) {
-            for(k = 0; k < GSIZE; k += l) {
-                glBegin(GL_QUADS);
-                glNormal3f(0.0f, 0.0f, 1.0f);
-                glTexCoord2f(0.0f, 0.0f); glVertex3f(j, k, 0.0f);
-                glTexCoord2f(t, 0.0f);    glVertex3f(j + l, k, 0.0f);
-                glTexCoord2f(t, t);       glVertex3f(j + l, k + l, 0.0f);
-                glTexCoord2f(0.0f, t);    glVertex3f(j, k + l, 0.0f);
-                glEnd();
-                polycount++;
+
+        // The floor is static, build its quads once and draw them as an array
+        static GLfloat floor_quads[(GSIZE / (GSIZE / 4)) * (GSIZE / (GSIZE / 4)) * 4 * 5];
+        static int floor_quad_count = 0;
+
+        if (floor_quad_count == 0) {
+            GLfloat *v = floor_quads;
+            for(j = 0; j < GSIZE; j += l) {
+                for(k = 0; k < GSIZE; k += l) {
+                    *v++ = 0.0f; *v++ = 0.0f; *v++ = j;     *v++ = k;     *v++ = 0.0f;
+                    *v++ = t;    *v++ = 0.0f; *v++ = j + l; *v++ = k;     *v++ = 0.0f;
+                    *v++ = t;    *v++ = t;    *v++ = j + l; *v++ = k + l; *v++ = 0.0f;
+                    *v++ = 0.0f; *v++ = t;    *v++ = j;     *v++ = k + l; *v++ = 0.0f;
+                    floor_quad_count++;
+                }
             }
         }
+
+        glNormal3f(0.0f, 0.0f, 1.0f);
+        glInterleavedArrays(GL_T2F_V3F, 0, floor_quads);
+        glDrawArrays(GL_QUADS, 0, floor_quad_count * 4);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        polycount += floor_quad_count;
         
         glDisable(GL_TEXTURE_2D);
 #endif
         
     } else {
-        // Line floor
+        // Line floor, generated in the fragment shader if possible
+        if (drawShaderFloor(0, 0, game->settings->line_spacing))
+            return;
 #ifdef ANDROID
         GLuint shaderProgram = ensure_basic_shader_bound();
         if (!shaderProgram) return;
@@ -645,10 +578,10 @@ void drawFloor(gDisplay *d) {
         setLightPosition(shaderProgram, 1.0f, 1.0f, 1.0f);
 
         // Bind white texture for solid color rendering
-        glActiveTexture(GL_TEXTURE0);
+        setActiveTexture(GL_TEXTURE0);
         static GLuint s_white = 0;
         if (s_white == 0) s_white = createWhiteTexture();
-        glBindTexture(GL_TEXTURE_2D, s_white);
+        bindTexture2D(s_white);
         setTexture(shaderProgram, 0);
 
         // Static buffers for line floor to avoid repeated allocation
@@ -693,6 +626,7 @@ void drawFloor(gDisplay *d) {
             }
             glBindBuffer(GL_ARRAY_BUFFER, line_vbo);
             glBufferData(GL_ARRAY_BUFFER, line_vertex_count * 3 * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+            memGpuObject(MEM_GPU_BUFFER, line_vbo, line_vertex_count * 3 * sizeof(GLfloat));
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
             free(vertices);
@@ -741,197 +675,350 @@ void drawFloor(gDisplay *d) {
     }
 }
 
-void drawTraces(Player *p, gDisplay *d, int instance) {
-  line *line;
-  float height;
+/* Trail walls and the quads behind each cycle look the same from every
+ * camera, so they are built once per frame by prepareWorld() into a single
+ * vertex array and each viewport only replays ranges of it. */
+#define WORLD_STRIDE 7 /* x, y, z, r, g, b, a */
+
+/* The arena is split into TRAIL_GRID x TRAIL_GRID cells. Every trail
+ * segment remembers the block of cells it crosses, so a viewport only has
+ * to classify the cells against its view to reject segments. */
+#define TRAIL_GRID 8
+#define TRAIL_CELL ((float)GSIZE / TRAIL_GRID)
+
+typedef struct {
+  int trail_first;   /* trail wall triangle strip */
+  int trail_count;
+  int trail_segments;
+  int head_first;    /* floor marker under the newest segment, -1 if none */
+  int quad_first;    /* fading quad behind the cycle, -1 if none */
+} WorldRanges;
+
+static GLfloat *world_verts = NULL; /* in frame_arena */
+static int world_count = 0;
+static WorldRanges world_ranges[MAX_PLAYERS];
+static unsigned char trail_cells[MAX_PLAYERS][MAX_TRAIL][4]; /* x0 y0 x1 y1 */
+static unsigned char cell_visible[TRAIL_GRID][TRAIL_GRID];
+
+/* segments further than this from the eye are drawn without blending */
+#define TRAIL_LOD_DIST (GSIZE / 2)
+static float trail_eye[2];
+#ifdef ANDROID
+static GLuint world_vbo = 0;
+#endif
+static RenderBuffer world_buffer = { NULL, 0, WORLD_STRIDE };
 
-  Data *data;
-  data = p->data;
-  height = data->trail_height;
-  if(height > 0) {
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+static int trailCell(float v) {
+  int c = (int)(v / TRAIL_CELL);
+  if(c < 0) return 0;
+  if(c >= TRAIL_GRID) return TRAIL_GRID - 1;
+  return c;
+}
 
-#ifdef ANDROID
-    // For Android, use vertex buffers with unified shader helpers
-    // Count the number of trail segments
-    int segmentCount = 0;
-    line = &(data->trails[0]);
-    while(line != data->trail) {
-      segmentCount++;
-      line++;
-    }
-    
-    // Need at least one segment to draw
-    if (segmentCount == 0) {
-      return;
-    }
-    
-    // For a triangle strip, we need 2 vertices per point (bottom and top)
-    // First segment needs 2 points (start and end), each additional segment adds 1 point
-    int vertexCount = (segmentCount + 1) * 2; // (segments + 1) points * 2 (top and bottom)
-    GLfloat *vertices = (GLfloat *)malloc(vertexCount * 3 * sizeof(GLfloat));
-    if (!vertices) {
-      __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to allocate memory for trace vertices");
-      return;
-    }
-    
-    int vIndex = 0;
-    
-    // Start with the first segment's start point
-    line = &(data->trails[0]);
-    vertices[vIndex++] = line->sx;
-    vertices[vIndex++] = line->sy;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = line->sx;
-    vertices[vIndex++] = line->sy;
-    vertices[vIndex++] = height;
-    
-    // Add all segment endpoints
-    while(line != data->trail) {
-      vertices[vIndex++] = line->ex;
-      vertices[vIndex++] = line->ey;
-      vertices[vIndex++] = 0.0f;
-      vertices[vIndex++] = line->ex;
-      vertices[vIndex++] = line->ey;
-      vertices[vIndex++] = height;
-      line++;
-      polycount++;
-    }
-    
-    // Add the final endpoint
-    vertices[vIndex++] = line->ex;
-    vertices[vIndex++] = line->ey;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = line->ex;
-    vertices[vIndex++] = line->ey;
-    vertices[vIndex++] = height;
-    polycount++;
-
-    // Use shader program consistently
-    GLuint shaderProgram = ensure_basic_shader_bound();
-    if (!shaderProgram) {
-      __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to bind shader for traces");
-      free(vertices);
-      return;
+static void binSegment(unsigned char *cells,
+                       float sx, float sy, float ex, float ey) {
+  cells[0] = trailCell(sx < ex ? sx : ex);
+  cells[1] = trailCell(sy < ey ? sy : ey);
+  cells[2] = trailCell(sx < ex ? ex : sx);
+  cells[3] = trailCell(sy < ey ? ey : sy);
+}
+
+static void worldVertex(float x, float y, float z, const float *c, float a) {
+  GLfloat *v = world_verts + WORLD_STRIDE * world_count++;
+  v[0] = x; v[1] = y; v[2] = z;
+  if(c) {
+    v[3] = c[0]; v[4] = c[1]; v[5] = c[2];
+  } else {
+    v[3] = v[4] = v[5] = 0;
+  }
+  v[6] = a;
+}
+
+/* Appends the trail of player i as one strip. Zero length segments are
+ * dropped and collinear neighbours merged, so the strip only grows with
+ * the number of turns, not with the number of entries in data->trails. */
+static void buildTrail(int i, Data *data, float *ca, WorldRanges *r) {
+  line *line;
+  float px, py, qx, qy;
+  float h = data->trail_height;
+  int pending = 0;
+
+  r->trail_first = world_count;
+  line = &(data->trails[0]);
+  px = qx = line->sx;
+  py = qy = line->sy;
+  worldVertex(px, py, 0, ca, ca[3]);
+  worldVertex(px, py, h, ca, ca[3]);
+
+  for(;;) {
+    if(line->ex != line->sx || line->ey != line->sy) {
+      /* a segment going on in the same direction extends the pending one */
+      int straight = pending &&
+        (qx - px) * (line->ey - qy) - (qy - py) * (line->ex - qx) == 0 &&
+        (qx - px) * (line->ex - qx) + (qy - py) * (line->ey - qy) > 0;
+      if(pending && !straight) {
+        binSegment(trail_cells[i][r->trail_segments++], px, py, qx, qy);
+        worldVertex(qx, qy, 0, ca, ca[3]);
+        worldVertex(qx, qy, h, ca, ca[3]);
+        px = qx;
+        py = qy;
+      }
+      qx = line->ex;
+      qy = line->ey;
+      pending = 1;
     }
-    ensure3D(shaderProgram);
+    if(line == data->trail)
+      break;
+    line++;
+  }
 
-    // Identity model matrix for world-space trails
-    setIdentityMatrix(shaderProgram, MATRIX_MODEL);
+  if(pending) {
+    binSegment(trail_cells[i][r->trail_segments++], px, py, qx, qy);
+    worldVertex(qx, qy, 0, ca, ca[3]);
+    worldVertex(qx, qy, h, ca, ca[3]);
+    r->trail_count = world_count - r->trail_first;
+  } else {
+    world_count = r->trail_first;
+  }
+}
 
-    // Bind white texture for solid color rendering
-    glActiveTexture(GL_TEXTURE0);
-    static GLuint s_white = 0;
-    if (s_white == 0) s_white = createWhiteTexture();
-    glBindTexture(GL_TEXTURE_2D, s_white);
-    setTexture(shaderProgram, 0);
-
-    // Set color from player material
-    setColor(shaderProgram, p->model->color_alpha[0], p->model->color_alpha[1], p->model->color_alpha[2], p->model->color_alpha[3]);
-
-    // Create and bind vertex buffer
-    GLuint vbo = 0;
-    glGenBuffers(1, &vbo);
-    if (vbo == 0) {
-      checkGLError("glGenBuffers");
-      __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to create VBO for traces");
-      free(vertices);
-      return;
+void prepareWorld() {
+  int i, needed;
+  Data *data;
+  WorldRanges *r;
+  float *ca;
+
+  /* worst case: a strip over every segment plus the two quads, for full
+     trails, so the frame arena doesn't have to grow along with them */
+  needed = game->players * ((MAX_TRAIL + 2) * 2 + 8);
+
+  world_verts = arenaAlloc(&frame_arena, needed * WORLD_STRIDE * sizeof(GLfloat));
+  if(!world_verts) {
+    for(i = 0; i < MAX_PLAYERS; i++) {
+      world_ranges[i].trail_count = 0;
+      world_ranges[i].quad_first = -1;
     }
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * 3 * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
+    return;
+  }
 
-    // Set up attributes
-    GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-    GLint normalLoc = glGetAttribLocation(shaderProgram, "normal");
-    
-    if (positionLoc >= 0) {
-      glEnableVertexAttribArray(positionLoc);
-      glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  world_count = 0;
+  for(i = 0; i < game->players; i++) {
+    data = game->player[i].data;
+    ca = game->player[i].model->color_alpha;
+    r = &world_ranges[i];
+    r->trail_count = 0;
+    r->trail_segments = 0;
+    r->head_first = -1;
+    r->quad_first = -1;
+    if(data->trail_height <= 0)
+      continue;
+
+    buildTrail(i, data, ca, r);
+
+    if(game->settings->camType == 1) {
+      r->head_first = world_count;
+      worldVertex(data->trail->sx - LINE_D, data->trail->sy - LINE_D, 0, ca, ca[3]);
+      worldVertex(data->trail->sx + LINE_D, data->trail->sy + LINE_D, 0, ca, ca[3]);
+      worldVertex(data->trail->ex + LINE_D, data->trail->ey + LINE_D, 0, ca, ca[3]);
+      worldVertex(data->trail->ex - LINE_D, data->trail->ey - LINE_D, 0, ca, ca[3]);
     }
-    
-    // Set a default normal for the trail walls (could be improved with proper normals)
-    if (normalLoc >= 0) {
-      glVertexAttrib3f(normalLoc, 0.0f, 0.0f, 1.0f);
+
+    /* the quad fades from the cycle colour to black along -dir */
+    {
+      float l = 5.0;
+      int dir = data->dir;
+      float x = data->posx, y = data->posy;
+      float *cm = game->player[i].model->color_model;
+
+      r->quad_first = world_count;
+      worldVertex(x, y, 0, cm, 1.0);
+      worldVertex(x - dirsX[dir] * l, y - dirsY[dir] * l, 0, NULL, 0.0);
+      worldVertex(x - dirsX[dir] * l, y - dirsY[dir] * l, data->trail_height,
+                  NULL, 0.0);
+      worldVertex(x, y, data->trail_height, cm, 1.0);
     }
+  }
 
-    // Draw the trail wall as a triangle strip
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, vertexCount);
+#ifdef ANDROID
+  if(world_vbo == 0)
+    glGenBuffers(1, &world_vbo);
+  if(world_vbo == 0) {
+    checkGLError("glGenBuffers");
+    __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to create world VBO");
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, world_vbo);
+  glBufferData(GL_ARRAY_BUFFER, world_count * WORLD_STRIDE * sizeof(GLfloat),
+               world_verts, GL_STREAM_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, world_vbo, world_count * WORLD_STRIDE * sizeof(GLfloat));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  world_buffer.vbo = world_vbo;
+#endif
+  world_buffer.verts = world_verts;
+}
 
-    // Clean up
-    if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glDeleteBuffers(1, &vbo);
-    free(vertices);
+/* state for drawing from the world buffer through the command list */
+static void worldState(RenderState *s, int blend,
+                       GLenum sfactor, GLenum dfactor) {
+  s->buffer = &world_buffer;
+#ifdef ANDROID
+  s->program = shader_get_basic();
+#else
+  s->program = 0;
+#endif
+  s->texture = 0;
+  s->blend = blend;
+  s->sfactor = sfactor;
+  s->dfactor = dfactor;
+}
 
-    if(game->settings->camType == 1) {
-      GLfloat quadVertices[] = {
-        data->trail->sx - LINE_D, data->trail->sy - LINE_D, 0.0f,
-        data->trail->sx + LINE_D, data->trail->sy + LINE_D, 0.0f,
-        data->trail->ex + LINE_D, data->trail->ey + LINE_D, 0.0f,
-        data->trail->ex - LINE_D, data->trail->ey - LINE_D, 0.0f
-      };
-
-      // Create and bind vertex buffer for quad
-      GLuint quadVbo = 0;
-      glGenBuffers(1, &quadVbo);
-      if (quadVbo == 0) {
-        checkGLError("glGenBuffers for quad");
-        return;
+/* Marks the grid cells inside the horizontal wedge seen from eye towards
+ * look. The wedge is widened for the camera pitch, and cells close to the
+ * eye are always kept since steep rays reach them from any direction. */
+static void cullTrails(float *eye, float *look, float fov, float aspect) {
+  float dx, dy, len, pitch, half, lx, ly, rx, ry;
+  float x0, y0, x1, y1, cx, cy;
+  int i, j, k, inL, inR, front;
+
+  trail_eye[0] = eye[0];
+  trail_eye[1] = eye[1];
+
+  dx = look[0] - eye[0];
+  dy = look[1] - eye[1];
+  len = sqrt(dx * dx + dy * dy);
+  half = atan(tan(fov * M_PI / 360.0) * aspect);
+  pitch = atan2(fabs(eye[2] - look[2]), len);
+  half = atan(tan(half) / cos(pitch)) + 5 * M_PI / 180.0;
+
+  if(len < 0.001 || half >= M_PI / 2) {
+    memset(cell_visible, 1, sizeof(cell_visible));
+    return;
+  }
+  dx /= len;
+  dy /= len;
+
+  /* left and right edge of the wedge */
+  lx = dx * cos(half) - dy * sin(half);
+  ly = dx * sin(half) + dy * cos(half);
+  rx = dx * cos(half) + dy * sin(half);
+  ry = -dx * sin(half) + dy * cos(half);
+
+  for(i = 0; i < TRAIL_GRID; i++)
+    for(j = 0; j < TRAIL_GRID; j++) {
+      x0 = i * TRAIL_CELL - eye[0];
+      y0 = j * TRAIL_CELL - eye[1];
+      x1 = x0 + TRAIL_CELL;
+      y1 = y0 + TRAIL_CELL;
+
+      /* distance from the eye to the cell */
+      cx = x0 > 0 ? x0 : (x1 < 0 ? -x1 : 0);
+      cy = y0 > 0 ? y0 : (y1 < 0 ? -y1 : 0);
+      if(cx * cx + cy * cy < TRAIL_CELL * TRAIL_CELL) {
+        cell_visible[i][j] = 1;
+        continue;
       }
-      glBindBuffer(GL_ARRAY_BUFFER, quadVbo);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
-      // Attribute reuse
-      if (positionLoc >= 0) {
-        glEnableVertexAttribArray(positionLoc);
-        glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+      /* culled if all four corners are outside the same edge */
+      inL = inR = front = 0;
+      for(k = 0; k < 4; k++) {
+        cx = (k & 1) ? x1 : x0;
+        cy = (k & 2) ? y1 : y0;
+        if(lx * cy - ly * cx <= 0) inL = 1;
+        if(rx * cy - ry * cx >= 0) inR = 1;
+        if(dx * cx + dy * cy > 0) front = 1;
       }
+      cell_visible[i][j] = inL && inR && front;
+    }
+}
+
+#ifdef ANDROID
+/* every cell counts as visible, used by cameras that look down */
+static void showAllTrails(float *eye) {
+  trail_eye[0] = eye[0];
+  trail_eye[1] = eye[1];
+  memset(cell_visible, 1, sizeof(cell_visible));
+}
+#endif
 
-      // Draw
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+enum { TRAIL_HIDDEN, TRAIL_NEAR, TRAIL_FAR };
+
+/* classifies segment k of player i for the current viewport */
+static int segmentLod(int i, int k) {
+  unsigned char *cells = trail_cells[i][k];
+  GLfloat *a, *b;
+  float sx, sy, px, py, t, len;
+  int x, y, seen = 0;
+
+  for(x = cells[0]; x <= cells[2] && !seen; x++)
+    for(y = cells[1]; y <= cells[3] && !seen; y++)
+      seen = cell_visible[x][y];
+  if(!seen)
+    return TRAIL_HIDDEN;
+
+  /* distance from the eye to the segment in the floor plane */
+  a = world_verts + WORLD_STRIDE * (world_ranges[i].trail_first + 2 * k);
+  b = a + 2 * WORLD_STRIDE;
+  sx = b[0] - a[0];
+  sy = b[1] - a[1];
+  px = trail_eye[0] - a[0];
+  py = trail_eye[1] - a[1];
+  len = sx * sx + sy * sy;
+  t = len > 0 ? (px * sx + py * sy) / len : 0;
+  if(t < 0) t = 0;
+  if(t > 1) t = 1;
+  px -= t * sx;
+  py -= t * sy;
+  return px * px + py * py > TRAIL_LOD_DIST * TRAIL_LOD_DIST ?
+    TRAIL_FAR : TRAIL_NEAR;
+}
 
-      // Clean up
-      if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glDeleteBuffers(1, &quadVbo);
+/* queues the trail walls of player instance, drawCam() submits them */
+void drawTraces(Player *p, gDisplay *d, int instance) {
+  WorldRanges *r = &world_ranges[instance];
+  unsigned char lod[MAX_TRAIL];
+  RenderState near, far;
+  RenderCmd *c;
+  int k, run, pass;
 
-      polycount++;
-    }
-#else
-    // For desktop OpenGL
-    glColor4fv(p->model->color_alpha);
-    line = &(data->trails[0]);
-    glBegin(GL_TRIANGLE_STRIP);
-    glVertex3f(line->sx, line->sy, 0.0);
-    glVertex3f(line->sx, line->sy, height);
-    while(line != data->trail) {
-      glVertex3f(line->ex, line->ey, 0.0);
-      glVertex3f(line->ex, line->ey, height);
-      line++;
-      polycount++;
-    }
-    glVertex3f(line->ex, line->ey, 0.0);
-    glVertex3f(line->ex, line->ey, height);
-    polycount += 2;
-    glEnd();
+  if(r->trail_count == 0)
+    return;
 
-    if(game->settings->camType == 1) {
-      //       glLineWidth(3);
-      // glBegin(GL_LINES);
-      glBegin(GL_QUADS);
-      glVertex2f(data->trail->sx - LINE_D, data->trail->sy - LINE_D);
-      glVertex2f(data->trail->sx + LINE_D, data->trail->sy + LINE_D);
-      glVertex2f(data->trail->ex + LINE_D, data->trail->ey + LINE_D);
-      glVertex2f(data->trail->ex - LINE_D, data->trail->ey - LINE_D);
-
-      glEnd();
-      // glLineWidth(1);
-      polycount++;
+  /* distant walls skip blending */
+  worldState(&near, game->settings->show_alpha == 1,
+             GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  far = near;
+  far.blend = 0;
+
+  for(k = 0; k < r->trail_segments; k++)
+    lod[k] = segmentLod(instance, k);
+
+  /* segment k covers strip vertices 2k .. 2k + 3, draw each run of
+     segments with the same detail as one piece of the strip */
+  for(pass = TRAIL_FAR; pass >= TRAIL_NEAR; pass--) {
+    run = 0;
+    for(k = 0; k <= r->trail_segments; k++) {
+      if(k < r->trail_segments && lod[k] == pass) {
+        run++;
+        continue;
+      }
+      if(run > 0) {
+        c = renderDraw(pass == TRAIL_FAR ? &far : &near, GL_TRIANGLE_STRIP,
+                       r->trail_first + 2 * (k - run), 2 * run + 2);
+        c->polys = run;
+        memcpy(c->color, p->model->color_alpha, sizeof(c->color));
+        run = 0;
+      }
     }
-#endif
+  }
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if(r->head_first >= 0) {
+#ifdef ANDROID
+    c = renderDraw(&near, GL_TRIANGLE_FAN, r->head_first, 4);
+#else
+    c = renderDraw(&near, GL_QUADS, r->head_first, 4);
+#endif
+    c->polys = 1;
+    memcpy(c->color, p->model->color_alpha, sizeof(c->color));
   }
 }
 
@@ -964,16 +1051,19 @@ void drawCrash(float radius) {
   }
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, vbo, sizeof(vertices));
 
   GLushort indices[] = {0,1,2, 0,2,3};
   GLuint ibo = 0;
   glGenBuffers(1, &ibo);
   if (ibo == 0) {
+    memGpuObject(MEM_GPU_BUFFER, vbo, 0);
     glDeleteBuffers(1, &vbo);
     return;
   }
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, ibo, sizeof(indices));
 
   // Set up attributes
   GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
@@ -1000,18 +1090,18 @@ void drawCrash(float radius) {
   setColor(shaderProgram, 1.0f, 1.0f, 1.0f, alpha);
 
   // Bind crash texture
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   if (game->screen->texCrash != 0) {
-    glBindTexture(GL_TEXTURE_2D, game->screen->texCrash);
+    bindTexture2D(game->screen->texCrash);
   } else {
     // Fallback to wall texture if crash texture not available
-    glBindTexture(GL_TEXTURE_2D, game->screen->texWall);
+    bindTexture2D(game->screen->texWall);
   }
   setTexture(shaderProgram, 0);
   
   // Enable blending for transparency
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  setBlend(1);
+  setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
   // Draw the crash explosion quad
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
@@ -1021,11 +1111,13 @@ void drawCrash(float radius) {
   if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  memGpuObject(MEM_GPU_BUFFER, vbo, 0);
   glDeleteBuffers(1, &vbo);
+  memGpuObject(MEM_GPU_BUFFER, ibo, 0);
   glDeleteBuffers(1, &ibo);
 
   // Reset blend function
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   polycount++;
 #else
@@ -1075,6 +1167,7 @@ void drawCycle(Player *p) {
   int last_dir;
   float dirangle;
   Mesh *cycle;
+  int pass;
 
 #define turn_length 500
 
@@ -1102,15 +1195,15 @@ void drawCycle(Player *p) {
   setLightPosition(prog, 1.0f, 1.0f, 1.0f);
 
   // Bind a white texture for solid color rendering
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   static GLuint s_white = 0;
   if (s_white == 0) s_white = createWhiteTexture();
-  glBindTexture(GL_TEXTURE_2D, s_white);
+  bindTexture2D(s_white);
   setTexture(prog, 0);
 
   // Enable depth testing for 3D rendering
-  glEnable(GL_DEPTH_TEST);
-  glDepthMask(GL_TRUE);
+  setDepthTest(1);
+  setDepthMask(GL_TRUE);
 
   // Build transformation matrices (equivalent to glPushMatrix/glTranslatef/glRotatef sequence)
   GLfloat modelMatrix[16];
@@ -1180,7 +1273,9 @@ void drawCycle(Player *p) {
       setModelMatrix(prog, modelMatrix);
       
       // Draw the crash explosion effect
+      pass = profilePass(PASS_EXPLOSIONS);
       drawCrash(p->data->exp_radius);
+      profilePass(pass);
       
       // Restore for cycle rendering
       memcpy(modelMatrix, savedMatrix, sizeof(modelMatrix));
@@ -1265,22 +1360,24 @@ void drawCycle(Player *p) {
     drawModel(cycle, MODEL_USE_MATERIAL, 0);
   } else if(p->data->exp_radius < EXP_RADIUS_MAX) {
     // Enable blending for transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    setBlend(1);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     float alpha = (float)(EXP_RADIUS_MAX - p->data->exp_radius) / (float)EXP_RADIUS_MAX;
     setMaterialAlphas(cycle, alpha);
+    pass = profilePass(PASS_EXPLOSIONS);
     drawExplosion(cycle, p->data->exp_radius, MODEL_USE_MATERIAL, 0);
+    profilePass(pass);
     
     // Disable blending if alpha is not globally enabled
     if(game->settings->show_alpha == 0) {
-      glDisable(GL_BLEND);
+      setBlend(0);
     }
   }
 
   // Clean up state (equivalent to desktop cleanup)
-  glDisable(GL_DEPTH_TEST);
-  glDepthMask(GL_FALSE);
+  setDepthTest(0);
+  setDepthMask(GL_FALSE);
 
   // Clean up
 #else
@@ -1307,8 +1404,11 @@ void drawCycle(Player *p) {
   glRotatef(dirangle, 0, 0.0, 1.0);
 
   if(game->settings->show_crash_texture)
-    if(p->data->exp_radius > 0 && p->data->exp_radius < EXP_RADIUS_MAX)
+    if(p->data->exp_radius > 0 && p->data->exp_radius < EXP_RADIUS_MAX) {
+      pass = profilePass(PASS_EXPLOSIONS);
       drawCrash(p->data->exp_radius);
+      profilePass(pass);
+    }
 
   if(game->settings->turn_cycle) {
     if(time < turn_length) {
@@ -1338,7 +1438,9 @@ void drawCycle(Player *p) {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     alpha = (float)(EXP_RADIUS_MAX - p->data->exp_radius) / (float)EXP_RADIUS_MAX;
     setMaterialAlphas(cycle, alpha);
+    pass = profilePass(PASS_EXPLOSIONS);
     drawExplosion(cycle, p->data->exp_radius, MODEL_USE_MATERIAL, 0);
+    profilePass(pass);
   }
 
   if(game->settings->show_alpha == 0) glDisable(GL_BLEND);
@@ -1379,14 +1481,44 @@ int playerVisible(Player *eye, Player *target) {
   else return 1;
 }
 
+/* the quads fading into the floor behind each cycle */
+static void queueQuads(void) {
+  RenderState quads;
+  RenderCmd *c;
+  int i, dir;
+
+  worldState(&quads, 1, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  for(i = 0; i < game->players; i++)
+    if(world_ranges[i].quad_first >= 0) {
+#ifdef ANDROID
+      c = renderDraw(&quads, GL_TRIANGLE_FAN, world_ranges[i].quad_first, 4);
+#else
+      c = renderDraw(&quads, GL_QUADS, world_ranges[i].quad_first, 4);
+#endif
+      c->polys = 1;
+      memcpy(c->color, game->player[i].model->color_model, 3 * sizeof(float));
+      /* lit from the player's direction */
+      dir = game->player[i].data->dir;
+      c->normal[0] = dirsX[dir];
+      c->normal[1] = dirsY[dir];
+      c->normal[2] = 0;
+    }
+}
+
 void drawPlayers(Player *p) {
   int i;
-  int dir;
-  float l = 5.0;
-  float height;
+
+  queueQuads();
+#ifdef ANDROID
+  // Ensure depth testing is enabled for 3D rendering
+  setDepthTest(1);
+  setDepthMask(GL_TRUE);
+#else
+  glShadeModel(GL_SMOOTH);
+#endif
+  renderSubmit();
 
 #ifdef ANDROID
-  // For Android, use vertex buffers with unified helpers
   GLuint shaderProgram = ensure_basic_shader_bound();
   if (!shaderProgram) {
     __android_log_print(ANDROID_LOG_ERROR, "GLTron", "Failed to ensure shader for players");
@@ -1395,97 +1527,10 @@ void drawPlayers(Player *p) {
   ensure3D(shaderProgram);
 
   // Enable blending for trail gradient effect
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-  // Ensure depth testing is enabled for 3D rendering
-  glEnable(GL_DEPTH_TEST);
-  glDepthMask(GL_TRUE);
-
-  // Bind white texture once for all untextured geometry
-  glActiveTexture(GL_TEXTURE0);
-  static GLuint s_white = 0;
-  if (s_white == 0) s_white = createWhiteTexture();
-  glBindTexture(GL_TEXTURE_2D, s_white);
-  setTexture(shaderProgram, 0);
+  setBlend(1);
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   for (i = 0; i < game->players; i++) {
-    height = game->player[i].data->trail_height;
-
-    if (height > 0) {
-      // Position the quad at the player's position via model matrix
-      GLfloat playerModel[16] = {
-        1,0,0,0, 
-        0,1,0,0, 
-        0,0,1,0, 
-        game->player[i].data->posx, game->player[i].data->posy, 0, 1
-      };
-      setModelMatrix(shaderProgram, playerModel);
-
-      // Get player color
-      float* cm = game->player[i].model->color_model;
-
-      // Create quad vertices with color gradient (matching desktop)
-      // The gradient fades from player color at origin to black at the trail end
-      dir = game->player[i].data->dir;
-      
-      // Vertices with per-vertex colors for gradient effect
-      // Format: x, y, z, r, g, b, a
-      GLfloat vertices[] = {
-        // Vertex 0: origin (full color)
-        0, 0, 0,                           cm[0], cm[1], cm[2], 1.0f,
-        // Vertex 1: trail end bottom (black/transparent)
-        -dirsX[dir] * l, -dirsY[dir] * l, 0,     0.0f, 0.0f, 0.0f, 0.0f,
-        // Vertex 2: trail end top (black/transparent)  
-        -dirsX[dir] * l, -dirsY[dir] * l, height, 0.0f, 0.0f, 0.0f, 0.0f,
-        // Vertex 3: origin top (full color)
-        0, 0, height,                      cm[0], cm[1], cm[2], 1.0f
-      };
-
-      GLuint vbo = 0;
-      glGenBuffers(1, &vbo);
-      glBindBuffer(GL_ARRAY_BUFFER, vbo);
-      glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-      GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-      GLint normalLoc = glGetAttribLocation(shaderProgram, "normal");
-      
-      if (positionLoc >= 0) {
-        glEnableVertexAttribArray(positionLoc);
-        glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(GLfloat), 0);
-      }
-
-      // For gradient effect, we'll use the color data in vertices
-      // Set the base color and let vertex colors modulate it
-      setColor(shaderProgram, 1.0f, 1.0f, 1.0f, 1.0f);
-      
-      // Since we can't easily pass per-vertex colors in this shader setup,
-      // we'll draw two triangles with different colors
-      // First triangle (bottom half)
-      setColor(shaderProgram, cm[0], cm[1], cm[2], 1.0f);
-      glDrawArrays(GL_TRIANGLE_FAN, 0, 2);
-      
-      // Second part with fade
-      setColor(shaderProgram, cm[0] * 0.5f, cm[1] * 0.5f, cm[2] * 0.5f, 0.5f);
-      glDrawArrays(GL_TRIANGLE_FAN, 2, 2);
-
-      // Provide a normal for lighting
-      if (normalLoc >= 0) {
-        // Normal points toward the player's direction for better lighting
-        glVertexAttrib3f(normalLoc, dirsX[dir], dirsY[dir], 0.0f);
-      }
-
-      // Actually draw as a quad using TRIANGLE_FAN
-      setColor(shaderProgram, cm[0], cm[1], cm[2], 1.0f);
-      glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-      if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glDeleteBuffers(1, &vbo);
-
-      polycount++;
-    }
-
     // Draw the cycle model if visible
     if (playerVisible(p, &(game->player[i]))) {
       if (game->settings->show_model && game->player[i].model && game->player[i].model->mesh)
@@ -1494,39 +1539,18 @@ void drawPlayers(Player *p) {
   }
 
   // Restore depth state
-  glDisable(GL_DEPTH_TEST);
-  glDepthMask(GL_FALSE);
+  setDepthTest(0);
+  setDepthMask(GL_FALSE);
   
-  if (game->settings->show_alpha != 1) glDisable(GL_BLEND);
+  if (game->settings->show_alpha != 1) setBlend(0);
 #else
   // For desktop OpenGL
-  glShadeModel(GL_SMOOTH);
   glEnable(GL_BLEND);
 
   // Enable lighting
   /* no fixed-function lighting on GLES2 */
 
   for(i = 0; i < game->players; i++) {
-    height = game->player[i].data->trail_height;
-    if(height > 0) {
-      glPushMatrix();
-      glTranslatef(game->player[i].data->posx,
-                   game->player[i].data->posy,
-                   0);
-      /* draw Quad */
-      dir = game->player[i].data->dir;
-      glColor3fv(game->player[i].model->color_model);
-      glBegin(GL_QUADS);
-      glVertex3f(0, 0, 0);
-      glColor4f(0, 0, 0, 0);
-      glVertex3f(-dirsX[dir] * l, -dirsY[dir] * l, 0);
-      glVertex3f(-dirsX[dir] * l, -dirsY[dir] * l, height);
-      glColor3fv(game->player[i].model->color_model);
-      glVertex3f(0, 0, height);
-      glEnd();
-      polycount++;
-      glPopMatrix();
-    }
     if(playerVisible(p, &(game->player[i]))) {
       if(game->settings->show_model)
         drawCycle(&(game->player[i]));
@@ -1558,10 +1582,10 @@ void drawGlow(Player *p, gDisplay *d, float dim) {
   setModelMatrix(shaderProgram, modelMatrix);
 
   // Bind white texture for solid color rendering
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   static GLuint s_white = 0;
   if (s_white == 0) s_white = createWhiteTexture();
-  glBindTexture(GL_TEXTURE_2D, s_white);
+  bindTexture2D(s_white);
   setTexture(shaderProgram, 0);
 
   // Set player color
@@ -1589,6 +1613,7 @@ void drawGlow(Player *p, gDisplay *d, float dim) {
   }
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(fanVertices), fanVertices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, vbo, sizeof(fanVertices));
 
   GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
   GLint normalLoc = glGetAttribLocation(shaderProgram, "normal");
@@ -1604,8 +1629,8 @@ void drawGlow(Player *p, gDisplay *d, float dim) {
   }
 
   // Enable additive blending for glow effect
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_ONE, GL_ONE);
+  setBlend(1);
+  setBlendFunc(GL_ONE, GL_ONE);
 
   // Draw the main fan
   glDrawArrays(GL_TRIANGLE_FAN, 0, 7);
@@ -1624,17 +1649,19 @@ void drawGlow(Player *p, gDisplay *d, float dim) {
   };
   
   glBufferData(GL_ARRAY_BUFFER, sizeof(triVertices), triVertices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, vbo, sizeof(triVertices));
   glDrawArrays(GL_TRIANGLES, 0, 6);
   polycount += 2;
 
   // Clean up
   if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
+  memGpuObject(MEM_GPU_BUFFER, vbo, 0);
   glDeleteBuffers(1, &vbo);
 
   // Restore blend function
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  if (game->settings->show_alpha != 1) glDisable(GL_BLEND);
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if (game->settings->show_alpha != 1) setBlend(0);
 #else
   // For desktop OpenGL
   float mat[4*4];
@@ -1749,14 +1776,14 @@ void drawWalls(gDisplay *d) {
   setColor(shaderProgram, 1.0f, 1.0f, 1.0f, 1.0f);
 
   // Bind wall texture
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   if (game->screen->texWall != 0) {
-    glBindTexture(GL_TEXTURE_2D, game->screen->texWall);
+    bindTexture2D(game->screen->texWall);
   } else {
     // Fallback to a default texture if wall texture not loaded
     static GLuint s_white = 0;
     if (s_white == 0) s_white = createWhiteTexture();
-    glBindTexture(GL_TEXTURE_2D, s_white);
+    bindTexture2D(s_white);
   }
   setTexture(shaderProgram, 0);
 
@@ -1765,27 +1792,32 @@ void drawWalls(gDisplay *d) {
   glCullFace(GL_BACK);
 
   // Set blend function and enable blending
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-  // Create and bind vertex buffer
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  if (vbo == 0) {
-    return;
+  setBlend(1);
+  setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  // The arena never changes, upload the walls once and reuse them for
+  // every viewport and frame
+  static GLuint wall_vbo = 0, wall_ibo = 0;
+  if (wall_vbo == 0) {
+    glGenBuffers(1, &wall_vbo);
+    if (wall_vbo == 0) {
+      return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, wall_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    memGpuObject(MEM_GPU_BUFFER, wall_vbo, sizeof(vertices));
   }
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  // Create and bind index buffer
-  GLuint ibo = 0;
-  glGenBuffers(1, &ibo);
-  if (ibo == 0) {
-    glDeleteBuffers(1, &vbo);
-    return;
+  if (wall_ibo == 0) {
+    glGenBuffers(1, &wall_ibo);
+    if (wall_ibo == 0) {
+      return;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wall_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    memGpuObject(MEM_GPU_BUFFER, wall_ibo, sizeof(indices));
   }
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, wall_vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, wall_ibo);
 
   // Set up attributes
   GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
@@ -1823,12 +1855,10 @@ void drawWalls(gDisplay *d) {
   if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  glDeleteBuffers(1, &vbo);
-  glDeleteBuffers(1, &ibo);
 
   // Restore state
   glDisable(GL_CULL_FACE);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   polycount += 4;
 #else
@@ -1841,28 +1871,34 @@ void drawWalls(gDisplay *d) {
 
   glEnable(GL_TEXTURE_2D);
   glBindTexture(GL_TEXTURE_2D, game->screen->texWall);
-  glBegin(GL_QUADS);
-  glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, 0.0);
-  glTexCoord2f(0.0, 1.0); glVertex3f(0.0, 0.0, WALL_H);
-  glTexCoord2f(0.0, 1.0); glVertex3f(GSIZE, 0.0, WALL_H);
-  glTexCoord2f(0.0, 0.0); glVertex3f(GSIZE, 0.0, 0.0);
-
-  glTexCoord2f(0.0, 1.0); glVertex3f(GSIZE, 0.0, 0.0);
-  glTexCoord2f(1.0, 0.0); glVertex3f(GSIZE, 0.0, WALL_H);
-  glTexCoord2f(0.0, 0.0); glVertex3f(GSIZE, GSIZE, WALL_H);
-  glTexCoord2f(0.0, 1.0); glVertex3f(GSIZE, GSIZE, 0.0);
-
-  glTexCoord2f(0.0, 1.0); glVertex3f(GSIZE, GSIZE, 0.0);
-  glTexCoord2f(1.0, 0.0); glVertex3f(GSIZE, GSIZE, WALL_H);
-  glTexCoord2f(0.0, 0.0); glVertex3f(0.0, GSIZE, WALL_H);
-  glTexCoord2f(0.0, 1.0); glVertex3f(0.0, GSIZE, 0.0);
-
-  glTexCoord2f(0.0, 1.0); glVertex3f(0.0, GSIZE, 0.0);
-  glTexCoord2f(1.0, 0.0); glVertex3f(0.0, GSIZE, WALL_H);
-  glTexCoord2f(0.0, 0.0); glVertex3f(0.0, 0.0, WALL_H);
-  glTexCoord2f(0.0, 1.0); glVertex3f(0.0, 0.0, 0.0);
-
-  glEnd();
+  {
+    /* s, t, x, y, z; the arena never changes */
+    static const GLfloat walls[] = {
+      0.0, 0.0,  0.0, 0.0, 0.0,
+      0.0, 1.0,  0.0, 0.0, WALL_H,
+      0.0, 1.0,  GSIZE, 0.0, WALL_H,
+      0.0, 0.0,  GSIZE, 0.0, 0.0,
+
+      0.0, 1.0,  GSIZE, 0.0, 0.0,
+      1.0, 0.0,  GSIZE, 0.0, WALL_H,
+      0.0, 0.0,  GSIZE, GSIZE, WALL_H,
+      0.0, 1.0,  GSIZE, GSIZE, 0.0,
+
+      0.0, 1.0,  GSIZE, GSIZE, 0.0,
+      1.0, 0.0,  GSIZE, GSIZE, WALL_H,
+      0.0, 0.0,  0.0, GSIZE, WALL_H,
+      0.0, 1.0,  0.0, GSIZE, 0.0,
+
+      0.0, 1.0,  0.0, GSIZE, 0.0,
+      1.0, 0.0,  0.0, GSIZE, WALL_H,
+      0.0, 0.0,  0.0, 0.0, WALL_H,
+      0.0, 1.0,  0.0, 0.0, 0.0
+    };
+    glInterleavedArrays(GL_T2F_V3F, 0, walls);
+    glDrawArrays(GL_QUADS, 0, 16);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+  }
   polycount += 4;
 
   glDisable(GL_TEXTURE_2D);
@@ -1876,20 +1912,51 @@ void drawWalls(gDisplay *d) {
 void drawHelp(gDisplay *d) {
   rasonly(d);
   glColor4f(0.2, 0.2, 0.2, 0.8);
-  glEnable(GL_BLEND);
+  setBlend(1);
   glBegin(GL_QUADS);
   glVertex2i(0,0);
   glVertex2i(d->vp_w - 1, 0);
   glVertex2i(d->vp_w - 1, d->vp_h - 1);
   glVertex2i(0, d->vp_h - 1);
   glEnd();
-  if(game->settings->show_alpha != 1) glDisable(GL_BLEND);
+  if(game->settings->show_alpha != 1) setBlend(0);
   glColor3f(1.0, 1.0, 0.0);
   drawLines(d->vp_w, d->vp_h,
 	    help, HELP_LINES, 0);
 }
 */
 
+/* the desktop camera: behind the player, looking just ahead of it */
+static void chaseCamera(Player *p, float *eye, float *look) {
+  float camDist   = 12.0f; // distance behind the player
+  float camHeight = 6.0f;  // height above the ground
+  float dirX = dirsX[p->data->dir];
+  float dirY = dirsY[p->data->dir];
+
+  eye[0] = p->data->posx - dirX * camDist;
+  eye[1] = p->data->posy - dirY * camDist;
+  eye[2] = camHeight;
+  look[0] = p->data->posx + dirX * 5.0f; // 5 units ahead
+  look[1] = p->data->posy + dirY * 5.0f;
+  look[2] = 0.5f; // just above ground
+}
+
+/* The world buffer part of drawCam() for p's chase camera: culling,
+ * trails and quads go through the command list, nothing else is drawn.
+ * With the null backend this runs without GL. */
+void traverseWorld(Player *p, gDisplay *d) {
+  float eye[3], look[3];
+  int i;
+
+  chaseCamera(p, eye, look);
+  cullTrails(eye, look, game->settings->fov, (float)d->vp_w / (float)d->vp_h);
+  for(i = 0; i < game->players; i++)
+    drawTraces(&(game->player[i]), d, i);
+  renderSubmit();
+  queueQuads();
+  renderSubmit();
+}
+
 void drawCam(Player *p, gDisplay *d) {
   int i;
 
@@ -2037,20 +2104,39 @@ void drawCam(Player *p, gDisplay *d) {
   setLightColor(shaderProgram, 1.0f, 1.0f, 1.0f);
   setAmbientLight(shaderProgram, 0.2f, 0.2f, 0.2f);
 
+  // Chase and first person cameras look along the floor, so most of the
+  // arena is behind or beside them; other cameras draw every trail
+  if (!p->camera || p->camera->camType == 1 || p->camera->camType == 2 ||
+      p->camera->camType == -1) {
+    float eye[3] = { camX, camY, camZ };
+    float look[3] = { lookX, lookY, lookZ };
+    cullTrails(eye, look, fov * 180.0f / M_PI, aspect);
+  } else {
+    float eye[3] = { camX, camY, camZ };
+    showAllTrails(eye);
+  }
+
   // Draw scene (same order as desktop)
+  profilePass(PASS_FLOOR);
   drawFloor(d);
+  profilePass(PASS_WALLS);
   if (game->settings->show_wall == 1)
     drawWalls(d);
 
+  profilePass(PASS_TRAILS);
   for (i = 0; i < game->players; i++)
     drawTraces(&(game->player[i]), d, i);
+  renderSubmit();
 
+  profilePass(PASS_CYCLES);
   drawPlayers(p);
 
+  profilePass(PASS_GLOW);
   if (game->settings->show_glow == 1)
     for (i = 0; i < game->players; i++)
       if ((p != &(game->player[i])) && (game->player[i].data->speed > 0))
         drawGlow(&(game->player[i]), d, TRAIL_HEIGHT * 4);
+  profilePass(PASS_NONE);
 
   // Clean up /* keep program bound */
 #else
@@ -2063,50 +2149,39 @@ void drawCam(Player *p, gDisplay *d) {
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
 
-  // Camera parameters
-  float camDist   = 12.0f; // distance behind the player
-  float camHeight = 6.0f;  // height above the ground
-
-  // Player position
-  float playerX = p->data->posx;
-  float playerY = p->data->posy;
-
-  // Player facing direction vector (unit vector from dirsX/dirsY)
-  float dirX = dirsX[p->data->dir];
-  float dirY = dirsY[p->data->dir];
+  float eye[3], look[3];
+  chaseCamera(p, eye, look);
 
-  // Camera position = player position - direction * distance + height in Z
-  float camX = playerX - dirX * camDist;
-  float camY = playerY - dirY * camDist;
-  float camZ = camHeight;
-
-  // Look-at target = in front of the player
-  float lookX = playerX + dirX * 5.0f; // 5 units ahead
-  float lookY = playerY + dirY * 5.0f;
-  float lookZ = 0.5f; // just above ground
-
-  // Up vector (Z-up in GLTron)
-  float upX = 0.0f, upY = 0.0f, upZ = 1.0f;
-
-  gluLookAt(camX, camY, camZ, lookX, lookY, lookZ, upX, upY, upZ);
+  // Z is up in GLTron
+  gluLookAt(eye[0], eye[1], eye[2], look[0], look[1], look[2], 0.0f, 0.0f, 1.0f);
 
   // Light moves with camera
   glLightfv(GL_LIGHT0, GL_POSITION, p->camera->cam);
 
+  // The chase camera looks along the floor, skip trails behind and beside it
+  cullTrails(eye, look, game->settings->fov, (float)d->vp_w / (float)d->vp_h);
+
   // Draw scene
+  profilePass(PASS_FLOOR);
   drawFloor(d);
+  profilePass(PASS_WALLS);
   if (game->settings->show_wall == 1)
     drawWalls(d);
 
+  profilePass(PASS_TRAILS);
   for (i = 0; i < game->players; i++)
     drawTraces(&(game->player[i]), d, i);
+  renderSubmit();
 
+  profilePass(PASS_CYCLES);
   drawPlayers(p);
 
+  profilePass(PASS_GLOW);
   if (game->settings->show_glow == 1)
     for (i = 0; i < game->players; i++)
       if ((p != &(game->player[i])) && (game->player[i].data->speed > 0))
         drawGlow(&(game->player[i]), d, TRAIL_HEIGHT * 4);
+  profilePass(PASS_NONE);
 
   glDisable(GL_FOG);
 #endif
@@ -2116,150 +2191,8 @@ void drawAI(gDisplay *d) {
   char ai[] = "computer player";
 
   rasonly(d);
-
-#ifdef ANDROID
-  // For Android, implement text rendering using font texture and shaders
-  GLuint shaderProgram = ensure_basic_shader_bound();
-  if (!shaderProgram) return;
-  ensure2D(shaderProgram, d->vp_w, d->vp_h);
-
-  // Set color (white)
-  setColor(shaderProgram, 1.0f, 1.0f, 1.0f, 1.0f);
-
-  // Bind font texture
-  glActiveTexture(GL_TEXTURE0);
-  if (game->screen->texFont == 0) {
-    game->screen->texFont = createFontTexture();
-  }
-  glBindTexture(GL_TEXTURE_2D, game->screen->texFont);
-  setTexture(shaderProgram, 0);
-
-  // Calculate text dimensions
-  int textLen = strlen(ai);
-  float charSize = d->vp_w / (2.0f * textLen);  // Size to fit text in half screen width
-  float x = d->vp_w / 4.0f;  // Start at 1/4 screen width
-  float y = 10.0f;
-
-  // Build all vertices for the entire string at once
-  int vertexCount = textLen * 4 * 5;  // 4 vertices per char, 5 floats per vertex
-  GLfloat *vertices = (GLfloat *)malloc(vertexCount * sizeof(GLfloat));
-  if (!vertices) return;
-
-  int vIndex = 0;
-  float currentX = x;
-  
-  for (int i = 0; i < textLen; i++) {
-    char c = ai[i];
-    if (c < 32 || c > 127) c = 32;  // Fallback to space for invalid chars
-    
-    int charIndex = c - 32;
-    float texX = (float)(charIndex % 16) / 16.0f;
-    float texY = (float)(charIndex / 16) / 6.0f;
-    float texW = 1.0f / 16.0f;
-    float texH = 1.0f / 6.0f;
-
-    // Bottom-left vertex
-    vertices[vIndex++] = currentX;
-    vertices[vIndex++] = y;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = texX;
-    vertices[vIndex++] = texY;
-
-    // Bottom-right vertex
-    vertices[vIndex++] = currentX + charSize;
-    vertices[vIndex++] = y;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = texX + texW;
-    vertices[vIndex++] = texY;
-
-    // Top-right vertex
-    vertices[vIndex++] = currentX + charSize;
-    vertices[vIndex++] = y + charSize;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = texX + texW;
-    vertices[vIndex++] = texY + texH;
-
-    // Top-left vertex
-    vertices[vIndex++] = currentX;
-    vertices[vIndex++] = y + charSize;
-    vertices[vIndex++] = 0.0f;
-    vertices[vIndex++] = texX;
-    vertices[vIndex++] = texY + texH;
-
-    currentX += charSize * 0.8f;  // Advance with slight overlap for better spacing
-  }
-
-  // Create indices for all quads
-  int indexCount = textLen * 6;  // 6 indices per quad (2 triangles)
-  GLushort *indices = (GLushort *)malloc(indexCount * sizeof(GLushort));
-  if (!indices) {
-    free(vertices);
-    return;
-  }
-
-  for (int i = 0; i < textLen; i++) {
-    int base = i * 4;
-    int idx = i * 6;
-    indices[idx]     = base;
-    indices[idx + 1] = base + 1;
-    indices[idx + 2] = base + 2;
-    indices[idx + 3] = base;
-    indices[idx + 4] = base + 2;
-    indices[idx + 5] = base + 3;
-  }
-
-  // Create single VBO for all characters
-  GLuint vbo = 0, ibo = 0;
-  glGenBuffers(1, &vbo);
-  glGenBuffers(1, &ibo);
-  
-  if (vbo == 0 || ibo == 0) {
-    if (vbo) glDeleteBuffers(1, &vbo);
-    if (ibo) glDeleteBuffers(1, &ibo);
-    free(vertices);
-    free(indices);
-    return;
-  }
-
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLushort), indices, GL_STATIC_DRAW);
-
-  // Set up attributes
-  GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-  GLint texCoordLoc = glGetAttribLocation(shaderProgram, "texCoord");
-
-  if (positionLoc >= 0) {
-    glEnableVertexAttribArray(positionLoc);
-    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
-  }
-
-  if (texCoordLoc >= 0) {
-    glEnableVertexAttribArray(texCoordLoc);
-    glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-  }
-
-  // Draw all characters in one call
-  glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
-
-  // Clean up
-  if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-  if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
-  
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  glDeleteBuffers(1, &vbo);
-  glDeleteBuffers(1, &ibo);
-  
-  free(vertices);
-  free(indices);
-#else
-  // For desktop OpenGL
-  glColor3f(1.0, 1.0, 1.0);
+  setTextColor(1.0, 1.0, 1.0, 1.0);
   drawText(d->vp_w / 4, 10, d->vp_w / (2 * strlen(ai)), ai);
-#endif
 }
 
 void drawPause(gDisplay *display) {
@@ -2276,7 +2209,16 @@ void drawPause(gDisplay *display) {
   delta = now - lt;
   lt = now;
   delta /= 500.0;
-  d += delta;
+  /* after a rest, carry on where the pulse stopped */
+  if(delta > 0.2)
+    delta = 0.2;
+
+  /* come to rest on the brightest colour */
+  if(redrawSettled() && d < M_PI / 2 && d + delta >= M_PI / 2) {
+    d = M_PI / 2;
+    redrawRest();
+  } else
+    d += delta;
 
   if(d > 2 * M_PI) {
     d -= 2 * M_PI;
@@ -2292,281 +2234,15 @@ void drawPause(gDisplay *display) {
 
   rasonly(game->screen);
 
-#ifdef ANDROID
-  // For Android, use centralized shader for text rendering
-  GLuint shaderProgram = ensure_basic_shader_bound();
-  if (!shaderProgram) return;
-  ensure2D(shaderProgram, display->vp_w, display->vp_h);
-
-  // Ensure font texture exists
-  glActiveTexture(GL_TEXTURE0);
-  if (game->screen->texFont == 0) {
-    game->screen->texFont = createFontTexture();
-  }
-  glBindTexture(GL_TEXTURE_2D, game->screen->texFont);
-  setTexture(shaderProgram, 0);
-
-  // Helper function to render text - we'll inline this code for each text rendering
-  // First, render the main message with animated color
-  {
-    const char* text = message;
-    float startX = display->vp_w / 6.0f;
-    float startY = 20.0f;
-    float charSize = display->vp_w / (6.0f / 4.0f * strlen(message));
-    float animColor = (sin(d) + 1) / 2;
-    float r = 1.0f, g = animColor, b = animColor, a = 1.0f;
-    int textLen = strlen(text);
-    if (textLen == 0) return;
-
-    // Set color for this text
-    setColor(shaderProgram, r, g, b, a);
-
-    // Build all vertices for the string
-    int vertexCount = textLen * 4 * 5;  // 4 vertices per char, 5 floats per vertex
-    GLfloat *vertices = (GLfloat *)malloc(vertexCount * sizeof(GLfloat));
-    if (!vertices) return;
-
-    int vIndex = 0;
-    float currentX = startX;
-    
-    for (int i = 0; i < textLen; i++) {
-      char c = text[i];
-      if (c < 32 || c > 127) c = 32;  // Fallback to space
-      
-      int charIndex = c - 32;
-      float texX = (float)(charIndex % 16) / 16.0f;
-      float texY = (float)(charIndex / 16) / 6.0f;
-      float texW = 1.0f / 16.0f;
-      float texH = 1.0f / 6.0f;
-
-      // Bottom-left
-      vertices[vIndex++] = currentX;
-      vertices[vIndex++] = startY;
-      vertices[vIndex++] = 0.0f;
-      vertices[vIndex++] = texX;
-      vertices[vIndex++] = texY;
-
-      // Bottom-right
-      vertices[vIndex++] = currentX + charSize;
-      vertices[vIndex++] = startY;
-      vertices[vIndex++] = 0.0f;
-      vertices[vIndex++] = texX + texW;
-      vertices[vIndex++] = texY;
-
-      // Top-right
-      vertices[vIndex++] = currentX + charSize;
-      vertices[vIndex++] = startY + charSize;
-      vertices[vIndex++] = 0.0f;
-      vertices[vIndex++] = texX + texW;
-      vertices[vIndex++] = texY + texH;
-
-      // Top-left
-      vertices[vIndex++] = currentX;
-      vertices[vIndex++] = startY + charSize;
-      vertices[vIndex++] = 0.0f;
-      vertices[vIndex++] = texX;
-      vertices[vIndex++] = texY + texH;
-
-      currentX += charSize * 0.8f;  // Advance with slight overlap
-    }
-
-    // Create indices
-    int indexCount = textLen * 6;
-    GLushort *indices = (GLushort *)malloc(indexCount * sizeof(GLushort));
-    if (!indices) {
-      free(vertices);
-      return;
-    }
-
-    for (int i = 0; i < textLen; i++) {
-      int base = i * 4;
-      int idx = i * 6;
-      indices[idx]     = base;
-      indices[idx + 1] = base + 1;
-      indices[idx + 2] = base + 2;
-      indices[idx + 3] = base;
-      indices[idx + 4] = base + 2;
-      indices[idx + 5] = base + 3;
-    }
-
-    // Create buffers
-    GLuint vbo = 0, ibo = 0;
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ibo);
-    
-    if (vbo && ibo) {
-      glBindBuffer(GL_ARRAY_BUFFER, vbo);
-      glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
-
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLushort), indices, GL_STATIC_DRAW);
-
-      // Set up attributes
-      GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-      GLint texCoordLoc = glGetAttribLocation(shaderProgram, "texCoord");
-
-      if (positionLoc >= 0) {
-        glEnableVertexAttribArray(positionLoc);
-        glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
-      }
-
-      if (texCoordLoc >= 0) {
-        glEnableVertexAttribArray(texCoordLoc);
-        glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-      }
-
-      // Draw all characters at once
-      glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
-
-      // Clean up
-      if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-      if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
-    }
-
-    // Clean up buffers
-    if (vbo) glDeleteBuffers(1, &vbo);
-    if (ibo) glDeleteBuffers(1, &ibo);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    
-    free(vertices);
-    free(indices);
-  }
-
-  // Show hint for touch/mouse if needed
-  if (game->settings->input_mode != 0) {
-    const char* hint = "Tap to resume";
-    float hintX = display->vp_w / 6.0f;
-    float hintY = 20.0f + display->vp_h / 12.0f;
-    float hintScale = display->vp_w / (8.0f * strlen(hint));
-    
-    // Inline text rendering for hint
-    int textLen = strlen(hint);
-    if (textLen > 0) {
-      // Set color for hint text
-      setColor(shaderProgram, 1.0f, 1.0f, 1.0f, 1.0f);
-      
-      // Build all vertices for the string
-      int vertexCount = textLen * 4 * 5;  // 4 vertices per char, 5 floats per vertex
-      GLfloat *vertices = (GLfloat *)malloc(vertexCount * sizeof(GLfloat));
-      if (vertices) {
-        int vIndex = 0;
-        float currentX = hintX;
-        
-        for (int i = 0; i < textLen; i++) {
-          char c = hint[i];
-          if (c < 32 || c > 127) c = 32;  // Fallback to space
-          
-          int charIndex = c - 32;
-          float texX = (float)(charIndex % 16) / 16.0f;
-          float texY = (float)(charIndex / 16) / 6.0f;
-          float texW = 1.0f / 16.0f;
-          float texH = 1.0f / 6.0f;
-
-          // Bottom-left
-          vertices[vIndex++] = currentX;
-          vertices[vIndex++] = hintY;
-          vertices[vIndex++] = 0.0f;
-          vertices[vIndex++] = texX;
-          vertices[vIndex++] = texY;
-
-          // Bottom-right
-          vertices[vIndex++] = currentX + hintScale;
-          vertices[vIndex++] = hintY;
-          vertices[vIndex++] = 0.0f;
-          vertices[vIndex++] = texX + texW;
-          vertices[vIndex++] = texY;
-
-          // Top-right
-          vertices[vIndex++] = currentX + hintScale;
-          vertices[vIndex++] = hintY + hintScale;
-          vertices[vIndex++] = 0.0f;
-          vertices[vIndex++] = texX + texW;
-          vertices[vIndex++] = texY + texH;
-
-          // Top-left
-          vertices[vIndex++] = currentX;
-          vertices[vIndex++] = hintY + hintScale;
-          vertices[vIndex++] = 0.0f;
-          vertices[vIndex++] = texX;
-          vertices[vIndex++] = texY + texH;
-
-          currentX += hintScale * 0.8f;  // Advance with slight overlap
-        }
-
-        // Create indices
-        int indexCount = textLen * 6;
-        GLushort *indices = (GLushort *)malloc(indexCount * sizeof(GLushort));
-        if (indices) {
-          for (int i = 0; i < textLen; i++) {
-            int base = i * 4;
-            int idx = i * 6;
-            indices[idx]     = base;
-            indices[idx + 1] = base + 1;
-            indices[idx + 2] = base + 2;
-            indices[idx + 3] = base;
-            indices[idx + 4] = base + 2;
-            indices[idx + 5] = base + 3;
-          }
-
-          // Create buffers
-          GLuint vbo = 0, ibo = 0;
-          glGenBuffers(1, &vbo);
-          glGenBuffers(1, &ibo);
-          
-          if (vbo && ibo) {
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
-
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLushort), indices, GL_STATIC_DRAW);
-
-            // Set up attributes
-            GLint positionLoc = glGetAttribLocation(shaderProgram, "position");
-            GLint texCoordLoc = glGetAttribLocation(shaderProgram, "texCoord");
-
-            if (positionLoc >= 0) {
-              glEnableVertexAttribArray(positionLoc);
-              glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), 0);
-            }
-
-            if (texCoordLoc >= 0) {
-              glEnableVertexAttribArray(texCoordLoc);
-              glVertexAttribPointer(texCoordLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-            }
-
-            // Draw all characters at once
-            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0);
-
-            // Clean up
-            if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-            if (texCoordLoc >= 0) glDisableVertexAttribArray(texCoordLoc);
-          }
-
-          // Clean up buffers
-          if (vbo) glDeleteBuffers(1, &vbo);
-          if (ibo) glDeleteBuffers(1, &ibo);
-          glBindBuffer(GL_ARRAY_BUFFER, 0);
-          glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-          
-          free(indices);
-        }
-        free(vertices);
-      }
-    }
-  }
-#else
-  // For desktop OpenGL
-  glColor3f(1.0, (sin(d) + 1) / 2, (sin(d) + 1) / 2);
+  setTextColor(1.0, (sin(d) + 1) / 2, (sin(d) + 1) / 2, 1.0);
   drawText(display->vp_w / 6, 20,
            display->vp_w / (6.0 / 4.0 * strlen(message)), message);
 
   // Show hint for touch/mouse
   if (game->settings->input_mode != 0) {
     const char* hint = "Tap to resume";
-    glColor3f(1.0, 1.0, 1.0);
+    setTextColor(1.0, 1.0, 1.0, 1.0);
     drawText(display->vp_w / 6, 20 + display->vp_h / 12,
              display->vp_w / (8.0 * strlen(hint)), hint);
   }
-#endif
 }
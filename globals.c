@@ -27,6 +27,7 @@ int si_count;
 settings_float *sf;
 int sf_count;
 int polycount;
+int capturing = 0; /* rendering offscreen, see capture.c */
 
 /* default settings */
 float colors_alpha[][4] = { { .8, 0.1, 0.2 , 0.6}, { 0.856, 0.42, 0.25, 0.6},
@@ -54,6 +54,7 @@ extern int si_count;
 extern settings_float *sf;
 extern int sf_count;
 extern int polycount;
+extern int capturing;
 extern float colors_alpha[][4];
 extern float colors_trail[][4];
 extern float colors_model[][4];
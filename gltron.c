@@ -47,6 +47,12 @@ int getElapsedTime(void) {
     static int start_time = 0;
     static int initialized = 0;
 
+#ifdef CAPTURE
+    // Offscreen captures run on a fixed step clock and have no GLUT
+    if (capturing)
+        return captureClock();
+#endif
+
     if (!initialized) {
         // Initialize the start time on first call
         start_time = glutGet(GLUT_ELAPSED_TIME);
@@ -69,7 +75,7 @@ void drawGame() {
     // Ensure shader is bound and set to 3D mode
     GLuint prog = shader_get_basic();
     if (prog) {
-      glUseProgram(prog);
+      useShaderProgram(prog);
       setup3DRendering();
     } else {
       __android_log_print(ANDROID_LOG_ERROR, "GLTron", "No shader program in drawGame!");
@@ -77,16 +83,23 @@ void drawGame() {
     }
   #endif
 
+  /* the frame before is done with its passes and its scratch memory */
+  profileFrame();
+  arenaReset(&frame_arena);
   polycount = 0;
   glClearColor(0.0, 0.0, 0.0, 1.0);
-  glDepthMask(GL_TRUE);
+  setDepthMask(GL_TRUE);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   // Enable depth test for 3D scene
   #ifdef ANDROID
-  glEnable(GL_DEPTH_TEST);
+  setDepthTest(1);
   #endif
 
+  /* trails and cycle quads are shared by all viewports, only the camera
+     differs between them */
+  prepareWorld();
+
   for(GLint i = 0; i < vp_max[game->settings->display_type]; i++) {
     Player *p = &(game->player[game->settings->content[i]]);
     if(p->display->onScreen == 1) {
@@ -95,23 +108,30 @@ void drawGame() {
       drawCam(p, d);
       // Disable depth for UI overlays drawn per-viewport
       #ifdef ANDROID
-      glDisable(GL_DEPTH_TEST);
+      setDepthTest(0);
       #endif
       if(game->settings->show_ai_status)
         if(p->ai->active == 1)
           drawAI(d);
       #ifdef ANDROID
-      glEnable(GL_DEPTH_TEST);
+      setDepthTest(1);
       #endif
     }
   }
 
   // Disable depth for global 2D overlays
   #ifdef ANDROID
-  glDisable(GL_DEPTH_TEST);
+  setDepthTest(0);
   #endif
-  if(game->settings->show_fps)
+  /* like the pass times, memory use isn't the same from run to run */
+  if(game->settings->show_memory && !capturing)
+    drawMemory(game->screen);
+  if(game->settings->show_fps) {
     drawFPS(game->screen);
+    /* the times vary from run to run, keep them out of captures */
+    if(!capturing)
+      drawProfile(game->screen);
+  }
 
   /*
   if(game->settings->show_help == 1)
@@ -128,18 +148,21 @@ void displayGame() {
     // Ensure shader is properly set up for game rendering
     GLuint prog = shader_get_basic();
     if (prog) {
-        glUseProgram(prog);
+        useShaderProgram(prog);
         // Set up proper 3D projection for game
         ensure3D(prog);
     }
 #endif
     
     drawGame();
+    flushText(game->screen);
     if(game->settings->mouse_warp)
         mouseWarp();
 #ifndef ANDROID
-    glutSwapBuffers();
+    if (!capturing)
+        glutSwapBuffers();
 #endif
+    benchmarkFrame();
 }
 
 void initCustomLights() {
@@ -160,10 +183,10 @@ void initGLGame() {
     __android_log_print(ANDROID_LOG_INFO, "GLTron", "initGLGame called");
     // Android-specific OpenGL initialization
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glEnable(GL_DEPTH_TEST);
+    setDepthTest(1);
     glDepthFunc(GL_LEQUAL);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    setBlend(1);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Initialize shaders
     init_shaders_android();
@@ -177,7 +200,7 @@ void initGLGame() {
     }
 #else
     // First create the window if it doesn't exist
-    if (glutGetWindow() == 0) {
+    if (!capturing && glutGetWindow() == 0) {
         glutInitWindowSize(game->settings->width, game->settings->height);
         glutCreateWindow("GLtron");
     }
@@ -322,6 +345,8 @@ void applyDisplaySettingsDeferred() {
     g_pending_display_apply = 0;
 
     if (!game || !game->settings) return;
+    /* the capture pbuffer has a fixed size and no window to rebuild */
+    if (capturing) return;
 
     /* Ensure we have a window; if not, create one */
     if (!game->screen) {
@@ -503,16 +528,43 @@ void setupDisplay(gDisplay *d) {
     glutSpecialFunc(specialGame);
     glutIdleFunc(idleGame);
 #endif
+
+    // Swap interval and pacing belong to the new context
+    frameInit();
 }
 
+#ifndef ANDROID
+/* with show_memory, what's still allocated on the way out goes to memory.csv */
+static void writeMemory(void) {
+    FILE *f;
+
+    if(!game->settings->show_memory)
+        return;
+    f = fopen("memory.csv", "w");
+    if(f == NULL) {
+        fprintf(stderr, "can't write memory.csv\n");
+        return;
+    }
+    memDump(f);
+    fclose(f);
+}
+#endif
+
 int main( int argc, char *argv[] ) {
     char *path;
+    Mesh *cycle;
 
 #ifdef __FreeBSD__
     fpsetmask(0);
 #endif
 
+    startupBegin();
+
 #ifndef ANDROID
+#ifdef CAPTURE
+    // Capture mode renders into an EGL pbuffer and must not need a display
+    if (!captureArgs(argc, argv))
+#endif
     glutInit(&argc, argv);
 #endif
 
@@ -535,48 +587,72 @@ int main( int argc, char *argv[] ) {
 #endif
 
     parse_args(argc, argv);
-
-    /* sound */
-
-#ifdef SOUND
-    printf("initializing sound\n");
-    initSound();
-
-    // Print sound file search paths
-    printf("Sound file search paths:\n");
-    printf("1. Current directory: %s\n", cwd);
-    printf("2. /usr/share/games/gltron/\n");
-    printf("3. /usr/local/share/games/gltron/\n");
-
-    path = getFullPath("gltron.it");
-    if(path == 0 || loadSound(path))
-        printf("error trying to load sound\n");
-    else {
-        if(game->settings->playSound) {
-            playSound();
-            free(path);
-        }
-    }
+#ifndef ANDROID
+    atexit(writeMemory);
 #endif
 
+    /* textures, font and model load in the background from here on */
+    startupTasks();
+
     printf("loading menu\n");
-    path = getFullPath("menu.txt");
-    if(path != 0)
-        pMenuList = loadMenuFile(path);
-    else {
+    pMenuList = loadMenuFile("menu.txt");
+    if(pMenuList == NULL) {
         printf("fatal: could not load menu.txt, exiting...\n");
         exit(1);
     }
     printf("menu loaded\n");
-    free(path);
+    /* like captureSettings(), after the menu has saved its settings */
+    benchmarkSettings(1);
 
+    /* sound */
+
+#ifdef SOUND
+    if (!capturing) {
+        startupSound();
+
+        // Print sound file search paths
+        printf("Sound file search paths:\n");
+        printf("1. Current directory: %s\n", cwd);
+        printf("2. /usr/share/games/gltron/\n");
+        printf("3. /usr/local/share/games/gltron/\n");
+    }
+#endif
+
+#ifdef CAPTURE
+    /* after the menu, which applies some settings while it builds captions */
+    if (capturing)
+        captureSettings();
+#endif
+
+    /* the players' instances share the geometry of this one */
+    cycle = startupResult("t-u-low.obj");
     initGameStructures();
+    if(cycle != NULL)
+        unloadModel(cycle);
     resetScores();
 
     initData();
 
+#ifdef CAPTURE
+    if (capturing) {
+        runCapture();
+        startupWait();
+        return 0;
+    }
+#endif
+
     setupDisplay(game->screen);
-    switchCallbacks(&guiCallbacks);
+    if(benchmarking())
+        benchmarkStart();
+    else
+        switchCallbacks(&guiCallbacks);
+
+    /* sound comes last, the window is up by now */
+#ifdef SOUND
+    if(startupResult("gltron.it") != NULL && game->settings->playSound)
+        playSound();
+#endif
+    startupWait();
 
 #ifndef ANDROID
     glutMainLoop();
@@ -83,6 +83,12 @@
 /* #include "TexFont.h" */
 #include "fonttex.h"
 
+/* packed game data */
+#include "pack.h"
+#include "startup.h"
+/* memory accounting */
+#include "memstat.h"
+
 /* menu stuff */
 
 #include "menu.h"
@@ -217,7 +223,8 @@ typedef struct gDisplay {
 
 typedef struct Player {
   Model *model;
-  Data *data;
+  Data *data; /* as last drawn, see sim.c */
+  Data *sim;
   Camera *camera;
   gDisplay *display;
   AI *ai;
@@ -274,6 +281,14 @@ typedef struct Settings {
   /* fullscreen toggle */
   int fullscreen;
 
+  /* frame scheduler: target frames per second (0: unlimited) and
+     whether frames are lined up with the display's refresh */
+  int frame_rate;
+  int vsync;
+
+  /* memory use per subsystem on screen (and in memory.csv on exit) */
+  int show_memory;
+
 } Settings;
 
 typedef struct Game {
@@ -328,6 +343,7 @@ extern int lasttime;
 extern double dt; /* milliseconds since last frame */
 
 extern int polycount;
+extern int capturing;
 
 extern float colors_alpha[][4];
 extern float colors_trail[][4];
@@ -352,7 +368,8 @@ extern char *help[];
 extern void setCol(int x, int y);
 extern void clearCol(int x, int y);
 extern int getCol(int x, int y);
-extern void turn(Data* data, int direction);
+/* time is the simulation's clock, see simTime() */
+extern void turn(Data* data, int direction, int time);
 
 extern void idleGame();
 
@@ -399,6 +416,8 @@ extern void initFonts();
 
 extern void initTexture();
 extern void deleteTextures();
+/* a precompiled .gtx exists for the .sgi filename */
+extern int hasTextureFile(const char *filename);
 
 /* help -> character.c */
 
@@ -442,6 +461,121 @@ extern void restoreCallbacks();
 extern void switchCallbacks(callbacks*);
 extern void updateCallbacks();
 
+/* on-demand redraw for the menu and pause screens -> redraw.c */
+/* makes screen redraw on demand if it is one of them, 1 if it does */
+extern int redrawOnDemand(callbacks *screen);
+/* input or another visible change: draw, and animate again */
+extern void redrawInput(void);
+/* no input for a while, the screen should come to rest */
+extern int redrawSettled(void);
+/* the screen shows its still frame, stop drawing until the next input */
+extern void redrawRest(void);
+/* how long the main loop may block in ms: 0 if a frame is due, -1 forever */
+extern int redrawTimeout(void);
+
+/* frame scheduler -> frame.c */
+/* monotonic clock in ms, sub-millisecond resolution */
+extern double frameClock(void);
+/* applies the vsync setting, needs a current context */
+extern void frameInit(void);
+/* ms the main loop can block before the next frame, 0 if it's due */
+extern int frameTimeout(void);
+/* sleeps until the next frame is due */
+extern void frameWait(void);
+/* the frame time to advance the game by, ms in and out */
+extern double frameSmooth(double ms);
+
+/* simulation thread -> sim.c */
+enum { SIM_CRASH };
+/* runs the simulation while screen is the game screen */
+extern void simScreen(callbacks *screen);
+extern void simStart(void);
+/* waits for the thread and syncs the players' data with it */
+extern void simStop(void);
+/* 1 while rounds tick on the thread, idleGame() ticks otherwise */
+extern int simThreaded(void);
+/* one tick on the calling thread, at getElapsedTime() */
+extern void simTick(double step);
+/* ticks run since the start, on any thread */
+extern int simTicks(void);
+/* time the simulation thread spent in them */
+extern double simBusyMs(void);
+/* the clock of the ticks, ms in getElapsedTime()'s time */
+extern int simTime(void);
+/* queues a turn for the next tick */
+extern void simTurn(int player, int direction);
+/* crash sound, done on the render side */
+extern void simEvent(int event);
+/* a player's explosion is over, returns the players left in the round */
+extern int simGone(void);
+/* ends the round on the render side, winner -1 for none */
+extern void simFinished(int winner);
+/* copies the newest tick into the players' data */
+extern void simView(void);
+
+/* render pass profiler -> profile.c */
+enum {
+  PASS_NONE = -1,
+  PASS_FLOOR, PASS_WALLS, PASS_TRAILS, PASS_CYCLES, PASS_EXPLOSIONS,
+  PASS_GLOW, PASSES
+};
+/* ends the running pass and times pass from now on, returns the old one */
+extern int profilePass(int pass);
+/* once per frame, picks up the GPU times that arrived */
+extern void profileFrame(void);
+extern const char* profileName(int pass);
+/* ms per pass, last frame or smoothed; gpu_ms is -1 without timer queries */
+extern void profileTimes(int smoothed, double *cpu_ms, double *gpu_ms);
+
+/* render command list -> render.c */
+enum { RENDER_GL, RENDER_NULL };
+typedef struct RenderBuffer {
+  const GLfloat *verts; /* client memory on the desktop */
+  GLuint vbo;           /* the same vertices on GLES */
+  int stride;           /* floats per vertex: x, y, z, r, g, b, a */
+} RenderBuffer;
+typedef struct RenderState {
+  const RenderBuffer *buffer;
+  GLuint program;       /* 0: fixed function */
+  GLuint texture;       /* 0: untextured */
+  int blend;
+  GLenum sfactor, dfactor;
+} RenderState;
+typedef struct RenderCmd {
+  RenderState state;
+  unsigned int key;     /* sort order */
+  int seq;              /* queue order */
+  GLenum mode;
+  int first, count;     /* vertex range of the buffer */
+  int polys;
+  float color[4];       /* uniforms, GLES only */
+  float normal[3];
+} RenderCmd;
+extern void renderBackend(int which);
+/* queues a draw, the caller fills in polys and uniforms */
+extern RenderCmd* renderDraw(const RenderState *s, GLenum mode,
+                             int first, int count);
+/* draws the queue sorted, then leaves the blend state as show_alpha says */
+extern void renderSubmit(void);
+/* commands and state changes since the last call */
+extern void renderStats(int *command_count, int *state_changes);
+
+/* linear allocators -> arena.c */
+typedef struct Arena {
+  const char *name;
+  unsigned char *base;
+  size_t size, used;
+  size_t peak;               /* most used at once */
+  int grown;                 /* times the block was replaced */
+  struct ArenaSpill *spill;  /* what didn't fit, until the next reset */
+} Arena;
+extern Arena match_arena; /* one round, reset by initData() */
+extern Arena frame_arena; /* one frame, reset by drawGame() */
+/* 16 byte aligned, NULL if out of memory */
+extern void* arenaAlloc(Arena *a, size_t bytes);
+/* frees everything allocated from a at once */
+extern void arenaReset(Arena *a);
+
 /* display apply helper */
 extern void applyDisplaySettingsDeferred();
 extern void requestDisplayApply();
@@ -451,24 +585,83 @@ extern void forceViewportResetIfNeededForGame();
 /* reshape handler */
 extern void onReshape(int w, int h);
 
+/* offscreen capture mode -> capture.c */
+#ifdef CAPTURE
+extern int captureArgs(int argc, char *argv[]);
+extern void captureSettings();
+extern int captureClock(void);
+extern double captureMs();
+extern void runCapture();
+
+/* render stress scenes -> stress.c */
+extern int stressArg(char *arg);
+extern int stressEnabled();
+extern void runStress(int frames, FILE *csv);
+extern double stressMs(int players, int segments, int crashing, int viewports,
+                       int frames, int null_backend);
+
+/* performance regression runs -> perf.c */
+extern int perfArg(char *arg);
+extern int perfEnabled();
+/* 0 passed, 1 regressed, PERF_SKIPPED without a baseline to compare to;
+   the exit status of gltron --perf */
+#define PERF_SKIPPED 77
+extern int runPerf(const char *dir, unsigned int seed);
+#endif
+
+/* benchmark mode -> benchmark.c */
+extern int benchmarkArg(char *arg);
+extern int benchmarking(void);
+/* 1 applies the benchmark's settings, 0 puts the user's back */
+extern void benchmarkSettings(int on);
+/* seeds and starts the first round, instead of the menu */
+extern void benchmarkStart(void);
+/* after every frame, exits with the summary once the time is up */
+extern void benchmarkFrame(void);
+/* starts the next round right away, 0 when not benchmarking */
+extern int benchmarkRound(void);
+
+/* draw calls issued by everything including this file, counted in
+   COUNT_DRAWS builds: always for captures, for benchmarks on request */
+#if defined(CAPTURE) && !defined(COUNT_DRAWS)
+#define COUNT_DRAWS
+#endif
+#ifdef COUNT_DRAWS
+extern int drawcalls;
+#define glBegin(mode) (drawcalls++, glBegin(mode))
+#define glDrawArrays(mode, first, count) \
+  (drawcalls++, glDrawArrays(mode, first, count))
+#define glDrawElements(mode, count, type, indices) \
+  (drawcalls++, glDrawElements(mode, count, type, indices))
+#endif
+
 /* probably common graphics stuff -> graphics.c */
 
 extern void checkGLError(char *where);
 extern void rasonly(gDisplay *d);
 extern void drawFPS(gDisplay *d);
+extern void drawProfile(gDisplay *d);
+extern void drawMemory(gDisplay *d);
 extern void drawText(int x, int y, int size, const char *text);
+extern void setTextColor(float r, float g, float b, float a);
+extern void flushText(gDisplay *d);
 extern int hsv2rgb(float, float, float, float*, float*, float*);
 extern void colorDisc();
 
 /* gltron game graphics -> gamegraphics.c */
 extern void drawDebugTex(gDisplay *d);
 extern void drawScore(Player *p, gDisplay *d);
+extern void prepareWorld();
 extern void drawFloor(gDisplay *d);
 extern void drawTraces(Player *, gDisplay *d, int instance);
 extern void drawPlayers(Player *);
+extern void traverseWorld(Player *p, gDisplay *d);
 extern void drawWalls(gDisplay *d);
 extern void drawCam(Player *p, gDisplay *d);
 extern void drawAI(gDisplay *d);
+
+/* single quad floor with per fragment grid -> floor.c */
+extern int drawShaderFloor(int textured, GLuint texture, float spacing);
 extern void drawPause(gDisplay *d);
 extern void drawHelp(gDisplay *d);
 
@@ -484,7 +677,10 @@ extern void chaseCamMove();
 extern void timediff();
 extern void camMove();
 
-extern void movePlayers();
+extern void movePlayers(double step);
+/* one tick of the game logic on the players' sim data */
+extern void tickGame(double step);
+extern void finishGame();
 
 extern callbacks gameCallbacks;
 extern callbacks guiCallbacks;
@@ -25,6 +25,7 @@ void checkGLError(char *where) {
 
 void rasonly(gDisplay *d) {
   /* do rasterising only (in local display d) */
+  ftxBatchOrigin(d->vp_x, d->vp_y);
 #ifdef ANDROID
   // For Android, use orthographic projection with GLES
   glViewport(d->vp_x, d->vp_y, d->vp_w, d->vp_h);
@@ -97,66 +98,77 @@ void drawFPS(gDisplay *d) {
   }
 
   sprintf(tmp, "average FPS: %d", fps_avg);
-#ifdef ANDROID
-  { GLuint sp = shader_get_basic(); if (sp) { useShaderProgram(sp); setColor(sp, 1.0f, 0.4f, 0.2f, 1.0f); } }
-  drawText(d->vp_w - 180, d->vp_h - 20, 10, tmp);
-#else
-  glColor4f(1.0, 0.4, 0.2, 1.0);
+  setTextColor(1.0, 0.4, 0.2, 1.0);
   drawText(d->vp_w - 180, d->vp_h - 20, 10, tmp);
-#endif
 
   sprintf(tmp, "minimum FPS: %d", fps_min);
-#ifdef ANDROID
-  drawText(d->vp_w - 180, d->vp_h - 35, 10, tmp);
-#else
   drawText(d->vp_w - 180, d->vp_h - 35, 10, tmp);
+
+#ifdef ANDROID
+  {
+    /* redundant GL calls skipped by the state cache since last frame */
+    static unsigned int skipped_last = 0;
+    unsigned int skipped = getSkippedStateCalls();
+    sprintf(tmp, "GL skipped: %u", skipped - skipped_last);
+    skipped_last = skipped;
+    drawText(d->vp_w - 180, d->vp_h - 50, 10, tmp);
+  }
 #endif
 }
 
-void drawText(int x, int y, int size, const char *text) {
-  
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-#ifndef ANDROID
-  glEnable(GL_TEXTURE_2D);
-  glPushMatrix();
-  glTranslatef(x, y, 0);
-  glScalef(size, size, size);
-  ftxRenderString(ftx, text, strlen(text));
-  glPopMatrix();
-  glDisable(GL_TEXTURE_2D);
-#else
-  // Android: render text at pixel position (x,y) with uniform scale 'size'.
-  if (!text) return;
-  glDisable(GL_TEXTURE_2D); // no fixed-function textures in ES2
-
-  // Set up the shader program
-  GLuint prog = shader_get_basic();
-  if (!prog) return;
+void drawProfile(gDisplay *d) {
+  /* per pass render times below the FPS, the GPU ones if we have them */
+  double cpu[PASSES], gpu[PASSES];
+  char tmp[40];
+  int i, y = d->vp_h - 65;
 
-  useShaderProgram(prog);
+  profileTimes(1, cpu, gpu);
+  setTextColor(1.0, 0.4, 0.2, 1.0);
+  drawText(d->vp_w - 180, y, 10, "pass ms    cpu   gpu");
+  for(i = 0; i < PASSES; i++) {
+    y -= 15;
+    if(gpu[i] < 0)
+      sprintf(tmp, "%-10s %5.2f     -", profileName(i), cpu[i]);
+    else
+      sprintf(tmp, "%-10s %5.2f %5.2f", profileName(i), cpu[i], gpu[i]);
+    drawText(d->vp_w - 180, y, 10, tmp);
+  }
+}
 
-  // Set up the model matrix for positioning: translate to (x,y) and scale by 'size'
-  float s = (float)size;
-  GLfloat model[16] = {
-    s, 0, 0, 0,
-    0, s, 0, 0,
-    0, 0, 1, 0,
-    (GLfloat)x, (GLfloat)y, 0, 1
-  };
-  setModelMatrix(prog, model);
+void drawMemory(gDisplay *d) {
+  /* current and peak use per subsystem, top left, in kB */
+  size_t current, peak;
+  char tmp[64];
+  int i, y = d->vp_h - 20;
 
-  // Bind the font texture (textures will be (re)bound inside ftxRenderString as needed)
-  if (game && game->screen && game->screen->texFont) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, game->screen->texFont);
-    setTexture(prog, 0);
+  setTextColor(0.4, 0.8, 1.0, 1.0);
+  drawText(10, y, 10, "memory kB     now   peak");
+  for(i = 0; i < MEM_TAGS + 2; i++) {
+    y -= 15;
+    if(i < MEM_TAGS)
+      memUsage(i, &current, &peak);
+    else
+      memTotal(i - MEM_TAGS, &current, &peak);
+    sprintf(tmp, "%-11s %6lu %6lu",
+            i < MEM_TAGS ? memTagName(i) : i == MEM_TAGS ? "total cpu" : "total gpu",
+            (unsigned long) (current + 1023) / 1024,
+            (unsigned long) (peak + 1023) / 1024);
+    drawText(10, y, 10, tmp);
   }
+}
 
-  // Use the shared atlas renderer which is GLES2-aware under ANDROID
-  ftxRenderString(ftx, (char*)text, strlen(text));
-#endif
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  polycount += strlen(text);
+void drawText(int x, int y, int size, const char *text) {
+  /* text is only queued here, flushText() draws it at the end of the frame */
+  if (!text) return;
+  polycount += ftxBatchString(ftx, x, y, size, text, strlen(text));
+}
+
+void setTextColor(float r, float g, float b, float a) {
+  ftxBatchColor(r, g, b, a);
+}
+
+void flushText(gDisplay *d) {
+  ftxBatchFlush(ftx, d->w, d->h);
 }
 
 int hsv2rgb(float h, float s, float v, float *r, float *g, float *b) {
@@ -208,23 +220,24 @@ void colorDisc() {
   }
 
   GLint positionLoc = glGetAttribLocation(prog, "position");
-  GLint colorLoc = glGetUniformLocation(prog, "color");
 
   GLuint vbo;
   glGenBuffers(1, &vbo);
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  memGpuObject(MEM_GPU_BUFFER, vbo, sizeof(vertices));
 
   glEnableVertexAttribArray(positionLoc);
   glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
   for(h = 0; h <= 360; h += 10) {
     hsv2rgb(h, 1, 1, &r, &g, &b);
-    glUniform4f(colorLoc, r, g, b, 1.0f);
+    setColor(prog, r, g, b, 1.0f);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 362/3);
   }
 
   glDisableVertexAttribArray(positionLoc);
+  memGpuObject(MEM_GPU_BUFFER, vbo, 0);
   glDeleteBuffers(1, &vbo);
   /* keep program bound; drawCam controls unbinding */
 #else
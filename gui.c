@@ -12,11 +12,11 @@
 
 #ifdef ANDROID
 #include <GLES2/gl2.h>
-#include "shaders.h"
 #else
 #include <GL/gl.h>
 #include <GL/glu.h>
 #endif
+#include "shaders.h"
 
 sgi_texture *tex;
 
@@ -98,19 +98,19 @@ void displayGui() {
 #ifdef ANDROID
   // Android/GLES2: draw background in clip-space with identity matrices
   // Bind white texture to avoid black modulation
-  glActiveTexture(GL_TEXTURE0);
+  setActiveTexture(GL_TEXTURE0);
   static GLuint s_white_tex_bg = 0;
   if (s_white_tex_bg == 0) {
     GLubyte px[4] = {255,255,255,255};
     glGenTextures(1, &s_white_tex_bg);
-    glBindTexture(GL_TEXTURE_2D, s_white_tex_bg);
+    bindTexture2D(s_white_tex_bg);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
   }
-  glBindTexture(GL_TEXTURE_2D, s_white_tex_bg);
+  bindTexture2D(s_white_tex_bg);
   setTexture(shaderProgram, 0);
 
   // Use identity matrices locally for clip-space verts
@@ -174,19 +174,19 @@ void displayGui() {
 
 #ifdef ANDROID
       // Android/GLES2: draw grid tile in clip-space with identity
-      glActiveTexture(GL_TEXTURE0);
+      setActiveTexture(GL_TEXTURE0);
       static GLuint s_white_tex_grid = 0;
       if (s_white_tex_grid == 0) {
         GLubyte px[4] = {255,255,255,255};
         glGenTextures(1, &s_white_tex_grid);
-        glBindTexture(GL_TEXTURE_2D, s_white_tex_grid);
+        bindTexture2D(s_white_tex_grid);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
       }
-      glBindTexture(GL_TEXTURE_2D, s_white_tex_grid);
+      bindTexture2D(s_white_tex_grid);
       setTexture(shaderProgram, 0);
 
       const GLfloat Igrid[16] = {
@@ -274,8 +274,8 @@ void displayGui() {
   glVertexAttribPointer(a_pos_logo, 2, GL_FLOAT, GL_FALSE, 0, logoVerts);
   glVertexAttribPointer(a_uv_logo, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, game->screen->texGui);
+  setActiveTexture(GL_TEXTURE0);
+  bindTexture2D(game->screen->texGui);
   setTexture(shaderProgram, 0);
   setColor(shaderProgram, 1.0f, 1.0f, 1.0f, alpha);
 
@@ -309,23 +309,8 @@ void displayGui() {
 #endif
 
   // Draw menu
-#ifdef ANDROID
-  if (shaderProgram) {
-    // Re-bind shader and re-apply 2D pixel projection before text drawing
-    useShaderProgram(shaderProgram);
-    float wvp = (float)game->screen->vp_w;
-    float hvp = (float)game->screen->vp_h;
-    GLfloat proj2D[16] = {2.0f / wvp, 0, 0, 0, 0, 2.0f / hvp, 0, 0, 0, 0, 1, 0, -1, -1, 0, 1};
-    const GLfloat I2D[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
-    setProjectionMatrix(shaderProgram, proj2D);
-    setViewMatrix(shaderProgram, I2D);
-    setModelMatrix(shaderProgram, I2D);
-    setColor(shaderProgram, 1.0f, 1.0f, 0.0f, 1.0f);
-  }
-#else
-  glColor3f(1.0f, 1.0f, 0.0f);
-#endif
   drawMenu(game->screen);
+  flushText(game->screen);
 
   if(game->settings->mouse_warp)
     mouseWarp();
@@ -333,6 +318,7 @@ void displayGui() {
 #ifndef ANDROID
   glutSwapBuffers();
 #endif
+  startupFrame();
   checkGLError("gui.c displayGui - end");
 }
 
@@ -348,9 +334,19 @@ void idleGui() {
   delta = now - bgs.lt;
   bgs.lt = now;
   delta /= 1000.0;
-  bgs.d += delta;
+  /* after a rest, carry on where the animation stopped */
+  if(delta > 0.1)
+    delta = 0.1;
   /* printf("%.5f\n", delta); */
 
+  /* when nobody has touched anything for a while, stop with the logo
+     fully visible */
+  if(redrawSettled() && bgs.d < M_PI && bgs.d + delta >= M_PI) {
+    bgs.d = M_PI;
+    redrawRest();
+  } else
+    bgs.d += delta;
+
   if(bgs.d > 2 * M_PI) {
     bgs.d -= 2 * M_PI;
     bgs.posx = 1.0 * (float)rand() / (float)RAND_MAX - 1;
@@ -366,6 +362,7 @@ void idleGui() {
 
 void keyboardGui(unsigned char key, int x, int y) {
   int i;
+  redrawInput();
   switch(key) {
   case 27:
     /* ESC Back: apply any pending display changes */
@@ -391,6 +388,7 @@ void keyboardGui(unsigned char key, int x, int y) {
 }
 
 void  specialGui(int key, int x, int y) {
+  redrawInput();
   switch(key) {
   case GLUT_KEY_DOWN:
     pCurrent->iHighlight = (pCurrent->iHighlight + 1) % pCurrent->nEntries;
@@ -429,10 +427,10 @@ void initGLGui() {
 #ifndef ANDROID
   glShadeModel(GL_SMOOTH);
 #endif
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  setBlend(1);
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   // Ensure GUI overlays render on Android/GLES
-  glDisable(GL_DEPTH_TEST);
+  setDepthTest(0);
   glDisable(GL_CULL_FACE);
 #ifdef ANDROID
   // Initialize a 1x1 white texture for non-textured GUI draws
@@ -440,8 +438,8 @@ void initGLGui() {
   if (s_white_tex == 0) {
     GLubyte pixel[4] = {255,255,255,255};
     glGenTextures(1, &s_white_tex);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, s_white_tex);
+    setActiveTexture(GL_TEXTURE0);
+    bindTexture2D(s_white_tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
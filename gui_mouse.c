@@ -72,16 +72,15 @@ static int gui_hit_test(int x_win, int y_win) {
 void motionGui(int x, int y) {
   if (game->settings->input_mode == 0) return; /* keyboard only */
   int idx = gui_hit_test(x, y);
-  if (idx >= 0) {
+  if (idx >= 0 && idx != pCurrent->iHighlight) {
     pCurrent->iHighlight = idx;
-#ifndef ANDROID
-    glutPostRedisplay();
-#endif
+    redrawInput();
   }
 }
 
 void mouseGui(int button, int state, int x, int y) {
   if (game->settings->input_mode == 0) return; /* keyboard only */
+  redrawInput();
   if (button == GLUT_LEFT_BUTTON && state == GLUT_UP) {
     int idx = gui_hit_test(x, y);
     if (idx == -2) {
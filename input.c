@@ -1,4 +1,5 @@
 #include "gltron.h"
+#include <string.h>
 #ifdef ANDROID
 #include "switchCallbacks.h"
 #endif
@@ -40,35 +41,35 @@ void keyGame(unsigned char k, int x, int y) {
   case 'a': case 'A': 
     /* Check if player exists and is alive */
     if (game->player[0].data && game->player[0].data->speed > 0) {
-      turn(game->player[0].data, 3); 
+      simTurn(0, 3); 
     }
     break;
   case 's': case 'S': 
     /* Check if player exists and is alive */
     if (game->player[0].data && game->player[0].data->speed > 0) {
-      turn(game->player[0].data, 1); 
+      simTurn(0, 1); 
     }
     break;
     /* steering player 1 */
   case 'k': case 'K': 
     if (game->player[1].data && game->player[1].data->speed > 0) {
-      turn(game->player[1].data, 3); 
+      simTurn(1, 3); 
     }
     break;
   case 'l': case 'L': 
     if (game->player[1].data && game->player[1].data->speed > 0) {
-      turn(game->player[1].data, 1); 
+      simTurn(1, 1); 
     }
     break;
     /* steering player 2 */
   case '5': 
     if (game->player[2].data && game->player[2].data->speed > 0) {
-      turn(game->player[2].data, 3); 
+      simTurn(2, 3); 
     }
     break;
   case '6': 
     if (game->player[2].data && game->player[2].data->speed > 0) {
-      turn(game->player[2].data, 1); 
+      simTurn(2, 1); 
     }
     break;
     /* steering player 3 */
@@ -189,6 +190,13 @@ void parse_args(int argc, char *argv[]) {
       continue;
     }
 
+    if(benchmarkArg(argv[argc]))
+      continue;
+#ifdef CAPTURE
+    /* long options belong to the capture mode, see captureArgs() */
+    if(strncmp(argv[argc], "--", 2) == 0)
+      continue;
+#endif
     if(argv[argc][0] == '-') {
       i = 0;
       while(argv[argc][++i] != 0) {
@@ -228,7 +236,7 @@ void parse_args(int argc, char *argv[]) {
 	  break;
 	case 'h':
 	default:
-	  printf("Usage: %s [-FftwbghcCsk1234]\n\n", argv[0]);
+	  printf("Usage: %s [-FftwbghcCsk1234] [--benchmark[=SECONDS[,SEED]]]\n\n", argv[0]);
 	  printf("Options:\n\n");
 	  printf("-k\terase crashed players (like in the movie)\n");
 	  printf("-f\tfast finish after human has crashed\n");
@@ -251,6 +259,8 @@ void parse_args(int argc, char *argv[]) {
 	  /* printf("-i\tforce startup in a window\n"); */
 	  printf("-M\tcapture mouse (useful for Voodoo1/2 owners)");
 	  printf("-h\tthis help\n");
+	  printf("--benchmark[=SECONDS[,SEED]]\n\tplay AI rounds for SECONDS "
+		 "(default 60) and print frame times\n");
 	  exit(1);
 	}
       }
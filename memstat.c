@@ -0,0 +1,107 @@
+/*
+  memory accounting, see memstat.h
+
+  Kept free of GL and game state so the tools sharing the loaders can
+  link it as well.
+*/
+
+#include "memstat.h"
+
+/* GL objects whose size we remember, per GPU tag */
+#define MEM_OBJECTS 1024
+
+typedef struct MemCounter {
+  size_t current;
+  size_t peak;
+} MemCounter;
+
+static const char *names[MEM_TAGS] = {
+  "players", "mesh", "texture", "font", "sound", "arena", "render",
+  "pack", "gpu_texture", "gpu_buffer"
+};
+
+static MemCounter counters[MEM_TAGS];
+static MemCounter totals[2];
+
+/* open addressing by name, a deleted object keeps its slot at size 0 */
+static struct {
+  unsigned int name;
+  size_t bytes;
+} objects[MEM_TAGS - MEM_GPU][MEM_OBJECTS];
+
+static void raisePeak(size_t *peak, size_t value) {
+  size_t old = __atomic_load_n(peak, __ATOMIC_RELAXED);
+  while(value > old &&
+        !__atomic_compare_exchange_n(peak, &old, value, 1, __ATOMIC_RELAXED,
+                                     __ATOMIC_RELAXED))
+    ;
+}
+
+void memAccount(int tag, ptrdiff_t bytes) {
+  MemCounter *total = totals + (tag >= MEM_GPU);
+  size_t now;
+
+  if(tag < 0 || tag >= MEM_TAGS || bytes == 0)
+    return;
+  /* negative amounts wrap around, which adds up all the same */
+  now = __atomic_add_fetch(&counters[tag].current, (size_t) bytes,
+                           __ATOMIC_RELAXED);
+  raisePeak(&counters[tag].peak, now);
+  now = __atomic_add_fetch(&total->current, (size_t) bytes, __ATOMIC_RELAXED);
+  raisePeak(&total->peak, now);
+}
+
+void memGpuObject(int tag, unsigned int name, size_t bytes) {
+  /* GL objects only come from the GL thread */
+  static int full = 0;
+  unsigned int i, n;
+
+  if(tag < MEM_GPU || tag >= MEM_TAGS || name == 0)
+    return;
+  for(n = 0; n < MEM_OBJECTS; n++) {
+    i = (name * 2654435761u + n) % MEM_OBJECTS;
+    if(objects[tag - MEM_GPU][i].name == name ||
+       objects[tag - MEM_GPU][i].name == 0)
+      break;
+  }
+  if(n == MEM_OBJECTS) {
+    if(!full)
+      fprintf(stderr, "memstat: too many %s objects to track\n", names[tag]);
+    full = 1;
+    return;
+  }
+  objects[tag - MEM_GPU][i].name = name;
+  memAccount(tag, (ptrdiff_t) bytes -
+             (ptrdiff_t) objects[tag - MEM_GPU][i].bytes);
+  objects[tag - MEM_GPU][i].bytes = bytes;
+}
+
+const char* memTagName(int tag) {
+  return names[tag];
+}
+
+void memUsage(int tag, size_t *current, size_t *peak) {
+  *current = __atomic_load_n(&counters[tag].current, __ATOMIC_RELAXED);
+  *peak = __atomic_load_n(&counters[tag].peak, __ATOMIC_RELAXED);
+}
+
+void memTotal(int gpu, size_t *current, size_t *peak) {
+  *current = __atomic_load_n(&totals[gpu != 0].current, __ATOMIC_RELAXED);
+  *peak = __atomic_load_n(&totals[gpu != 0].peak, __ATOMIC_RELAXED);
+}
+
+void memDump(FILE *f) {
+  size_t current, peak;
+  int i;
+
+  fprintf(f, "tag,current,peak\n");
+  for(i = 0; i < MEM_TAGS; i++) {
+    memUsage(i, &current, &peak);
+    fprintf(f, "%s,%lu,%lu\n", names[i],
+            (unsigned long) current, (unsigned long) peak);
+  }
+  memTotal(0, &current, &peak);
+  fprintf(f, "total_cpu,%lu,%lu\n", (unsigned long) current, (unsigned long) peak);
+  memTotal(1, &current, &peak);
+  fprintf(f, "total_gpu,%lu,%lu\n", (unsigned long) current, (unsigned long) peak);
+}
@@ -0,0 +1,45 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+  memory accounting: bytes in use and the peak, per subsystem
+
+  Code that allocates something big or long-lived reports it with
+  memAccount(); what lives on the GPU is an estimate (texels and buffer
+  sizes as uploaded) reported per GL object with memGpuObject(), so
+  re-uploading an object replaces its size and an object that is never
+  deleted stays visible. Counters are atomic, any thread may report.
+  Shown by drawMemory() with show_memory, written as CSV by memDump().
+*/
+
+enum {
+  MEM_PLAYERS,    /* player, camera and AI structs, trails included */
+  MEM_MESH,       /* cycle models */
+  MEM_TEXTURE,    /* decoded images waiting for upload */
+  MEM_FONT,       /* font glyph pages */
+  MEM_SOUND,      /* music and sound effect samples */
+  MEM_ARENA,      /* match and frame arenas */
+  MEM_RENDER,     /* render command list */
+  MEM_PACK,       /* gltron.pak, mapped */
+  MEM_GPU_TEXTURE,
+  MEM_GPU_BUFFER,
+  MEM_TAGS
+};
+/* tags from here on are GPU memory */
+#define MEM_GPU MEM_GPU_TEXTURE
+
+/* bytes allocated (or freed, if negative) for tag */
+extern void memAccount(int tag, ptrdiff_t bytes);
+/* size of the GL object name under a GPU tag, 0 once it is deleted */
+extern void memGpuObject(int tag, unsigned int name, size_t bytes);
+extern const char* memTagName(int tag);
+extern void memUsage(int tag, size_t *current, size_t *peak);
+/* sums of the CPU (gpu == 0) or GPU tags */
+extern void memTotal(int gpu, size_t *current, size_t *peak);
+/* tag,current,peak lines in bytes, the totals last */
+extern void memDump(FILE *f);
+
+#endif
@@ -299,15 +299,8 @@ Menu** loadMenuFile(char *filename) {
   node *z;
   int sp = 0;
 
-  {
-    char *resolved = getFullPath(filename);
-    if(!resolved) return 0;
-    char *dup = strdup(resolved);
-    if(!dup) return 0;
-    f = fopen(dup, "rb");
-    if(f == NULL) { free(dup); return 0; }
-    free(dup);
-  }
+  f = openAsset(filename);
+  if(f == NULL) return 0;
   /* read count of Menus */
   getNextLine(buf, MENU_BUFSIZE, f);
   sscanf(buf, "%d ", &nMenus);
@@ -366,37 +359,9 @@ void drawMenu(gDisplay *d) {
   /* draw Menu pCurrent */
   int i;
   int x, y, size, lineheight;
+  float *color;
 
-  // Setup 2D projection
-#ifdef ANDROID
-  // Android/GLES2: use basic shader with bottom-left origin 2D projection in pixels
-  {
-    GLuint prog = shader_get_basic();
-    if (prog) {
-      useShaderProgram(prog);
-      float wvp = (float)d->vp_w;
-      float hvp = (float)d->vp_h;
-      GLfloat proj2D[16] = {
-        2.0f / wvp, 0.0f,       0.0f, 0.0f,
-        0.0f,       2.0f / hvp, 0.0f, 0.0f,
-        0.0f,       0.0f,       1.0f, 0.0f,
-        -1.0f,     -1.0f,       0.0f, 1.0f
-      };
-      GLfloat I[16] = {
-        1,0,0,0,
-        0,1,0,0,
-        0,0,1,0,
-        0,0,0,1
-      };
-      setProjectionMatrix(prog, (float*)proj2D);
-      setViewMatrix(prog, (float*)I);
-      setModelMatrix(prog, (float*)I);
-      setTexture(prog, 0);
-    }
-  }
-#else
   rasonly(d);
-#endif
 
   x = d->vp_w / 6;
   size = d->vp_w / 32;
@@ -406,72 +371,18 @@ void drawMenu(gDisplay *d) {
 
   // Hard fallback: if no menu loaded, display a simple message
   if (!pMenuList || !pCurrent) {
-#ifdef ANDROID
-    GLuint prog = shader_get_basic();
-    if (prog) {
-      useShaderProgram(prog);
-      setColor(prog, 1.0f, 1.0f, 1.0f, 1.0f);
-    }
-#endif
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-#ifndef ANDROID
-    rasonly(d);
-#endif
+    setTextColor(1.0, 1.0, 1.0, 1.0);
     drawText(x, y, size, "Menu failed to load");
     return;
   }
 
   /* draw the entries */
   for(i = 0; i < pCurrent->nEntries; i++) {
-#ifdef ANDROID
-    // Android GLES2 path: re-assert full text pipeline state defensively before each drawText
-    {
-      GLuint prog = shader_get_basic();
-      if (prog) {
-        useShaderProgram(prog);
-        // Bottom-left-origin pixel-space projection
-        float wvp = (float)d->vp_w;
-        float hvp = (float)d->vp_h;
-        GLfloat proj2D[16] = {
-          2.0f / wvp, 0.0f,       0.0f, 0.0f,
-          0.0f,       2.0f / hvp, 0.0f, 0.0f,
-          0.0f,       0.0f,       1.0f, 0.0f,
-          -1.0f,     -1.0f,       0.0f, 1.0f
-        };
-        GLfloat I[16] = {
-          1,0,0,0,
-          0,1,0,0,
-          0,0,1,0,
-          0,0,0,1
-        };
-        setProjectionMatrix(prog, (float*)proj2D);
-        setViewMatrix(prog, (float*)I);
-        setModelMatrix(prog, (float*)I);
-        setTexture(prog, 0);
-        if(i == pCurrent->iHighlight) {
-          setColor(prog, pCurrent->display.hlColor[0],
-                   pCurrent->display.hlColor[1],
-                   pCurrent->display.hlColor[2],
-                   pCurrent->display.hlColor[3]);
-        } else {
-          setColor(prog, pCurrent->display.fgColor[0],
-                   pCurrent->display.fgColor[1],
-                   pCurrent->display.fgColor[2],
-                   pCurrent->display.fgColor[3]);
-        }
-      }
-    }
-#else
-    // Desktop OpenGL path unchanged
     if(i == pCurrent->iHighlight)
-      glColor4fv(pCurrent->display.hlColor);
+      color = pCurrent->display.hlColor;
     else
-      glColor4fv(pCurrent->display.fgColor);
-#endif
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-#ifndef ANDROID
-    rasonly(d);
-#endif
+      color = pCurrent->display.fgColor;
+    setTextColor(color[0], color[1], color[2], color[3]);
     drawText(x, y, size,
          ((Menu*)*(pCurrent->pEntries + i))->display.szCaption);
     y -= lineheight;
@@ -482,40 +393,8 @@ void drawMenu(gDisplay *d) {
     const char* back = "Back";
     int bx = d->vp_w - (int)(size * 4);
     int by = (int)(size * 1.2f);
-#ifdef ANDROID
-    {
-      GLuint prog = shader_get_basic();
-      if (prog) {
-        useShaderProgram(prog);
-        // Bottom-left-origin pixel-space projection
-        float wvp = (float)d->vp_w;
-        float hvp = (float)d->vp_h;
-        GLfloat proj2D[16] = {
-          2.0f / wvp, 0.0f,       0.0f, 0.0f,
-          0.0f,       2.0f / hvp, 0.0f, 0.0f,
-          0.0f,       0.0f,       1.0f, 0.0f,
-          -1.0f,     -1.0f,       0.0f, 1.0f
-        };
-        GLfloat I[16] = {
-          1,0,0,0,
-          0,1,0,0,
-          0,0,1,0,
-          0,0,0,1
-        };
-        setProjectionMatrix(prog, (float*)proj2D);
-        setViewMatrix(prog, (float*)I);
-        setModelMatrix(prog, (float*)I);
-        setTexture(prog, 0);
-        setColor(prog, pCurrent->display.fgColor[0],
-                 pCurrent->display.fgColor[1],
-                 pCurrent->display.fgColor[2],
-                 pCurrent->display.fgColor[3]);
-        // Projection already set at top of drawMenu
-      }
-    }
-#else
-    glColor4fv(pCurrent->display.fgColor);
-#endif
+    color = pCurrent->display.fgColor;
+    setTextColor(color[0], color[1], color[2], color[3]);
     drawText(bx, by, size, back);
   }
 }
@@ -1,17 +1,12 @@
 #include "model.h"
 #include "geom.h"
+#include "pack.h"
+#include "memstat.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_V 30000
-#define MAX_F 20000
-#define MAX_N 30000
-
-#define FAIL(X) free(vert); free(face); free(norm); free(normi); \
-                printf(X); return 0;
-
 void rescaleVertices(float *vertices, float size, int nVertices, float *bbox) {
   float x, y, z, xmax, ymax, zmax, max;
   float *f;
@@ -69,208 +64,302 @@ void rescaleVertices(float *vertices, float size, int nVertices, float *bbox) {
 	*/
 }
   
-Mesh* loadModel(const char *filename, float size, int flags) {
-  /* faces: only quads or triangles at the moment */
+/* whole contents of a model file: in place if it is packed, otherwise
+   read into *copy, which the caller frees */
+const char* loadModelFile(const char *filename, size_t *size, char **copy) {
+  const char *data;
+  FILE *f;
+  long l;
+
+  *copy = NULL;
+  data = packData(filename, size);
+  if(data != NULL)
+    return data;
+
+  f = openAsset(filename);
+  if(f == NULL)
+    return NULL;
+  fseek(f, 0, SEEK_END);
+  l = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  if(l >= 0 && (*copy = (char*) malloc(l + 1)) != NULL &&
+     fread(*copy, 1, l, f) != (size_t) l) {
+    free(*copy);
+    *copy = NULL;
+  }
+  fclose(f);
+  *size = l;
+  return *copy;
+}
+
+const char* skipModelSpace(const char *s, const char *end) {
+  while(s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+    s++;
+  return s;
+}
+
+static const char* nextLine(const char *s, const char *end) {
+  while(s < end && *s != '\n')
+    s++;
+  return s < end ? s + 1 : end;
+}
+
+/* decimal float without sscanf: [-+]digits[.digits][e[-+]digits] */
+float parseModelFloat(const char **s, const char *end) {
+  static const double tens[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *p = skipModelSpace(*s, end);
+  unsigned long long mant = 0;
+  int neg = 0, exp = 0, digits = 0, e;
+  double v;
+
+  if(p < end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+  for(; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+    if(mant < 100000000000000000ULL)
+      mant = mant * 10 + (*p - '0');
+    else
+      exp++;
+  }
+  if(p < end && *p == '.')
+    for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++)
+      if(mant < 100000000000000000ULL) {
+	mant = mant * 10 + (*p - '0');
+	exp--;
+      }
+  if(digits == 0) /* not a number, leave *s alone */
+    return 0;
+  if(p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    int eneg = 0;
+    if(q < end && (*q == '-' || *q == '+'))
+      eneg = *q++ == '-';
+    if(q < end && *q >= '0' && *q <= '9') {
+      for(e = 0; q < end && *q >= '0' && *q <= '9'; q++)
+	if(e < 1000)
+	  e = e * 10 + (*q - '0');
+      exp += eneg ? -e : e;
+      p = q;
+    }
+  }
+  *s = p;
+
+  v = (double) mant;
+  /* one rounding step for everything a model file contains */
+  while(exp > 22) { v *= 1e22; exp -= 22; }
+  while(exp < -22) { v /= 1e22; exp += 22; }
+  v = exp < 0 ? v / tens[-exp] : v * tens[exp];
+  return (float) (neg ? -v : v);
+}
+
+static int parseInt(const char **s, const char *end, int *out) {
+  const char *p = *s;
+  int neg = 0, v = 0;
+
+  if(p < end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+  if(p >= end || *p < '0' || *p > '9')
+    return 0;
+  for(; p < end && *p >= '0' && *p <= '9'; p++)
+    v = v * 10 + (*p - '0');
+  *out = neg ? -v : v;
+  *s = p;
+  return 1;
+}
+
+/* the next whitespace separated word, copied to buf */
+int parseModelWord(const char **s, const char *end, char *buf, int size) {
+  const char *p = skipModelSpace(*s, end);
+  int n = 0;
+
+  while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+    if(n < size - 1)
+      buf[n++] = *p;
+    p++;
+  }
+  buf[n] = 0;
+  *s = p;
+  return n;
+}
+
+static int isKeyword(const char *s, const char *end, const char *word) {
+  int n = strlen(word);
+  return end - s > n && memcmp(s, word, n) == 0 &&
+    (s[n] == ' ' || s[n] == '\t');
+}
+
+/* makes room for one more element, doubling the capacity */
+static void* grow(void *array, int count, int *capacity, int elemsize) {
+  if(count < *capacity)
+    return array;
+  *capacity = *capacity ? 2 * *capacity : 256;
+  array = realloc(array, (size_t) *capacity * elemsize);
+  if(array == NULL) {
+    fprintf(stderr, "fatal: out of memory loading model\n");
+    exit(1);
+  }
+  return array;
+}
+
+/* triangles of one material while parsing, as vertex/normal indices */
+typedef struct {
+  int *index;  /* 2 per triangle vertex */
+  int nIndex, maxIndex;
+  unsigned char *facetris;
+  int nFaces, maxFaces;
+} PartBuilder;
+
+static void addFace(PartBuilder *part, int *fv, int *fn, int c) {
+  int k, tris;
+
+  for(k = 2; k < c; k++) { /* fan: (0, k - 1, k) */
+    int fan[3] = { 0, k - 1, k };
+    int l;
+    for(l = 0; l < 3; l++) {
+      part->index = grow(part->index, part->nIndex + 1, &part->maxIndex,
+			 sizeof(int));
+      part->index[part->nIndex++] = fv[fan[l]];
+      part->index = grow(part->index, part->nIndex + 1, &part->maxIndex,
+			 sizeof(int));
+      part->index[part->nIndex++] = fn[fan[l]];
+    }
+  }
+  /* huge polygons count as several faces when exploding */
+  for(tris = c - 2; tris > 0; tris -= 255) {
+    part->facetris = grow(part->facetris, part->nFaces, &part->maxFaces, 1);
+    part->facetris[part->nFaces++] = tris > 255 ? 255 : tris;
+  }
+}
+
+Mesh* loadModelObj(const char *filename, float size, int flags) {
+  /* faces: any polygon, split into triangle fans */
   Mesh* mesh;
-  Material *materials;
+  Material *materials = NULL;
+  PartBuilder *parts = NULL;
+  int nParts = 0;
 
-  FILE *f;
-  char buf[120];
+  const char *data, *p, *end;
+  char *copy;
+  size_t len;
   char namebuf[120];
-  char *path;
 
-  float *vert;
-  int *face;
-  float *norm;
-  int *normi;
-  int *matIndex;
-  
-  float *vertex, *normal;
+  float *vert = NULL;
+  float *norm = NULL;
+  int nVertices = 0, maxVertices = 0;
+  int nNormals = 0, maxNormals = 0;
+  int *fv = NULL, *fn = NULL; /* current face */
+  int maxFv = 0, maxFn = 0;
 
-  int nNormals = 0;
-  int nVertices = 0;
   int nFaces = 0;
-
-  float *meshVerts;
-  float *meshNorms;
-  int *meshFacesize;
   int currentMat = 0;
   int matCount = 0;
-  int *pMatCount;
   int iLine = 0;
 
   float t1[3], t2[3], t3[3];
-  int c, i, j, k, l, pos;
-  int hasNorms = 0;
+  int c, i, j, l, t;
   int inv;
 
-  char *resolved = getFullPath(filename);
-  if(!resolved) {
-    printf("could not resolve file '%s'\n", filename);
+  data = loadModelFile(filename, &len, &copy);
+  if(!data) {
+    printf("could not open file '%s'\n", filename);
     return 0;
   }
-  {
-    char *dup = strdup(resolved);
-    if(!dup) { printf("out of memory duplicating path for '%s'\n", filename); return 0; }
-    f = fopen(dup, "rb");
-    if(!f) { printf("could not open file '%s'\n", dup); free(dup); return 0; }
-    free(dup);
-  }
 
-
-  vert = (float *) malloc(sizeof(float) * 3 * MAX_V);
-  face = (int *) malloc(sizeof(int) * MODEL_FACESIZE * MAX_F);
-  matIndex = (int *) malloc(sizeof(int) * MAX_F);
-  normi = (int *) malloc(sizeof(int) * MODEL_FACESIZE * MAX_F);
-  norm = (float *) malloc(sizeof(float) * 3 * MAX_N);
-  
-  while(fgets(buf, sizeof(buf), f)) {
-    switch(buf[0]) {
-    case 'm': /* material library? */
-      if(sscanf(buf, "mtllib %s ", namebuf) == 1) {
-	/* load material library */
-	path = getFullPath(namebuf);
-	if(path == 0) {
-	  fprintf(stderr, "fatal: can't find mtllib '%s'\n", namebuf);
-	  exit(1);
-	}
-	matCount = loadMaterials(path, &materials);
-	if(matCount <= 0) {
-	  fprintf(stderr, "fatal: no Materials loaded\n");
-	  exit(1);
-	} else {
-	  /* printf("loaded %d Materials\n", matCount); */
-	}
-	pMatCount = (int*) malloc(sizeof(int) * matCount);
-	for(i = 0; i < matCount; i++)
-	  pMatCount[i] = 0;
-	currentMat = 0;
-      } else
-	fprintf(stderr, "warning: ignored line %d\n", iLine);
-      break;
-    case 'u': /* material name */
-      if(sscanf(buf, "usemtl %s ", namebuf) == 1) {
-	for(i = 0; i < matCount; i++) {
-	  if(strcmp(namebuf, (materials + i)->name) == 0) {
-	    currentMat = i;
-	    break; /* break out of if */
+  for(p = data, end = data + len; p < end; p = nextLine(p, end), iLine++) {
+    p = skipModelSpace(p, end);
+    if(isKeyword(p, end, "v")) {
+      p += 1;
+      vert = grow(vert, 3 * nVertices + 3, &maxVertices, sizeof(float));
+      for(i = 0; i < 3; i++)
+	vert[3 * nVertices + i] = parseModelFloat(&p, end);
+      nVertices++;
+    } else if(isKeyword(p, end, "vn")) {
+      p += 2;
+      norm = grow(norm, 3 * nNormals + 3, &maxNormals, sizeof(float));
+      for(i = 0; i < 3; i++)
+	norm[3 * nNormals + i] = parseModelFloat(&p, end);
+      nNormals++;
+    } else if(isKeyword(p, end, "f")) {
+      int ok = 1;
+      p += 1;
+      /* v, v/t, v//n or v/t/n; negative indices count from the end */
+      for(c = 0; ; c++) {
+	int v, n = 0, unused;
+	p = skipModelSpace(p, end);
+	if(!parseInt(&p, end, &v))
+	  break;
+	if(p < end && *p == '/') {
+	  p++;
+	  parseInt(&p, end, &unused);
+	  if(p < end && *p == '/') {
+	    p++;
+	    parseInt(&p, end, &n);
 	  }
 	}
-      } else currentMat = 0;
-      break;
-    case 'v':
-      switch(buf[1]) {
-      case ' ': /* vertex data */
-	if(nVertices >= MAX_V) {
-	  FAIL("vertex limit exceeded\n") ;
-	}
-	c = sscanf(buf, "v %f %f %f ",
-		   vert + nVertices * 3,
-		   vert + nVertices * 3 + 1,
-		   vert + nVertices * 3 + 2);
-
-	for(i = c; i < 3; i++) {
-	  printf("this should not happen\n");
-	  *(vert + nVertices * 3 + i) = 0;
-	}
-	nVertices++;
-	break;
-      case 'n': /* vertex normal */
-	hasNorms = 1;
-	if(nVertices >= MAX_N) {
-	  FAIL("normals limit exceeded\n") ;
-	}
-	c = sscanf(buf, "vn %f %f %f ", 
-		   norm + nNormals * 3,
-		   norm + nNormals * 3 + 1,
-		   norm + nNormals * 3 + 2);
-	for(i = c; i < 3; i++) {
-	  printf("this should not happen\n");
-	  *(norm + nNormals * 3 + i) = 0;
-	  break;
+	if(v < 0) v += nVertices + 1;
+	if(n < 0) n += nNormals + 1;
+	if(v < 1 || v > nVertices || n < 0 || n > nNormals)
+	  ok = 0;
+	fv = grow(fv, c, &maxFv, sizeof(int));
+	fn = grow(fn, c, &maxFn, sizeof(int));
+	fv[c] = v - 1;
+	fn[c] = n - 1;
+      }
+      if(!ok || c < 3) {
+	fprintf(stderr, "warning: ignored face at line %d\n", iLine + 1);
+	continue;
+      }
+      for(i = 0; i < c && fn[i] >= 0; i++)
+	;
+      if(i < c) {
+	/* no normals given: use the face normal */
+	for(l = 0; l < 3; l++) {
+	  t3[l] = vert[3 * fv[2] + l];
+	  t1[l] = vert[3 * fv[0] + l] - t3[l];
+	  t2[l] = vert[3 * fv[1] + l] - t3[l];
 	}
+	normcrossprod(t1, t2, t3);
+	norm = grow(norm, 3 * nNormals + 3, &maxNormals, sizeof(float));
+	memcpy(norm + 3 * nNormals, t3, sizeof(t3));
+	for(i = 0; i < c; i++)
+	  fn[i] = nNormals;
 	nNormals++;
-	break;
       }
-      break;
-    case 'f':
-      if(nFaces * MODEL_FACESIZE >= MAX_F) {
-	FAIL("face limit exceeded\n") ;
+      if(currentMat >= nParts) {
+	parts = realloc(parts, (currentMat + 1) * sizeof(PartBuilder));
+	memset(parts + nParts, 0, (currentMat + 1 - nParts) * sizeof(PartBuilder));
+	nParts = currentMat + 1;
+      }
+      addFace(parts + currentMat, fv, fn, c);
+      nFaces++;
+    } else if(isKeyword(p, end, "mtllib")) {
+      p += 6;
+      parseModelWord(&p, end, namebuf, sizeof(namebuf));
+      /* load material library */
+      matCount = loadMaterials(namebuf, &materials);
+      if(matCount <= 0) {
+	fprintf(stderr, "fatal: no Materials loaded\n");
+	exit(1);
       }
-      /* mark material */
-      *(matIndex + nFaces) = currentMat;
-      if(matCount > 0)
-	pMatCount[currentMat]++;
-
-      if(hasNorms) {
-	c = sscanf(buf, "f %d//%d %d//%d %d//%d %d//%d ",
-		   face + nFaces * MODEL_FACESIZE,
-		   normi + nFaces * MODEL_FACESIZE,
-		   face + nFaces * MODEL_FACESIZE + 1,
-		   normi + nFaces * MODEL_FACESIZE + 1,
-		   face + nFaces * MODEL_FACESIZE + 2,
-		   normi + nFaces * MODEL_FACESIZE + 2,
-		   face + nFaces * MODEL_FACESIZE + 3,
-		   normi + nFaces * MODEL_FACESIZE + 3);
-	for(i = c / 2; i < MODEL_FACESIZE; i++) {
-	  *(face + nFaces * MODEL_FACESIZE + i) = -1;
-	  *(normi + nFaces * MODEL_FACESIZE + i) = -1;
+      currentMat = 0;
+    } else if(isKeyword(p, end, "usemtl")) {
+      p += 6;
+      parseModelWord(&p, end, namebuf, sizeof(namebuf));
+      currentMat = 0;
+      for(i = 0; i < matCount; i++) {
+	if(strcmp(namebuf, (materials + i)->name) == 0) {
+	  currentMat = i;
+	  break;
 	}
-
-	nFaces++;
-      } else {
-	c = sscanf(buf, "f %d %d %d %d ",
-		   face + nFaces * MODEL_FACESIZE,
-		   face + nFaces * MODEL_FACESIZE + 1,
-		   face + nFaces * MODEL_FACESIZE + 2,
-		   face + nFaces * MODEL_FACESIZE + 3);
-	for(i = c; i < MODEL_FACESIZE; i++)
-	  *(face + nFaces * MODEL_FACESIZE + i) = -1;
-	nFaces++;
       }
-      break;
     }
-    iLine++;
+    /* ignore the rest: comments, texture coordinates, groups... */
   }
-  if(hasNorms == 0) {
-    /* create Normals */
-    for(i = 0; i < nFaces; i++) {
-      t1[0] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 0) - 1) + 0);
-      t1[1] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 0) - 1) + 1);
-      t1[2] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 0) - 1) + 2);
-
-      t2[0] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 1) - 1) + 0);
-      t2[1] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 1) - 1) + 1);
-      t2[2] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 1) - 1) + 2);
-
-      t3[0] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 2) - 1) + 0);
-      t3[1] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 2) - 1) + 1);
-      t3[2] = *(vert + 3 * (*(face + i * MODEL_FACESIZE + 2) - 1) + 2);
-      /*
-      printf("face %d:\n", i);
-      printf("v1: %f %f %f\n", t1[0], t1[1], t1[2]);
-      printf("v2: %f %f %f\n", t2[0], t2[1], t2[1]);
-      printf("v3: %f %f %f\n", t3[0], t3[1], t3[1]);
-      */
-      t1[0] -= t3[0];
-      t1[1] -= t3[1];
-      t1[2] -= t3[2];
-      t2[0] -= t3[0];
-      t2[1] -= t3[1];
-      t2[2] -= t3[2];
-      normcrossprod(t1, t2, t3);
-      /* printf("normal: %f %f %f\n\n", t3[0], t3[1], t3[2]); */
-      /* t3 now contains the face normal */
-      for(j = 0; j < MODEL_FACESIZE; j++) 
-	*(normi + i * MODEL_FACESIZE + j) = nNormals + 1;
-      *(norm + nNormals * 3 + 0) = t3[0];
-      *(norm + nNormals * 3 + 1) = t3[1];
-      *(norm + nNormals * 3 + 2) = t3[2];
-      nNormals++;
-    }
-    /* printf("generated %d normals\n", nNormals); */
-  }
-
+  free(copy);
+  free(fv);
+  free(fn);
 
   if(matCount == 0) { /* create Default material */
     float spec[] = { 0.77, 0.77, 0.77, 1.0 };
@@ -286,20 +375,21 @@ Mesh* loadModel(const char *filename, float size, int flags) {
     memcpy(materials->specular, spec, 3 * sizeof(float));
 
     matCount = 1;
-    pMatCount = (int*) malloc(sizeof(int));
-    pMatCount[0] = nFaces;
   }
-  /* everything is parsed, now allocate memory and */
-  /* rescale and get bbox */
-  /* copy data to Mesh structure */
-  /* new: sort into sub meshes with by materials */
+  if(nParts < matCount) {
+    parts = realloc(parts, matCount * sizeof(PartBuilder));
+    memset(parts + nParts, 0, (matCount - nParts) * sizeof(PartBuilder));
+    nParts = matCount;
+  }
+  /* everything is parsed, now rescale and get bbox, */
+  /* then copy the triangles of every material to the Mesh */
 
   if(flags & 1) { /* invert normals */
-    /* printf("inverting normals...really!\n"); */
     inv = -1;
   } else inv = 1;
 
   mesh = (Mesh*) malloc(sizeof(Mesh));
+  memset(mesh->bbox, 0, sizeof(mesh->bbox));
 
   /* rescale */
 
@@ -308,61 +398,233 @@ Mesh* loadModel(const char *filename, float size, int flags) {
   mesh->nFaces = nFaces;
   mesh->nMaterials = matCount;
   mesh->materials = materials;
+  mesh->binary = 0;
+  mesh->blob = NULL;
+  mesh->shared = NULL;
+  mesh->refs = 0;
   mesh->meshparts = (MeshPart*) malloc(matCount * sizeof(MeshPart));
+  mesh->bytes = sizeof(Mesh) + matCount * (sizeof(Material) + sizeof(MeshPart));
   for(i = 0; i < matCount; i++) {
-    meshVerts = (float*) malloc(pMatCount[i] * 3 * MODEL_FACESIZE * sizeof(float));
-    meshNorms = (float*) malloc(pMatCount[i] * 3 * MODEL_FACESIZE * sizeof(float));
-    meshFacesize = (int*) malloc(pMatCount[i] * sizeof(int));
-
-    /* printf("Material %d: %d faces\n", i, pMatCount[i]); */
-
-    (mesh->meshparts + i)->nFaces = pMatCount[i];
-    (mesh->meshparts + i)->vertices = meshVerts;
-    (mesh->meshparts + i)->normals = meshNorms;
-    (mesh->meshparts + i)->facesizes = meshFacesize;
-    pos = 0;
-    for(j = 0; j < nFaces; j++) { /* foreach face */
-      if(matIndex[j] == i) {
-	*(meshFacesize + pos) = 0;
-	/* printf("face %d\n", j); */
-	for(k = 0; k < MODEL_FACESIZE; k++) { /* foreach vertex of face */
-	  if(*(face + j * MODEL_FACESIZE + k) != -1) {
-	    *(meshFacesize + pos) += 1;
-	    /* adjust facesize... */
-	    /* copy face and normal data to meshVerts, meshNorms */
-	    vertex = vert + 3 * ( *(face + j * MODEL_FACESIZE + k) - 1);
-	    normal = norm + 3 * ( *(normi + j * MODEL_FACESIZE + k) - 1);
-	    for(l = 0; l < 3; l++) {
-	      /* printf("%f ", vertex[l]); */
-	      *(meshVerts + 3 * (pos * MODEL_FACESIZE + k) + l) = *(vertex + l);
-	      *(meshNorms + 3 * (pos * MODEL_FACESIZE + k) + l) = inv * *(normal + l);
-	    }
-	    /* printf("\n"); */
-	  }
-
-	}
-	pos++;
-	if(pos > pMatCount[i]) {
-	  fprintf(stderr, "fatal: more faces than accounted for\n");
-	  exit(1);
-	}
+    PartBuilder *b = parts + i;
+    MeshPart *part = mesh->meshparts + i;
+    float *out;
+
+    mesh->bytes += strlen(materials[i].name) + 1 + b->nFaces +
+      (b->nIndex / 2 * MESH_STRIDE + 1) * sizeof(float);
+
+    part->nFaces = b->nFaces;
+    part->nTriangles = b->nIndex / 6;
+    part->facetris = b->facetris ? b->facetris : malloc(1);
+    part->triangles = out =
+      (float*) malloc((b->nIndex / 2 * MESH_STRIDE + 1) * sizeof(float));
+    for(t = 0; t < b->nIndex; t += 2, out += MESH_STRIDE) {
+      /* copy normal and vertex data, interleaved */
+      for(j = 0; j < 3; j++) {
+	out[j] = inv * norm[3 * b->index[t + 1] + j];
+	out[3 + j] = vert[3 * b->index[t] + j];
       }
     }
+    free(b->index);
   }
-  
+  /* only if a later mtllib had fewer materials */
+  for(; i < nParts; i++) {
+    fprintf(stderr, "warning: dropped faces of material %d\n", i);
+    free(parts[i].index);
+    free(parts[i].facetris);
+  }
+
+  free(parts);
   free(vert);
-  free(face);
   free(norm);
-  free(normi);
-  free(pMatCount);
-  free(matIndex);
 
   /* printf("loaded model: %d vertices, %d normals, %d faces, %d materials\n",
 	nVertices, nNormals, nFaces, matCount); */
 
+  memAccount(MEM_MESH, mesh->bytes);
+  return mesh;
+}
+
+/* checks a binary mesh before anything points into it */
+static int meshValid(const unsigned char *data, size_t size,
+		     float scale, int flags) {
+  const MeshHeader *h = (const MeshHeader*) data;
+  const MeshFileMaterial *m = (const MeshFileMaterial*) (h + 1);
+  const unsigned char *facetris;
+  size_t tris;
+  int i, j;
+
+  if(size < sizeof(MeshHeader) || memcmp(h->magic, MESH_MAGIC, 8) != 0)
+    return 0;
+  /* built for another scale: the .obj is the authority */
+  if(h->size != scale || h->flags != flags)
+    return 0;
+  if(h->nMaterials <= 0 ||
+     (size_t) h->nMaterials > (size - sizeof(MeshHeader)) / sizeof(MeshFileMaterial))
+    return 0;
+  for(i = 0; i < h->nMaterials; i++) {
+    if(m[i].nFaces < 0 || m[i].nTriangles < 0 || m[i].triangles % 4 != 0 ||
+       m[i].facetris > size || (size_t) m[i].nFaces > size - m[i].facetris ||
+       m[i].triangles > size ||
+       (size_t) m[i].nTriangles > (size - m[i].triangles) /
+       (3 * MESH_STRIDE * sizeof(float)))
+      return 0;
+    /* the explosion walks the triangles face by face */
+    facetris = data + m[i].facetris;
+    for(j = 0, tris = 0; j < m[i].nFaces; j++)
+      tris += facetris[j];
+    if(tris != (size_t) m[i].nTriangles)
+      return 0;
+  }
+  return 1;
+}
+
+/* reads the precompiled mesh for filename (foo.obj -> foo.mesh) */
+static Mesh* loadModelBinary(const char *filename, float size, int flags) {
+  char name[120];
+  const unsigned char *data;
+  char *blob = NULL;
+  const MeshHeader *h;
+  const MeshFileMaterial *m;
+  size_t len;
+  char *dot;
+  Mesh *mesh;
+  int i;
+
+  if(strlen(filename) + 6 > sizeof(name))
+    return NULL;
+  strcpy(name, filename);
+  dot = strrchr(name, '.');
+  strcpy(dot ? dot : name + strlen(name), ".mesh");
+
+  data = (const unsigned char*) loadModelFile(name, &len, &blob);
+  if(data == NULL)
+    return NULL;
+
+  if(!meshValid(data, len, size, flags)) {
+    fprintf(stderr, "ignoring outdated or broken %s\n", name);
+    free(blob);
+    return NULL;
+  }
+
+  h = (const MeshHeader*) data;
+  m = (const MeshFileMaterial*) (h + 1);
+  mesh = (Mesh*) malloc(sizeof(Mesh));
+  mesh->nFaces = h->nFaces;
+  mesh->nMaterials = h->nMaterials;
+  memcpy(mesh->bbox, h->bbox, sizeof(mesh->bbox));
+  mesh->binary = 1;
+  mesh->blob = blob;
+  mesh->shared = NULL;
+  mesh->refs = 0;
+  /* materials get changed at runtime (player colors), so they are copied */
+  mesh->materials = (Material*) malloc(h->nMaterials * sizeof(Material));
+  mesh->meshparts = (MeshPart*) malloc(h->nMaterials * sizeof(MeshPart));
+  for(i = 0; i < h->nMaterials; i++) {
+    Material *mat = mesh->materials + i;
+    MeshPart *part = mesh->meshparts + i;
+
+    memcpy(mat->ambient, m[i].ambient, sizeof(mat->ambient));
+    memcpy(mat->diffuse, m[i].diffuse, sizeof(mat->diffuse));
+    memcpy(mat->specular, m[i].specular, sizeof(mat->specular));
+    mat->name = (char*) malloc(sizeof(m[i].name) + 1);
+    memcpy(mat->name, m[i].name, sizeof(m[i].name));
+    mat->name[sizeof(m[i].name)] = 0;
+
+    part->nFaces = m[i].nFaces;
+    part->nTriangles = m[i].nTriangles;
+    part->facetris = (unsigned char*) data + m[i].facetris;
+    part->triangles = (float*) (data + m[i].triangles);
+  }
+  /* the geometry is only ours if it isn't mapped from the pack */
+  mesh->bytes = sizeof(Mesh) + (blob ? len + 1 : 0) + h->nMaterials *
+    (sizeof(Material) + sizeof(m->name) + 1 + sizeof(MeshPart));
+  memAccount(MEM_MESH, mesh->bytes);
+  return mesh;
+}
+
+Mesh* loadModel(const char *filename, float size, int flags) {
+  Mesh *mesh = loadModelBinary(filename, size, flags);
+  if(mesh == NULL)
+    mesh = loadModelObj(filename, size, flags);
   return mesh;
 }
 
+/* models loaded by getModel(), one per file and loadModel() arguments */
+typedef struct ModelCache {
+  char *filename;
+  float size;
+  int flags;
+  Mesh *mesh;
+  struct ModelCache *next;
+} ModelCache;
+
+static ModelCache *modelCache = NULL;
+
+Mesh* getModel(const char *filename, float size, int flags) {
+  ModelCache *c;
+  Mesh *instance;
+
+  for(c = modelCache; c != NULL; c = c->next)
+    if(c->size == size && c->flags == flags &&
+       strcmp(c->filename, filename) == 0)
+      break;
+
+  if(c == NULL) {
+    Mesh *mesh = loadModel(filename, size, flags);
+    if(mesh == NULL)
+      return NULL;
+    c = (ModelCache*) malloc(sizeof(ModelCache));
+    c->filename = (char*) malloc(strlen(filename) + 1);
+    strcpy(c->filename, filename);
+    c->size = size;
+    c->flags = flags;
+    c->mesh = mesh;
+    c->next = modelCache;
+    modelCache = c;
+    memAccount(MEM_MESH, sizeof(ModelCache) + strlen(filename) + 1);
+  }
+
+  /* the geometry is shared, the materials are copied so every
+     instance can have its own colors; the names stay shared */
+  instance = (Mesh*) malloc(sizeof(Mesh));
+  memcpy(instance, c->mesh, sizeof(Mesh));
+  instance->materials = (Material*) malloc(c->mesh->nMaterials * sizeof(Material));
+  memcpy(instance->materials, c->mesh->materials,
+	 c->mesh->nMaterials * sizeof(Material));
+  instance->binary = 0;
+  instance->blob = NULL;
+  instance->shared = c->mesh;
+  instance->refs = 0;
+  instance->bytes = sizeof(Mesh) + c->mesh->nMaterials * sizeof(Material);
+  memAccount(MEM_MESH, instance->bytes);
+  c->mesh->refs++;
+  return instance;
+}
+
+/* drops an instance, and the cached mesh with its last instance */
+static void releaseModel(Mesh *instance) {
+  Mesh *mesh = instance->shared;
+  ModelCache **c;
+
+  memAccount(MEM_MESH, -(ptrdiff_t) instance->bytes);
+  free(instance->materials);
+  free(instance);
+  if(--mesh->refs > 0)
+    return;
+
+  for(c = &modelCache; *c != NULL; c = &(*c)->next)
+    if((*c)->mesh == mesh) {
+      ModelCache *dead = *c;
+      *c = dead->next;
+      memAccount(MEM_MESH, -(ptrdiff_t) (sizeof(ModelCache) +
+                                         strlen(dead->filename) + 1));
+      free(dead->filename);
+      free(dead);
+      break;
+    }
+  unloadModel(mesh);
+}
+
 void setMaterialAmbient(Mesh *mesh, int material, float color[4]) {
   if (!mesh || !mesh->materials || material < 0 || material >= mesh->nMaterials) {
 #ifdef ANDROID
@@ -405,15 +667,22 @@ void setMaterialAlphas(Mesh *mesh, float alpha) {
 
 void unloadModel(Mesh *mesh) {
   int i;
+  if(mesh->shared) {
+    releaseModel(mesh);
+    return;
+  }
+  memAccount(MEM_MESH, -(ptrdiff_t) mesh->bytes);
   for(i = 0; i < mesh->nMaterials; i++) {
     // free material
     free( (mesh->materials + i)->name );
-    free( (mesh->materials + i) );
-    // free meshpart
-    free( (mesh->meshparts + i)->facesizes );
-    free( (mesh->meshparts + i)->vertices );
-    free( (mesh->meshparts + i)->normals );
-    free( (mesh->meshparts + i) );
+    // free meshpart, unless it lives in the binary mesh
+    if(!mesh->binary) {
+      free( (mesh->meshparts + i)->facetris );
+      free( (mesh->meshparts + i)->triangles );
+    }
   }
+  free(mesh->materials);
+  free(mesh->meshparts);
+  free(mesh->blob);
+  free(mesh);
 }
-  
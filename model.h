@@ -1,6 +1,9 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define MODEL_USE_MATERIAL 1
 #define MODEL_DRAW_BBOX    2
 
@@ -14,24 +17,71 @@ typedef struct {
   char *name;
 } Material;
 
+/* faces are stored as triangle fans, ready for glDrawArrays(GL_TRIANGLES) */
+#define MESH_STRIDE 6 /* floats per vertex: normal, position (GL_N3F_V3F) */
+
 typedef struct {
   int nFaces;
-  int *facesizes;
-  float *vertices;
-  float *normals;
+  int nTriangles;
+  unsigned char *facetris; /* triangles of each face, for explosions */
+  float *triangles;        /* 3 * nTriangles vertices */
 } MeshPart;
 
-typedef struct {
+typedef struct Mesh {
   int nFaces;
   int nMaterials;
   Material *materials;
   MeshPart *meshparts;
   float bbox[3];
+  int binary;  /* parts point into a binary mesh instead of owning memory */
+  void *blob;  /* our copy of that mesh, NULL if it is mapped from the pack */
+  /* instances from getModel() have their own materials only */
+  struct Mesh *shared; /* the cached mesh holding the geometry */
+  int refs;            /* instances of a cached mesh */
+  size_t bytes;        /* what it accounts for under MEM_MESH */
 } Mesh;
 
+/*
+  binary meshes (.mesh), written by tools/mkmesh.c from an .obj that is
+  already scaled, normal-inverted and split by material:
+
+  MeshHeader | nMaterials * MeshFileMaterial | facetris | triangles
+
+  Offsets are from the start of the file, triangles are 16 byte aligned.
+*/
+#define MESH_MAGIC "GLTMESH1"
+
+typedef struct {
+  char magic[8];
+  float size;     /* loadModel() arguments the mesh was built with */
+  int32_t flags;
+  int32_t nFaces;
+  int32_t nMaterials;
+  float bbox[3];
+} MeshHeader;
+
+typedef struct {
+  char name[32];
+  float ambient[4];
+  float diffuse[4];
+  float specular[4];
+  int32_t nFaces;
+  int32_t nTriangles;
+  uint32_t facetris;
+  uint32_t triangles;
+} MeshFileMaterial;
+
 extern char* getFullPath(char* filename);
 extern int loadMaterials(char* filename, Material **materials);
 extern Mesh* loadModel(const char *filename, float size, int flags);
+extern Mesh* loadModelObj(const char *filename, float size, int flags);
+/* text parsing shared with the material loader */
+extern const char* loadModelFile(const char *filename, size_t *size, char **copy);
+extern const char* skipModelSpace(const char *s, const char *end);
+extern float parseModelFloat(const char **s, const char *end);
+extern int parseModelWord(const char **s, const char *end, char *buf, int size);
+/* instance of a cached model: shares the geometry, materials are its own */
+extern Mesh* getModel(const char *filename, float size, int flags);
 extern void unloadModel(Mesh *mesh);
 extern void drawModel(Mesh *mesh, int mode, int flag);
 extern void drawExplosion(Mesh *mesh, float radius, int mode, int flag);
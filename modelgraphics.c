@@ -8,46 +8,24 @@
 // Minimal unlit GLES2 renderer for Android
 static void drawMeshPart_unlit_android(Mesh *mesh, int part) {
   MeshPart *mp = mesh->meshparts + part;
-  if (!mp || !mp->facesizes) return;
-  int triCount = *(mp->facesizes);
-  if (triCount <= 0) return;
-  int vertCount = triCount * 3;
-
-  GLfloat *pos = (GLfloat*)malloc(sizeof(GLfloat) * vertCount * 3);
-  if (!pos) return;
-  int v = 0;
-  for (int i = 0; i < triCount; ++i) {
-    const GLfloat* base = mp->vertices + 9 * i;
-    pos[v++] = base[0]; pos[v++] = base[1]; pos[v++] = base[2];
-    pos[v++] = base[3]; pos[v++] = base[4]; pos[v++] = base[5];
-    pos[v++] = base[6]; pos[v++] = base[7]; pos[v++] = base[8];
-  }
+  if (!mp || !mp->triangles || mp->nTriangles <= 0) return;
 
   GLuint prog = shader_get_basic();
-  if (!prog) { free(pos); return; }
+  if (!prog) return;
   useShaderProgram(prog);
 
-  GLint colorLoc = glGetUniformLocation(prog, "color");
-  if (colorLoc >= 0)
-    glUniform4fv(colorLoc, 1, (mesh->materials + part)->diffuse);
-
-  GLuint vbo = 0;
-  glGenBuffers(1, &vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertCount * 3, pos, GL_STATIC_DRAW);
-
-  GLint positionLoc = glGetAttribLocation(prog, "position");
-  if (positionLoc >= 0) {
-    glEnableVertexAttribArray(positionLoc);
-    glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+  {
+    float *c = (mesh->materials + part)->diffuse;
+    setColor(prog, c[0], c[1], c[2], c[3]);
   }
 
-  glDrawArrays(GL_TRIANGLES, 0, vertCount);
-
-  if (positionLoc >= 0) glDisableVertexAttribArray(positionLoc);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  if (vbo) glDeleteBuffers(1, &vbo);
-  free(pos);
+  GLint positionLoc = glGetAttribLocation(prog, "position");
+  if (positionLoc < 0) return;
+  glEnableVertexAttribArray(positionLoc);
+  glVertexAttribPointer(positionLoc, 3, GL_FLOAT, GL_FALSE,
+                        MESH_STRIDE * sizeof(GLfloat), mp->triangles + 3);
+  glDrawArrays(GL_TRIANGLES, 0, 3 * mp->nTriangles);
+  glDisableVertexAttribArray(positionLoc);
 }
 
 void drawModel_unlit_android(Mesh *mesh) {
@@ -58,86 +36,46 @@ void drawModel_unlit_android(Mesh *mesh) {
 }
 #endif
 
+/* the whole part is one draw call over the interleaved triangles */
 void drawMeshPart(MeshPart* meshpart, int flag) {
-  int i, j;
-  int type, c;
-  float *normal;
-  float *vertex;
-
-  for(i = 0; i < meshpart->nFaces; i++) {
-    c = *(meshpart->facesizes + i);
-    type = 0;
+  if(meshpart->nTriangles <= 0)
+    return;
 
 #ifdef ANDROID
-    // OpenGL ES doesn't support GL_POLYGON, so we'll use GL_TRIANGLE_FAN instead
-    if(c > 4) type = GL_TRIANGLE_FAN;
-    if(c == 4) type = GL_TRIANGLE_FAN;  // Use triangle fan for quads
-    if(c == 3) type = GL_TRIANGLES;
-    if(flag & 1) type = GL_LINE_LOOP;
+  glEnableVertexAttribArray(0);  // Position
+  glEnableVertexAttribArray(1);  // Normal
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                        MESH_STRIDE * sizeof(GLfloat), meshpart->triangles + 3);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+                        MESH_STRIDE * sizeof(GLfloat), meshpart->triangles);
+
+  // GLES has no polygon mode, wireframe shows the triangle edges
+  if(flag & 1) {
+    int i;
+    for(i = 0; i < meshpart->nTriangles; i++)
+      glDrawArrays(GL_LINE_LOOP, 3 * i, 3);
+  } else
+    glDrawArrays(GL_TRIANGLES, 0, 3 * meshpart->nTriangles);
+
+  glDisableVertexAttribArray(0);
+  glDisableVertexAttribArray(1);
 #else
-    if(c > 4) type = GL_POLYGON;
-    if(c == 4) type = GL_QUADS;
-    if(c == 3) type = GL_TRIANGLES;
-    if(flag & 1) type = GL_LINE_LOOP;
-#endif
-
-    if(type != 0) {
-#ifdef ANDROID
-      // For Android, we need to use vertex arrays or VBOs
-      // This is a simplified version - you might want to use VBOs for better performance
-      GLfloat vertices[MODEL_FACESIZE * 3];
-      GLfloat normals[MODEL_FACESIZE * 3];
-
-      for(j = 0; j < c; j++) {
-        normal = meshpart->normals + 3 * (i * MODEL_FACESIZE + j);
-        vertex = meshpart->vertices + 3 * (i * MODEL_FACESIZE + j);
-
-        normals[j*3] = normal[0];
-        normals[j*3+1] = normal[1];
-        normals[j*3+2] = normal[2];
-
-        vertices[j*3] = vertex[0];
-        vertices[j*3+1] = vertex[1];
-        vertices[j*3+2] = vertex[2];
-      }
-
-      // Set up vertex attributes
-      glEnableVertexAttribArray(0);  // Position
-      glEnableVertexAttribArray(1);  // Normal
-
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, normals);
-
-      // Draw the geometry
-      if(type == GL_TRIANGLE_FAN) {
-        glDrawArrays(GL_TRIANGLE_FAN, 0, c);
-      } else {
-        glDrawArrays(type, 0, c);
-      }
-
-      // Disable attributes
-      glDisableVertexAttribArray(0);
-      glDisableVertexAttribArray(1);
-#else
-      // Desktop OpenGL - use immediate mode
-      glBegin(type);
-      for(j = 0; j < c; j++) {
-        normal = meshpart->normals + 3 * (i * MODEL_FACESIZE + j);
-        glNormal3fv(normal);
-        vertex = meshpart->vertices + 3 * (i * MODEL_FACESIZE + j);
-        glVertex3fv(vertex);
-      }
-      glEnd();
-#endif
-    }
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glInterleavedArrays(GL_N3F_V3F, 0, meshpart->triangles);
+  if(flag & 1) {
+    glPushAttrib(GL_POLYGON_BIT);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
   }
+  glDrawArrays(GL_TRIANGLES, 0, 3 * meshpart->nTriangles);
+  if(flag & 1)
+    glPopAttrib();
+  glPopClientAttrib();
+#endif
 }
 
 void drawExplosionPart(MeshPart* meshpart, float radius, int flag) {
-  int i, j;
-  int type, c;
+  int i, c, first;
   float *normal;
-  float *vertex;
 
 #define EXP_VECTORS 10
   float vectors[][3] = {
@@ -153,30 +91,32 @@ void drawExplosionPart(MeshPart* meshpart, float radius, int flag) {
     { -0.04, 0.04, 0.02 }
   };
 
-  for(i = 0; i < meshpart->nFaces; i++) {
-    c = *(meshpart->facesizes + i);
-    type = 0;
-
 #ifdef ANDROID
-    if(c > 4) type = GL_TRIANGLE_FAN;
-    if(c == 4) type = GL_TRIANGLE_FAN;
-    if(c == 3) type = GL_TRIANGLES;
-    if(flag & 1) type = GL_LINE_LOOP;
+  glEnableVertexAttribArray(0);  // Position
+  glEnableVertexAttribArray(1);  // Normal
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                        MESH_STRIDE * sizeof(GLfloat), meshpart->triangles + 3);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+                        MESH_STRIDE * sizeof(GLfloat), meshpart->triangles);
 #else
-    if(c > 4) type = GL_POLYGON;
-    if(c == 4) type = GL_QUADS;
-    if(c == 3) type = GL_TRIANGLES;
-    if(flag & 1) type = GL_LINE_LOOP;
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glInterleavedArrays(GL_N3F_V3F, 0, meshpart->triangles);
+  if(flag & 1) {
+    glPushAttrib(GL_POLYGON_BIT);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+  }
 #endif
 
-    if(type != 0) {
-#ifdef ANDROID
-      // For Android, we need to use vertex arrays or VBOs
-      GLfloat vertices[MODEL_FACESIZE * 3];
-      GLfloat normals[MODEL_FACESIZE * 3];
+  /* every face flies off on its own, along its first normal */
+  for(i = 0, first = 0; i < meshpart->nFaces; i++, first += 3 * c) {
+    c = meshpart->facetris[i];
+    if(c == 0)
+      continue;
+    normal = meshpart->triangles + MESH_STRIDE * first;
 
+#ifdef ANDROID
+    {
       // Calculate translation based on normal and explosion vector
-      normal = meshpart->normals + 3 * (i * MODEL_FACESIZE);
       float tx = radius * (normal[0] + vectors[i % EXP_VECTORS][0]);
       float ty = radius * (normal[1] + vectors[i % EXP_VECTORS][1]);
       float tz = radius * (normal[2] + vectors[i % EXP_VECTORS][2]);
@@ -191,69 +131,45 @@ void drawExplosionPart(MeshPart* meshpart, float radius, int flag) {
 
       // Set the model matrix in the shader
       extern GLuint shaderProgram; // Assuming this is defined elsewhere
-      GLint modelMatrixLoc = glGetUniformLocation(shaderProgram, "modelMatrix");
-      glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, modelMatrix);
-
-      // Prepare vertex data
-      for(j = 0; j < c; j++) {
-        normal = meshpart->normals + 3 * (i * MODEL_FACESIZE + j);
-        vertex = meshpart->vertices + 3 * (i * MODEL_FACESIZE + j);
-
-        normals[j*3] = normal[0];
-        normals[j*3+1] = normal[1];
-        normals[j*3+2] = normal[2];
-
-        vertices[j*3] = vertex[0];
-        vertices[j*3+1] = vertex[1];
-        vertices[j*3+2] = vertex[2];
-      }
-
-      // Set up vertex attributes
-      glEnableVertexAttribArray(0);  // Position
-      glEnableVertexAttribArray(1);  // Normal
-
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, vertices);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, normals);
-
-      // Draw the geometry
-      if(type == GL_TRIANGLE_FAN) {
-        glDrawArrays(GL_TRIANGLE_FAN, 0, c);
-      } else {
-        glDrawArrays(type, 0, c);
-      }
-
-      // Disable attributes
-      glDisableVertexAttribArray(0);
-      glDisableVertexAttribArray(1);
-
-      // Reset model matrix
-      GLfloat identityMatrix[16] = {
-        1, 0, 0, 0,
-        0, 1, 0, 0,
-        0, 0, 1, 0,
-        0, 0, 0, 1
-      };
-      glUniformMatrix4fv(modelMatrixLoc, 1, GL_FALSE, identityMatrix);
+      setModelMatrix(shaderProgram, modelMatrix);
+
+      if(flag & 1) {
+        int j;
+        for(j = 0; j < c; j++)
+          glDrawArrays(GL_LINE_LOOP, first + 3 * j, 3);
+      } else
+        glDrawArrays(GL_TRIANGLES, first, 3 * c);
+    }
 #else
-      // Desktop OpenGL - use immediate mode
-      glPushMatrix();
-      normal = meshpart->normals + 3 * (i * MODEL_FACESIZE);
-      glTranslatef(radius * (normal[0] + vectors[i % EXP_VECTORS][0]),
-                   radius * (normal[1] + vectors[i % EXP_VECTORS][1]),
-                   radius * (normal[2] + vectors[i % EXP_VECTORS][2]));
-
-      glBegin(type);
-      for(j = 0; j < c; j++) {
-        normal = meshpart->normals + 3 * (i * MODEL_FACESIZE + j);
-        glNormal3fv(normal);
-        vertex = meshpart->vertices + 3 * (i * MODEL_FACESIZE + j);
-        glVertex3fv(vertex);
-      }
-      glEnd();
-      glPopMatrix();
+    glPushMatrix();
+    glTranslatef(radius * (normal[0] + vectors[i % EXP_VECTORS][0]),
+                 radius * (normal[1] + vectors[i % EXP_VECTORS][1]),
+                 radius * (normal[2] + vectors[i % EXP_VECTORS][2]));
+    glDrawArrays(GL_TRIANGLES, first, 3 * c);
+    glPopMatrix();
 #endif
-    }
   }
+
+#ifdef ANDROID
+  glDisableVertexAttribArray(0);
+  glDisableVertexAttribArray(1);
+
+  {
+    // Reset model matrix
+    extern GLuint shaderProgram;
+    GLfloat identityMatrix[16] = {
+      1, 0, 0, 0,
+      0, 1, 0, 0,
+      0, 0, 1, 0,
+      0, 0, 0, 1
+    };
+    setModelMatrix(shaderProgram, identityMatrix);
+  }
+#else
+  if(flag & 1)
+    glPopAttrib();
+  glPopClientAttrib();
+#endif
 }
 
 void printColor(float *values, int count) {
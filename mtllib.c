@@ -1,39 +1,52 @@
-#define MAX_MATERIALS 100
-
 #include "model.h"
+#include "pack.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+static void parseColor(const char *s, const char *end, float *color) {
+  color[0] = parseModelFloat(&s, end);
+  color[1] = parseModelFloat(&s, end);
+  color[2] = parseModelFloat(&s, end);
+}
+
 int loadMaterials(char *filename, Material **materials) {
-  Material *m;
-  FILE *f;
-  char *resolved = NULL;
-  char buf[120];
+  Material *m = NULL;
+  const char *data, *p, *end, *line;
+  char *copy;
+  size_t len;
   char namebuf[120];
   int iMaterial = -1;
+  int maxMaterials = 0;
   int iLine = 0;
 
-  m = (Material *) malloc(MAX_MATERIALS * sizeof(Material));
-
-  resolved = getFullPath(filename);
-  if(!resolved) {
-    fprintf(stderr, "could not resolve file '%s'\n", filename);
+  data = loadModelFile(filename, &len, &copy);
+  if(!data) {
+    fprintf(stderr, "could not open file '%s'\n", filename);
     return -1;
   }
-  {
-    char *dup = strdup(resolved);
-    if(!dup) { fprintf(stderr, "out of memory duplicating path for '%s'\n", filename); return -1; }
-    f = fopen(dup, "rb");
-    if(!f) { fprintf(stderr, "could not open file '%s'\n", dup); free(dup); return -1; }
-    free(dup);
-  }
 
-  while(fgets(buf, sizeof(buf), f)) {
-    switch(buf[0]) {
+  for(p = data, end = data + len; p < end; iLine++) {
+    line = skipModelSpace(p, end);
+    for(p = line; p < end && *p != '\n'; p++)
+      ;
+    if(p < end)
+      p++;
+    if(line == end)
+      break;
+
+    switch(line[0]) {
     case 'n':
-      if(sscanf(buf, "newmtl %s ", namebuf) == 1) {
+      if(end - line > 7 && memcmp(line, "newmtl", 6) == 0 &&
+	 (line[6] == ' ' || line[6] == '\t')) {
+	const char *s = line + 6;
+	parseModelWord(&s, end, namebuf, sizeof(namebuf));
 	iMaterial++;
+	if(iMaterial >= maxMaterials) {
+	  maxMaterials = maxMaterials ? 2 * maxMaterials : 16;
+	  m = (Material*) realloc(m, maxMaterials * sizeof(Material));
+	}
+	memset(m + iMaterial, 0, sizeof(Material));
 	(m + iMaterial)->name = (char*) malloc(strlen(namebuf) + 1);
 	sprintf((m + iMaterial)->name, "%s", namebuf);
 	
@@ -45,23 +58,11 @@ int loadMaterials(char *filename, Material **materials) {
       }
       break;
     case 'K':
-      if(iMaterial >= 0) {
-	switch(buf[1]) {
-	case 'a': sscanf(buf, "Ka %f %f %f",
-			 (m + iMaterial)->ambient,
-			 (m + iMaterial)->ambient + 1,
-			 (m + iMaterial)->ambient + 2);
-	break;
-	case 'd': sscanf(buf, "Kd %f %f %f",
-			 (m + iMaterial)->diffuse,
-			 (m + iMaterial)->diffuse + 1,
-			 (m + iMaterial)->diffuse + 2);
-	break;
-	case 's': sscanf(buf, "Ks %f %f %f",
-			 (m + iMaterial)->specular,
-			 (m + iMaterial)->specular + 1,
-			 (m + iMaterial)->specular + 2);
-	break;
+      if(iMaterial >= 0 && end - line > 2) {
+	switch(line[1]) {
+	case 'a': parseColor(line + 2, end, (m + iMaterial)->ambient); break;
+	case 'd': parseColor(line + 2, end, (m + iMaterial)->diffuse); break;
+	case 's': parseColor(line + 2, end, (m + iMaterial)->specular); break;
 	default: 
 	  fprintf(stderr, "unknown light model at line %d\n", iLine);
 	  break;
@@ -70,24 +71,10 @@ int loadMaterials(char *filename, Material **materials) {
       break;
       /* ignore the rest... */
     }
-    iLine++;
   }
-  /* allocate the needed materials */
-  /* copy the data */
-  /* free the temporary memory */
+  free(copy);
+
   /* return number of materials */
-  *(materials) = (Material*) malloc((iMaterial + 1) * sizeof(Material));
-  memcpy(*materials, m, (iMaterial + 1) * sizeof(Material));
-  free(m);
+  *(materials) = m;
   return iMaterial + 1;
 }
-		       
-	
-
-    
-	
-	
-      
-			   
-  
-
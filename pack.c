@@ -0,0 +1,142 @@
+#include "gltron.h"
+#include "pack.h"
+#include <string.h>
+
+#ifdef ANDROID
+#include <android/asset_manager.h>
+extern AAssetManager* g_android_asset_mgr; /* android_glue.c */
+#elif !defined(WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const unsigned char *pack = NULL;
+static size_t pack_size = 0;
+static int pack_tried = 0;
+
+/* the table and every entry have to lie inside the mapping, and one slot
+   at least has to be empty so that the probing for a missing name ends */
+static int packValid(const unsigned char *p, size_t size) {
+  const PackHeader *h = (const PackHeader*) p;
+  const PackEntry *e = (const PackEntry*) (h + 1);
+  uint32_t i, used = 0;
+
+  if(size < sizeof(PackHeader) || memcmp(h->magic, PACK_MAGIC, 8) != 0)
+    return 0;
+  if(h->slots == 0 || (h->slots & (h->slots - 1)) != 0 ||
+     h->slots > (size - sizeof(PackHeader)) / sizeof(PackEntry))
+    return 0;
+  for(i = 0; i < h->slots; i++) {
+    if(e[i].name == 0)
+      continue;
+    if(e[i].name >= size || memchr(p + e[i].name, 0, size - e[i].name) == NULL ||
+       e[i].offset > size || e[i].size > size - e[i].offset)
+      return 0;
+    used++;
+  }
+  return used < h->slots;
+}
+
+static void packInit() {
+  pack_tried = 1;
+
+#ifdef ANDROID
+  /* stored uncompressed in the APK, so the buffer is mapped in place */
+  if(g_android_asset_mgr) {
+    AAsset *asset = AAssetManager_open(g_android_asset_mgr, PACK_NAME,
+                                       AASSET_MODE_BUFFER);
+    if(asset) {
+      pack = AAsset_getBuffer(asset);
+      pack_size = AAsset_getLength(asset);
+      /* the asset stays open as long as we use the buffer */
+    }
+  }
+#elif !defined(WIN32)
+  {
+    char *path = getFullPath(PACK_NAME);
+    struct stat st;
+    void *map;
+    int fd;
+
+    if(path == NULL)
+      return;
+    fd = open(path, O_RDONLY);
+    free(path);
+    if(fd < 0)
+      return;
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+      map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(map != MAP_FAILED) {
+        pack = map;
+        pack_size = st.st_size;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  if(pack && !packValid(pack, pack_size)) {
+    fprintf(stderr, "ignoring broken %s\n", PACK_NAME);
+    pack = NULL;
+  }
+  if(pack)
+    memAccount(MEM_PACK, pack_size);
+#ifdef ANDROID
+  __android_log_print(ANDROID_LOG_INFO, "gltron", "asset pack: %s",
+                      pack ? "mapped" : "not found, using single files");
+#else
+  if(pack)
+    printf("using asset pack %s (%d files)\n", PACK_NAME,
+           ((const PackHeader*) pack)->count);
+#endif
+}
+
+void initPack(void) {
+  if(!pack_tried)
+    packInit();
+}
+
+const void* packData(const char *name, size_t *size) {
+  const PackHeader *h;
+  const PackEntry *e;
+  uint32_t hash, i;
+
+  if(!pack_tried)
+    packInit();
+  if(pack == NULL)
+    return NULL;
+
+  h = (const PackHeader*) pack;
+  e = (const PackEntry*) (h + 1);
+  hash = packHash(name);
+  for(i = hash & (h->slots - 1); e[i].name != 0; i = (i + 1) & (h->slots - 1))
+    if(e[i].hash == hash && strcmp((const char*) pack + e[i].name, name) == 0) {
+      *size = e[i].size;
+      return pack + e[i].offset;
+    }
+  return NULL;
+}
+
+FILE* openAsset(const char *filename) {
+  char *path;
+  FILE *f;
+
+#ifndef WIN32
+  {
+    /* packed files are read straight from the mapping */
+    size_t size;
+    const void *data = packData(filename, &size);
+    if(data != NULL && size > 0)
+      return fmemopen((void*) data, size, "rb");
+  }
+#endif
+
+  path = getFullPath((char*) filename);
+  if(path == NULL)
+    return NULL;
+  f = fopen(path, "rb");
+  free(path);
+  return f;
+}
@@ -0,0 +1,53 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  gltron.pak: all read-only game data in one file, mapped once at
+  startup instead of probing the data directories for every asset.
+  Written by tools/mkpack.c, little endian like all our targets.
+
+  header | slots * PackEntry | names | data (PACK_ALIGN aligned)
+
+  The entries form an open addressing hash table keyed by file name;
+  an empty slot has name == 0.
+*/
+
+#define PACK_MAGIC "GLTPAK1"
+#define PACK_NAME "gltron.pak"
+#define PACK_ALIGN 16
+
+typedef struct PackHeader {
+  char magic[8];
+  uint32_t slots; /* power of two */
+  uint32_t count;
+} PackHeader;
+
+typedef struct PackEntry {
+  uint32_t hash;
+  uint32_t name;   /* offset of the file name from the start of the pack */
+  uint32_t offset; /* offset of the data */
+  uint32_t size;
+} PackEntry;
+
+/* FNV-1a */
+static inline uint32_t packHash(const char *name) {
+  uint32_t h = 2166136261u;
+  while(*name) {
+    h ^= (unsigned char) *name++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* maps the pack; done on first use otherwise, which isn't thread safe */
+extern void initPack(void);
+/* mapped contents of a packed file, NULL if it isn't in the pack */
+extern const void* packData(const char *name, size_t *size);
+/* opens a game data file for reading, from the pack or the data dirs */
+extern FILE* openAsset(const char *filename);
+
+#endif
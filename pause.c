@@ -22,6 +22,7 @@ void motionPause(int x, int y) {
 
 void mousePause(int button, int state, int x, int y) {
   if (game->settings->input_mode == 0) return; /* keyboard only */
+  redrawInput();
 #ifdef ANDROID
   if (button == 0) { // GLUT_LEFT_BUTTON
     if (state == 0) { // GLUT_DOWN
@@ -64,7 +65,6 @@ void idlePause() {
 #ifdef SOUND
   soundIdle();
 #endif
-  if(getElapsedTime() - lasttime < 10) return;
   timediff();
   
 #ifndef ANDROID
@@ -75,6 +75,7 @@ void idlePause() {
 void displayPause() {
   drawGame();
   drawPause(game->screen);
+  flushText(game->screen);
 
   if(game->settings->mouse_warp)
     mouseWarp();
@@ -84,6 +85,7 @@ void displayPause() {
 }
 
 void keyboardPause(unsigned char key, int x, int y) {
+  redrawInput();
   switch(key) {
   case 27:
 #ifdef ANDROID
@@ -111,6 +113,8 @@ void keyboardPause(unsigned char key, int x, int y) {
 void specialPause(int key, int x, int y) {
   int i;
 
+  redrawInput();
+
   switch(key) {
 #ifdef ANDROID
   case 102: // GLUT_KEY_F1
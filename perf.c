@@ -0,0 +1,350 @@
+/*
+  performance regression runs
+
+  Times the parts of the game that have to keep up, each on fixed seeds
+  and fixed data so that runs compare: all-AI rounds on the simulation
+  alone (engine.c and computer.c), loading the cycle model from the OBJ
+  and from the binary mesh, decoding the textures, and the world of a
+  stress scene with the null backend and drawn with GL. Every result is
+  a rate, higher is better, the median of PERF_REPEATS runs.
+
+  Every run of a rate is paired with a run of a fixed reference
+  workload, plain arithmetic that none of the game code touches, and
+  the rate is also kept as a ratio to it. A faster or slower machine, or
+  one that is busy for a while, moves both alike, so the ratios travel
+  between machines where the rates don't.
+
+  gltron --perf [--baseline=FILE [--record]] [--tolerance=PCT] [--seed=N]
+                [--capture=DIR]
+
+  With --baseline every ratio is compared to FILE and the run exits with
+  1 if any of them is more than PCT percent (default 25) below it; a
+  line of FILE can set its own tolerance in a fifth column. Without FILE
+  it exits with PERF_SKIPPED. --record writes FILE instead, and
+  --capture writes DIR/perf.csv as well.
+*/
+
+#include "gltron.h"
+#include "switchCallbacks.h"
+
+#ifdef CAPTURE
+
+#include <string.h>
+
+#define PERF_REPEATS 9
+#define PERF_ROUNDS 50
+#define PERF_TICK 10          /* ms, like the simulation thread's ticks */
+#define PERF_MAX_TICKS 100000 /* a round that doesn't end is cut off */
+#define PERF_LOADS 100
+#define PERF_FRAMES 200
+#define PERF_GL_FRAMES 20     /* a software GL takes a while per frame */
+#define PERF_RESULTS 16
+#define PERF_REF_SIZE 65536
+#define PERF_REF_PASSES 40
+
+typedef struct PerfResult {
+  char name[32];
+  double rate;
+  char unit[16];
+  double ratio;     /* to the reference workload */
+  double tolerance; /* percent, baselines only; < 0 for the default */
+} PerfResult;
+
+static int perfing = 0;
+static char *perf_baseline = NULL;
+static int perf_record = 0;
+static double perf_tolerance = 25;
+
+static PerfResult results[PERF_RESULTS];
+static int nResults = 0;
+
+/* keeps the compiler from dropping the reference workload */
+static volatile float perf_sink;
+
+int perfArg(char *arg) {
+  if(strcmp(arg, "--perf") == 0)
+    ;
+  else if(strncmp(arg, "--baseline=", 11) == 0)
+    perf_baseline = arg + 11;
+  else if(strcmp(arg, "--record") == 0)
+    perf_record = 1;
+  else if(strncmp(arg, "--tolerance=", 12) == 0) {
+    perf_tolerance = atof(arg + 12);
+    if(perf_tolerance <= 0) {
+      fprintf(stderr, "perf: --tolerance must be positive\n");
+      exit(1);
+    }
+  } else
+    return 0;
+
+  perfing = 1;
+  return 1;
+}
+
+int perfEnabled() {
+  return perfing;
+}
+
+static int compareRates(const void *a, const void *b) {
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+/* the median keeps one slow or lucky run from setting the result */
+static double median(double *rates) {
+  qsort(rates, PERF_REPEATS, sizeof(double), compareRates);
+  return rates[PERF_REPEATS / 2];
+}
+
+/* a fixed amount of arithmetic over a buffer, passes per second */
+static double reference(void) {
+  static float buf[PERF_REF_SIZE];
+  unsigned int x = 1;
+  float sum = 0;
+  double t;
+  int i, pass;
+
+  memset(buf, 0, sizeof(buf));
+  t = captureMs();
+  for(pass = 0; pass < PERF_REF_PASSES; pass++)
+    for(i = 0; i < PERF_REF_SIZE; i++) {
+      x = x * 1103515245u + 12345u;
+      buf[i] = buf[i] * 0.5f + (x >> 16) * (1 / 65536.0f);
+      sum += buf[i];
+    }
+  perf_sink = sum;
+  return PERF_REF_PASSES * 1000.0 / (captureMs() - t);
+}
+
+/* rates and the reference rates measured right after each of them */
+static void addResult(const char *name, double *rates, double *refs,
+                      const char *unit) {
+  double ratios[PERF_REPEATS];
+  PerfResult *r;
+  int i;
+
+  if(nResults == PERF_RESULTS)
+    return;
+  for(i = 0; i < PERF_REPEATS; i++)
+    ratios[i] = rates[i] / refs[i];
+  r = results + nResults++;
+  snprintf(r->name, sizeof(r->name), "%s", name);
+  snprintf(r->unit, sizeof(r->unit), "%s", unit);
+  r->rate = median(rates);
+  r->ratio = median(ratios);
+  r->tolerance = -1;
+  printf("perf: %-14s %12.1f %-9s ratio %g\n", name, r->rate, unit,
+         r->ratio);
+}
+
+/* all-AI rounds without drawing, ticks and rounds per second */
+static void simRounds(unsigned int seed, double *ticks_s, double *rounds_s,
+                      int *wins) {
+  double t = 0, start;
+  int round, n, ticks = 0;
+
+  srand(seed);
+  for(round = 0; round < PERF_ROUNDS; round++) {
+    initData();
+    switchCallbacks(&gameCallbacks);
+    start = captureMs();
+    for(n = 0; current_callback == &gameCallbacks && n < PERF_MAX_TICKS; n++)
+      simTick(PERF_TICK);
+    t += captureMs() - start;
+    ticks += n;
+    if(current_callback == &gameCallbacks)
+      fprintf(stderr, "perf: round %d didn't finish\n", round);
+    else if(game->winner >= 0 && game->winner < game->players)
+      wins[game->winner]++;
+  }
+  *ticks_s = ticks * 1000.0 / t;
+  *rounds_s = PERF_ROUNDS * 1000.0 / t;
+}
+
+static void perfSim(unsigned int seed) {
+  double ticks_s[PERF_REPEATS], rounds_s[PERF_REPEATS], refs[PERF_REPEATS];
+  int wins[MAX_PLAYERS];
+  int i, r;
+
+  for(r = 0; r < PERF_REPEATS; r++) {
+    memset(wins, 0, sizeof(wins));
+    simRounds(seed, ticks_s + r, rounds_s + r, wins);
+    refs[r] = reference();
+  }
+  /* the same seed plays the same rounds, the tally shows when it doesn't */
+  printf("perf: %d rounds, wins", PERF_ROUNDS);
+  for(i = 0; i < game->players; i++)
+    printf(" %d", wins[i]);
+  printf("\n");
+  addResult("sim_ticks", ticks_s, refs, "ticks/s");
+  addResult("ai_rounds", rounds_s, refs, "rounds/s");
+}
+
+static void perfModel(void) {
+  double t, obj[PERF_REPEATS], bin[PERF_REPEATS];
+  double obj_refs[PERF_REPEATS], bin_refs[PERF_REPEATS];
+  Mesh *mesh;
+  int i, r, binary = 0;
+
+  for(r = 0; r < PERF_REPEATS; r++) {
+    t = captureMs();
+    for(i = 0; i < PERF_LOADS; i++) {
+      mesh = loadModelObj("t-u-low.obj", CYCLE_HEIGHT, 1);
+      if(mesh == NULL) {
+        fprintf(stderr, "perf: can't load t-u-low.obj\n");
+        return;
+      }
+      unloadModel(mesh);
+    }
+    obj[r] = PERF_LOADS * 1000.0 / (captureMs() - t);
+    obj_refs[r] = reference();
+
+    t = captureMs();
+    for(i = 0; i < PERF_LOADS; i++) {
+      mesh = loadModel("t-u-low.obj", CYCLE_HEIGHT, 1);
+      if(mesh == NULL)
+        return;
+      binary = mesh->binary;
+      unloadModel(mesh);
+    }
+    bin[r] = PERF_LOADS * 1000.0 / (captureMs() - t);
+    bin_refs[r] = reference();
+  }
+  addResult("model_obj", obj, obj_refs, "loads/s");
+  /* without t-u-low.mesh loadModel() parses the OBJ as well */
+  if(binary)
+    addResult("model_mesh", bin, bin_refs, "loads/s");
+}
+
+static void perfTextures(void) {
+  static char *names[] = {
+    "gltron_floor.sgi", "gltron.sgi", "gltron_wall.sgi", "gltron_crash.sgi"
+  };
+  sgi_texture *tex;
+  double t, rates[PERF_REPEATS], refs[PERF_REPEATS];
+  size_t bytes;
+  int i, j, r;
+
+  for(r = 0; r < PERF_REPEATS; r++) {
+    bytes = 0;
+    t = captureMs();
+    for(i = 0; i < PERF_LOADS; i++)
+      for(j = 0; j < 4; j++) {
+        tex = load_sgi_texture(names[j]);
+        if(tex == NULL)
+          return;
+        bytes += (size_t) tex->width * tex->height * tex->channels;
+        unload_sgi_texture(tex);
+      }
+    rates[r] = bytes / 1000.0 / (captureMs() - t);
+    refs[r] = reference();
+  }
+  addResult("textures", rates, refs, "MB/s");
+}
+
+static void perfWorld(void) {
+  double null_fps[PERF_REPEATS], gl_fps[PERF_REPEATS];
+  double null_refs[PERF_REPEATS], gl_refs[PERF_REPEATS];
+  int r;
+
+  /* every player with a full trail, two of them crashing, split 4 ways */
+  for(r = 0; r < PERF_REPEATS; r++) {
+    null_fps[r] = 1000.0 /
+      stressMs(MAX_PLAYERS, MAX_TRAIL - 1, 2, 4, PERF_FRAMES, 1);
+    null_refs[r] = reference();
+    gl_fps[r] = 1000.0 /
+      stressMs(MAX_PLAYERS, MAX_TRAIL - 1, 2, 4, PERF_GL_FRAMES, 0);
+    gl_refs[r] = reference();
+  }
+  addResult("world_null", null_fps, null_refs, "frames/s");
+  addResult("world_gl", gl_fps, gl_refs, "frames/s");
+}
+
+static int writeResults(const char *name) {
+  FILE *f;
+  int i;
+
+  f = fopen(name, "w");
+  if(f == NULL) {
+    fprintf(stderr, "perf: can't write %s\n", name);
+    return 0;
+  }
+  fprintf(f, "name,rate,unit,ratio,tolerance\n");
+  for(i = 0; i < nResults; i++)
+    fprintf(f, "%s,%.1f,%s,%.6g,\n", results[i].name, results[i].rate,
+            results[i].unit, results[i].ratio);
+  fclose(f);
+  return 1;
+}
+
+/* the number of ratios too far below their baseline, -1 without one */
+static int compareResults(const char *name) {
+  PerfResult base;
+  char line[256];
+  FILE *f;
+  int i, found, failed = 0;
+
+  f = fopen(name, "r");
+  if(f == NULL)
+    return -1;
+  printf("perf: against %s\n", name);
+  while(fgets(line, sizeof(line), f) != NULL) {
+    base.tolerance = -1;
+    if(sscanf(line, "%31[^,],%lf,%15[^,],%lf,%lf", base.name, &base.rate,
+              base.unit, &base.ratio, &base.tolerance) < 4 ||
+       base.ratio <= 0)
+      continue; /* the header */
+    if(base.tolerance <= 0)
+      base.tolerance = perf_tolerance;
+
+    found = 0;
+    for(i = 0; i < nResults; i++)
+      if(strcmp(results[i].name, base.name) == 0) {
+        double change = (results[i].ratio / base.ratio - 1) * 100;
+        int slower = change < -base.tolerance;
+
+        printf("perf: %-14s %+6.1f%% %s\n", base.name, change,
+               slower ? "REGRESSED" : "ok");
+        failed += slower;
+        found = 1;
+      }
+    if(!found)
+      printf("perf: %-14s not measured\n", base.name);
+  }
+  fclose(f);
+  return failed;
+}
+
+int runPerf(const char *dir, unsigned int seed) {
+  char name[1024];
+  int failed = 0;
+
+  printf("perf: seed %u, median of %d\n", seed, PERF_REPEATS);
+  game->settings->fast_finish = 0; /* one step per tick */
+
+  perfSim(seed);
+  perfModel();
+  perfTextures();
+  perfWorld();
+
+  if(dir != NULL) {
+    snprintf(name, sizeof(name), "%s%cperf.csv", dir, SEPERATOR);
+    writeResults(name);
+  }
+  if(perf_baseline == NULL)
+    return 0;
+  if(perf_record) {
+    printf("perf: recording %s\n", perf_baseline);
+    return !writeResults(perf_baseline);
+  }
+  failed = compareResults(perf_baseline);
+  if(failed < 0) {
+    printf("perf: no baseline %s, record one with --record\n", perf_baseline);
+    return PERF_SKIPPED;
+  }
+  if(failed > 0)
+    printf("perf: %d rates regressed\n", failed);
+  return failed != 0;
+}
+
+#endif
@@ -0,0 +1,238 @@
+/*
+  render pass profiler
+
+  drawCam() marks which pass it is in with profilePass(); each pass is
+  timed on the CPU and, where timer queries exist, on the GPU. A query
+  result is only read once the GPU says it's there, a few frames later,
+  so measuring never stalls the pipeline. Frames whose results didn't
+  arrive before their queries are needed again are dropped.
+
+  Timing runs while the FPS display is on and in captures. GPU times
+  need GL 3.3 or GL_ARB_timer_query on the desktop and
+  GL_EXT_disjoint_timer_query on GLES; without them only the CPU side
+  is measured.
+*/
+
+/* GL 3.3 entry points from the desktop headers */
+#define GL_GLEXT_PROTOTYPES
+#include "gltron.h"
+#include <string.h>
+
+/* frames in flight before their queries are reused */
+#define PROFILE_FRAMES 4
+/* passes started per frame, one set for every viewport */
+#define PROFILE_QUERIES 64
+#define PROFILE_SMOOTH 0.1
+
+#if defined(WIN32) || defined(__APPLE__)
+/* opengl32.dll only exports GL 1.1, the OS X headers lack GL 3.3 */
+#define NO_TIMER_QUERY
+#elif defined(ANDROID)
+static PFNGLGENQUERIESEXTPROC genQueries;
+static PFNGLBEGINQUERYEXTPROC beginQuery;
+static PFNGLENDQUERYEXTPROC endQuery;
+static PFNGLGETQUERYOBJECTUIVEXTPROC getQueryObjectuiv;
+static PFNGLGETQUERYOBJECTUI64VEXTPROC getQueryObjectui64v;
+#define TIME_ELAPSED GL_TIME_ELAPSED_EXT
+#define QUERY_RESULT GL_QUERY_RESULT_EXT
+#define QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE_EXT
+#else
+#define genQueries glGenQueries
+#define beginQuery glBeginQuery
+#define endQuery glEndQuery
+#define getQueryObjectuiv glGetQueryObjectuiv
+#define getQueryObjectui64v glGetQueryObjectui64v
+#define TIME_ELAPSED GL_TIME_ELAPSED
+#define QUERY_RESULT GL_QUERY_RESULT
+#define QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE
+#endif
+
+static const char *names[PASSES] = {
+  "floor", "walls", "trails", "cycles", "explosions", "glow"
+};
+
+typedef struct ProfileFrame {
+  int count;     /* queries started */
+  int overflow;  /* ran out of queries, the GPU times are incomplete */
+  int pending;   /* results not read yet */
+  GLuint query[PROFILE_QUERIES];
+  unsigned char pass[PROFILE_QUERIES];
+} ProfileFrame;
+
+static ProfileFrame frames[PROFILE_FRAMES];
+static int current = 0;        /* frame being recorded */
+static int recording = 0;      /* something was timed in it */
+static int running = PASS_NONE;
+static int gpu = 0;            /* 1: timer queries, -1: none */
+static double started;
+static double cpu[PASSES], cpu_last[PASSES], cpu_avg[PASSES];
+static double gpu_last[PASSES], gpu_avg[PASSES];
+
+static int enabled(void) {
+  return game->settings->show_fps || capturing;
+}
+
+static int timerQueries(void) {
+#ifdef NO_TIMER_QUERY
+  return 0;
+#else
+  const char *extensions = (const char*) glGetString(GL_EXTENSIONS);
+  int i;
+
+#ifdef ANDROID
+  if(extensions == NULL || !strstr(extensions, "GL_EXT_disjoint_timer_query"))
+    return 0;
+  genQueries = (PFNGLGENQUERIESEXTPROC) eglGetProcAddress("glGenQueriesEXT");
+  beginQuery = (PFNGLBEGINQUERYEXTPROC) eglGetProcAddress("glBeginQueryEXT");
+  endQuery = (PFNGLENDQUERYEXTPROC) eglGetProcAddress("glEndQueryEXT");
+  getQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)
+    eglGetProcAddress("glGetQueryObjectuivEXT");
+  getQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)
+    eglGetProcAddress("glGetQueryObjectui64vEXT");
+  if(!genQueries || !beginQuery || !endQuery ||
+     !getQueryObjectuiv || !getQueryObjectui64v)
+    return 0;
+  /* clear a disjoint event from before we started */
+  {
+    GLint disjoint;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+  }
+#else
+  const char *version = (const char*) glGetString(GL_VERSION);
+  int major = 0, minor = 0;
+  GLint bits = 0;
+
+  if(version)
+    sscanf(version, "%d.%d", &major, &minor);
+  if(major * 10 + minor < 33 &&
+     (extensions == NULL || !strstr(extensions, "GL_ARB_timer_query")))
+    return 0;
+  glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+  if(bits == 0)
+    return 0;
+#endif
+
+  for(i = 0; i < PROFILE_FRAMES; i++)
+    genQueries(PROFILE_QUERIES, frames[i].query);
+  return glGetError() == GL_NO_ERROR;
+#endif
+}
+
+/* reads the frames whose results are there, oldest first */
+static void collect(void) {
+#ifndef NO_TIMER_QUERY
+  double sum[PASSES];
+  int i, k, n;
+
+  for(n = 1; n <= PROFILE_FRAMES; n++) {
+    ProfileFrame *f = frames + (current + n) % PROFILE_FRAMES;
+    GLuint available = 0;
+    GLuint64 ns;
+
+    if(!f->pending)
+      continue;
+    /* queries finish in order, the last one covers the frame */
+    getQueryObjectuiv(f->query[f->count - 1], QUERY_RESULT_AVAILABLE,
+                      &available);
+    if(!available)
+      return;
+    f->pending = 0;
+
+    memset(sum, 0, sizeof(sum));
+    for(k = 0; k < f->count; k++) {
+      getQueryObjectui64v(f->query[k], QUERY_RESULT, &ns);
+      sum[f->pass[k]] += ns / 1000000.0;
+    }
+#ifdef ANDROID
+    {
+      /* a frequency change or the like, the results are garbage */
+      GLint disjoint = 0;
+      glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+      if(disjoint)
+        continue;
+    }
+#endif
+    if(f->overflow)
+      continue;
+    for(i = 0; i < PASSES; i++) {
+      gpu_last[i] = sum[i];
+      gpu_avg[i] += (sum[i] - gpu_avg[i]) * PROFILE_SMOOTH;
+    }
+  }
+#endif
+}
+
+int profilePass(int pass) {
+  int previous = running;
+  double now;
+
+  if(running == PASS_NONE && (pass == PASS_NONE || !enabled()))
+    return previous;
+
+  now = frameClock();
+  if(running != PASS_NONE) {
+    cpu[running] += now - started;
+#ifndef NO_TIMER_QUERY
+    if(gpu > 0 && frames[current].count > 0 && !frames[current].overflow)
+      endQuery(TIME_ELAPSED);
+#endif
+  }
+  running = pass;
+  if(pass == PASS_NONE || !enabled()) {
+    running = PASS_NONE;
+    return previous;
+  }
+
+  if(gpu == 0)
+    gpu = timerQueries() ? 1 : -1;
+  recording = 1;
+  started = now;
+#ifndef NO_TIMER_QUERY
+  if(gpu > 0) {
+    ProfileFrame *f = frames + current;
+    if(f->count < PROFILE_QUERIES) {
+      f->pass[f->count] = pass;
+      beginQuery(TIME_ELAPSED, f->query[f->count++]);
+    } else
+      f->overflow = 1;
+  }
+#endif
+  return previous;
+}
+
+void profileFrame(void) {
+  ProfileFrame *f;
+  int i;
+
+  profilePass(PASS_NONE);
+  if(recording) {
+    for(i = 0; i < PASSES; i++) {
+      cpu_last[i] = cpu[i];
+      cpu_avg[i] += (cpu[i] - cpu_avg[i]) * PROFILE_SMOOTH;
+      cpu[i] = 0;
+    }
+    frames[current].pending = frames[current].count > 0;
+    current = (current + 1) % PROFILE_FRAMES;
+    recording = 0;
+
+    /* still not there after PROFILE_FRAMES frames: lost */
+    f = frames + current;
+    f->pending = 0;
+    f->count = 0;
+    f->overflow = 0;
+  }
+  if(gpu > 0)
+    collect();
+}
+
+const char* profileName(int pass) {
+  return names[pass];
+}
+
+void profileTimes(int smoothed, double *cpu_ms, double *gpu_ms) {
+  int i;
+  for(i = 0; i < PASSES; i++) {
+    cpu_ms[i] = smoothed ? cpu_avg[i] : cpu_last[i];
+    gpu_ms[i] = gpu <= 0 ? -1 : smoothed ? gpu_avg[i] : gpu_last[i];
+  }
+}
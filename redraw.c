@@ -0,0 +1,91 @@
+/*
+  on-demand redraw for the menu and pause screens
+
+  Those screens only animate for a while after the last input, then
+  come to rest on a still frame. While at rest nothing is drawn: GLUT
+  sleeps until the next event (waking up only to feed the music mixer)
+  and the Android loop blocks in ALooper_pollOnce().
+
+  The game screen isn't affected, it keeps its idle callback.
+*/
+
+#include "gltron.h"
+
+/* how long the screens keep animating after the last input */
+#define REDRAW_SETTLE_MS 10000
+/* frame time while animating */
+#define REDRAW_FRAME_MS 16
+/* MikMod has to be updated regularly even when nothing is drawn */
+#define REDRAW_SOUND_MS 20
+
+enum { REDRAW_OFF, REDRAW_ANIMATING, REDRAW_RESTING };
+
+static int state = REDRAW_OFF;
+static int last_input = 0;
+
+#ifndef ANDROID
+extern callbacks *current_callback;
+static int timer = 0;
+
+static void schedule(void);
+
+static void redrawTimer(int unused) {
+  timer = 0;
+  if(state == REDRAW_OFF)
+    return;
+  if(state == REDRAW_ANIMATING)
+    current_callback->idle();
+#ifdef SOUND
+  else
+    soundIdle();
+#endif
+  schedule();
+}
+
+/* glutTimerFunc() can't be cancelled, so there is at most one pending */
+static void schedule(void) {
+  if(timer || state == REDRAW_OFF)
+    return;
+  if(state == REDRAW_ANIMATING)
+    glutTimerFunc(REDRAW_FRAME_MS, redrawTimer, 0);
+#ifdef SOUND
+  else if(game->settings->playSound)
+    glutTimerFunc(REDRAW_SOUND_MS, redrawTimer, 0);
+#endif
+  else
+    return;
+  timer = 1;
+}
+#endif
+
+int redrawOnDemand(callbacks *screen) {
+  state = (screen == &guiCallbacks || screen == &pauseCallbacks) ?
+    REDRAW_ANIMATING : REDRAW_OFF;
+  redrawInput();
+  return state != REDRAW_OFF;
+}
+
+void redrawInput(void) {
+  if(state == REDRAW_OFF)
+    return;
+  state = REDRAW_ANIMATING;
+  last_input = getElapsedTime();
+#ifndef ANDROID
+  glutPostRedisplay();
+  schedule();
+#endif
+}
+
+int redrawSettled(void) {
+  return state != REDRAW_ANIMATING ||
+    getElapsedTime() - last_input >= REDRAW_SETTLE_MS;
+}
+
+void redrawRest(void) {
+  if(state == REDRAW_ANIMATING)
+    state = REDRAW_RESTING;
+}
+
+int redrawTimeout(void) {
+  return state == REDRAW_RESTING ? -1 : 0;
+}
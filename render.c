@@ -0,0 +1,214 @@
+/*
+  render command list
+
+  Draws from prepared vertex buffers are queued as commands (state,
+  buffer range, uniforms) instead of going to GL right away. On
+  renderSubmit() the opaque ones are sorted by program, texture and
+  blend state, so each state is set once for all draws using it, and
+  the blended ones follow in the order they were queued, which their
+  look depends on.
+
+  The sorted list goes to a backend: the GL one draws it, the null one
+  only walks it, so the traversal and batching can be timed on machines
+  without a GPU (see --null in stress.c). Both count the commands and
+  state changes the same way.
+*/
+
+#include "gltron.h"
+#include "shaders.h"
+#include <string.h>
+
+typedef struct RenderBackend {
+  void (*state)(const RenderState *s, const RenderState *last);
+  void (*draw)(const RenderCmd *c);
+  /* leaves GL in the default state, see renderSubmit() */
+  void (*end)(void);
+} RenderBackend;
+
+static RenderCmd *cmds = NULL;
+static int cmd_count = 0;
+static int cmd_size = 0;
+static int commands = 0, changes = 0;
+
+/* opaque draws sort by state, blended ones stay in order behind them.
+   IDs are truncated, a collision only means fewer draws share a state
+   change, the state itself is compared in full on submission. */
+static unsigned int renderKey(const RenderState *s) {
+  if(s->blend)
+    return 0x80000000u;
+  return (s->program & 0xfff) << 18 | (s->texture & 0xfff) << 6 |
+    (s->sfactor == GL_ONE) << 1 | (s->dfactor == GL_ONE);
+}
+
+static int sameState(const RenderState *a, const RenderState *b) {
+  return a->buffer == b->buffer && a->program == b->program &&
+    a->texture == b->texture && a->blend == b->blend &&
+    a->sfactor == b->sfactor && a->dfactor == b->dfactor;
+}
+
+static int compareCmds(const void *a, const void *b) {
+  const RenderCmd *x = a, *y = b;
+  if(x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return x->seq - y->seq;
+}
+
+/* GL backend */
+
+#ifdef ANDROID
+static GLint position_loc = -1, normal_loc = -1;
+static GLuint white = 0;
+#endif
+
+static void gpuState(const RenderState *s, const RenderState *last) {
+#ifdef ANDROID
+  if(last == NULL || s->program != last->program) {
+    useShaderProgram(s->program);
+    /* the buffers hold world space vertices */
+    setRenderMode2D(s->program, 0);
+    setIdentityMatrix(s->program, MATRIX_MODEL);
+    setTexture(s->program, 0);
+    if(position_loc >= 0)
+      glDisableVertexAttribArray(position_loc);
+    position_loc = glGetAttribLocation(s->program, "position");
+    normal_loc = glGetAttribLocation(s->program, "normal");
+    last = NULL;
+  }
+  if(last == NULL || s->texture != last->texture) {
+    /* untextured draws sample a white texel */
+    if(s->texture == 0 && white == 0)
+      white = createWhiteTexture();
+    setActiveTexture(GL_TEXTURE0);
+    bindTexture2D(s->texture ? s->texture : white);
+  }
+  if(last == NULL || s->buffer != last->buffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, s->buffer->vbo);
+    if(position_loc >= 0) {
+      glEnableVertexAttribArray(position_loc);
+      glVertexAttribPointer(position_loc, 3, GL_FLOAT, GL_FALSE,
+                            s->buffer->stride * sizeof(GLfloat), 0);
+    }
+  }
+#else
+  if(last == NULL || s->buffer != last->buffer) {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, s->buffer->stride * sizeof(GLfloat),
+                    s->buffer->verts);
+    glColorPointer(4, GL_FLOAT, s->buffer->stride * sizeof(GLfloat),
+                   s->buffer->verts + 3);
+  }
+#endif
+  if(last == NULL || s->blend != last->blend)
+    setBlend(s->blend);
+  if(last == NULL || s->sfactor != last->sfactor ||
+     s->dfactor != last->dfactor)
+    setBlendFunc(s->sfactor, s->dfactor);
+}
+
+static void gpuDraw(const RenderCmd *c) {
+#ifdef ANDROID
+  /* no per-vertex colours in the GLES shader */
+  setColor(c->state.program, c->color[0], c->color[1], c->color[2],
+           c->color[3]);
+  if(normal_loc >= 0)
+    glVertexAttrib3f(normal_loc, c->normal[0], c->normal[1], c->normal[2]);
+#endif
+  glDrawArrays(c->mode, c->first, c->count);
+}
+
+static void gpuEnd(void) {
+#ifdef ANDROID
+  if(position_loc >= 0)
+    glDisableVertexAttribArray(position_loc);
+  position_loc = -1;
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+#else
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+#endif
+  setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  setBlend(game->settings->show_alpha == 1);
+}
+
+/* null backend, renderSubmit() still counts the polygons */
+
+static void nullState(const RenderState *s, const RenderState *last) {
+}
+
+static void nullDraw(const RenderCmd *c) {
+}
+
+static void nullEnd(void) {
+}
+
+static const RenderBackend backends[] = {
+  { gpuState, gpuDraw, gpuEnd },
+  { nullState, nullDraw, nullEnd }
+};
+static const RenderBackend *backend = backends + RENDER_GL;
+
+void renderBackend(int which) {
+  backend = backends + which;
+}
+
+RenderCmd* renderDraw(const RenderState *s, GLenum mode,
+                      int first, int count) {
+  static RenderCmd dropped;
+  RenderCmd *c;
+
+  if(cmd_count == cmd_size) {
+    int size = cmd_size ? cmd_size * 2 : 64;
+    RenderCmd *grown = realloc(cmds, size * sizeof(RenderCmd));
+    if(grown == NULL) {
+      fprintf(stderr, "can't allocate %d render commands\n", size);
+      /* the draw gets lost, but the caller can still fill it in */
+      return &dropped;
+    }
+    memAccount(MEM_RENDER, (size - cmd_size) * sizeof(RenderCmd));
+    cmds = grown;
+    cmd_size = size;
+  }
+
+  c = cmds + cmd_count;
+  c->state = *s;
+  c->key = renderKey(s);
+  c->seq = cmd_count++;
+  c->mode = mode;
+  c->first = first;
+  c->count = count;
+  c->polys = 0;
+  c->color[0] = c->color[1] = c->color[2] = c->color[3] = 1;
+  c->normal[0] = c->normal[1] = 0;
+  c->normal[2] = 1;
+  return c;
+}
+
+void renderSubmit(void) {
+  const RenderState *last = NULL;
+  int i;
+
+  if(cmd_count == 0)
+    return;
+  qsort(cmds, cmd_count, sizeof(RenderCmd), compareCmds);
+
+  for(i = 0; i < cmd_count; i++) {
+    if(last == NULL || !sameState(&cmds[i].state, last)) {
+      backend->state(&cmds[i].state, last);
+      last = &cmds[i].state;
+      changes++;
+    }
+    backend->draw(cmds + i);
+    polycount += cmds[i].polys;
+  }
+  backend->end();
+
+  commands += cmd_count;
+  cmd_count = 0;
+}
+
+void renderStats(int *command_count, int *state_changes) {
+  *command_count = commands;
+  *state_changes = changes;
+  commands = changes = 0;
+}
@@ -205,7 +205,7 @@ void initSettingData(char *filename) {
   // Ensure arrays are allocated to expected minimal sizes to avoid later deref
   if (!si || si_count < 28) {
     if (si) free(si);
-    si = calloc(28, sizeof(struct settings_int));
+    si = calloc(31, sizeof(struct settings_int));
     if (!si) {
 #ifdef ANDROID
       LOGI("initSettingData: failed to allocate default integer settings");
@@ -214,17 +214,18 @@ void initSettingData(char *filename) {
 #endif
       return;
     }
-    si_count = 28;
+    si_count = 31;
     // Initialize names to match defaults if parsing failed
-    const char* names_int[28] = {
+    const char* names_int[31] = {
       "show_help","show_fps","show_wall","show_glow","show_2d","show_alpha",
       "show_floor_texture","line_spacing","erase_crashed","fast_finish",
       "fov","width","height","show_ai_status","camType","display_type",
       "playSound","show_model","ai_player1","ai_player2","ai_player3",
       "ai_player4","show_crash_texture","turn_cycle","mouse_warp",
-      "sound_driver","input_mode","fullscreen"
+      "sound_driver","input_mode","fullscreen","frame_rate","vsync",
+      "show_memory"
     };
-    for (int k = 0; k < 28; ++k) {
+    for (int k = 0; k < 31; ++k) {
       strncpy(si[k].name, names_int[k], sizeof(si[k].name)-1);
       si[k].name[sizeof(si[k].name)-1] = '\0';
     }
@@ -281,6 +282,15 @@ void initSettingData(char *filename) {
   if (si_count > 27) {
     si[27].value = &(game->settings->fullscreen);
   }
+  /* frame scheduler, see frame.c */
+  if (si_count > 29) {
+    si[28].value = &(game->settings->frame_rate);
+    si[29].value = &(game->settings->vsync);
+  }
+  /* memory report, see memstat.c */
+  if (si_count > 30) {
+    si[30].value = &(game->settings->show_memory);
+  }
 
   sf[0].value = &(game->settings->speed);
 }
@@ -339,6 +349,9 @@ void initMainGameSettings(char *filename) {
 #else
   game->settings->fullscreen = 0;
 #endif
+  game->settings->frame_rate = 60;
+  game->settings->vsync = 0;
+  game->settings->show_memory = 0;
   game->settings->display_type = 0;
   game->settings->playSound = 1;
   game->settings->playMusic = 1;
@@ -521,11 +534,13 @@ void saveSettings() {
     fprintf(f, "%s\n", sf[i].name);
   }
 
-  // Write actual values
+  // Write actual values, the user's rather than a benchmark's
+  benchmarkSettings(0);
   for(i = 0; i < si_count; i++)
     fprintf(f, "iset %s %d\n", si[i].name, *(si[i].value));
   for(i = 0; i < sf_count; i++)
     fprintf(f, "fset %s %.2f\n", sf[i].name, *(sf[i].value));
+  benchmarkSettings(1);
 
 #ifdef ANDROID
   LOGI("saveSettings: written settings to %s", fname);
@@ -5,30 +5,190 @@
 
 #ifndef WIN32
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
-#include "sgi_texture.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
-// Ensure correct prototype is visible to avoid implicit int return issues
-char* getFullPath(char *filename);
+#include "sgi_texture.h"
+#include "pack.h"
+#include "memstat.h"
 
 #define ERR_PREFIX "[load_sgi_texture] "
-/* must be larger than 512 */
-#define BUFSIZE 8192
 
 /* SGI Image File Format constants */
 #define SGI_MAGIC 474
 #define SGI_HEADER_SIZE 512
 
+/* big-endian fields of the file */
+#define SGI_SHORT(p) (((p)[0] << 8) | (p)[1])
+#define SGI_LONG(p) (((unsigned int) (p)[0] << 24) | ((p)[1] << 16) | \
+                     ((p)[2] << 8) | (p)[3])
+
+/* The whole file, in place: from the pack if it's packed, otherwise
+   mapped (or read, where there's no mmap). Released by unmapSgi(). */
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    void *map;
+    unsigned char *copy;
+} SgiFile;
+
+static int mapSgi(const char *filename, SgiFile *file) {
+    FILE *f;
+    long l;
+
+    file->map = NULL;
+    file->copy = NULL;
+    file->data = packData(filename, &file->size);
+    if (file->data)
+        return 1;
+
+    f = openAsset(filename);
+    if (!f) {
+        fprintf(stderr, ERR_PREFIX "can't open '%s': %s\n", filename, strerror(errno));
+        return 0;
+    }
+#ifndef WIN32
+    {
+        struct stat st;
+        if (fstat(fileno(f), &st) == 0 && st.st_size > 0) {
+            void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+            if (map != MAP_FAILED) {
+                fclose(f);
+                file->map = map;
+                file->data = map;
+                file->size = st.st_size;
+                return 1;
+            }
+        }
+    }
+#endif
+    fseek(f, 0, SEEK_END);
+    l = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (l > 0 && (file->copy = malloc(l)) != NULL &&
+        fread(file->copy, 1, l, f) != (size_t) l) {
+        free(file->copy);
+        file->copy = NULL;
+    }
+    fclose(f);
+    if (!file->copy) {
+        fprintf(stderr, ERR_PREFIX "failed to read '%s'\n", filename);
+        return 0;
+    }
+    file->data = file->copy;
+    file->size = l;
+    return 1;
+}
+
+static void unmapSgi(SgiFile *file) {
+#ifndef WIN32
+    if (file->map)
+        munmap(file->map, file->size);
+#endif
+    free(file->copy);
+}
+
+/* one row from its channel planes into interleaved pixels */
+static void interleaveRow(unsigned char *dst, const unsigned char **planes,
+                          int width, int channels) {
+    const unsigned char *r = planes[0], *g = planes[1], *b = planes[2];
+    int i = 0;
+
+    if (channels == 4) {
+        const unsigned char *a = planes[3];
+#if defined(__SSE2__)
+        for (; i + 16 <= width; i += 16) {
+            __m128i vr = _mm_loadu_si128((const __m128i*) (r + i));
+            __m128i vg = _mm_loadu_si128((const __m128i*) (g + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*) (b + i));
+            __m128i va = _mm_loadu_si128((const __m128i*) (a + i));
+            __m128i rg_lo = _mm_unpacklo_epi8(vr, vg);
+            __m128i rg_hi = _mm_unpackhi_epi8(vr, vg);
+            __m128i ba_lo = _mm_unpacklo_epi8(vb, va);
+            __m128i ba_hi = _mm_unpackhi_epi8(vb, va);
+            _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_unpacklo_epi16(rg_lo, ba_lo));
+            _mm_storeu_si128((__m128i*) (dst + i * 4 + 16), _mm_unpackhi_epi16(rg_lo, ba_lo));
+            _mm_storeu_si128((__m128i*) (dst + i * 4 + 32), _mm_unpacklo_epi16(rg_hi, ba_hi));
+            _mm_storeu_si128((__m128i*) (dst + i * 4 + 48), _mm_unpackhi_epi16(rg_hi, ba_hi));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; i + 16 <= width; i += 16) {
+            uint8x16x4_t v;
+            v.val[0] = vld1q_u8(r + i);
+            v.val[1] = vld1q_u8(g + i);
+            v.val[2] = vld1q_u8(b + i);
+            v.val[3] = vld1q_u8(a + i);
+            vst4q_u8(dst + i * 4, v);
+        }
+#endif
+        for (; i < width; i++) {
+            dst[i * 4] = r[i];
+            dst[i * 4 + 1] = g[i];
+            dst[i * 4 + 2] = b[i];
+            dst[i * 4 + 3] = a[i];
+        }
+    } else {
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; i + 16 <= width; i += 16) {
+            uint8x16x3_t v;
+            v.val[0] = vld1q_u8(r + i);
+            v.val[1] = vld1q_u8(g + i);
+            v.val[2] = vld1q_u8(b + i);
+            vst3q_u8(dst + i * 3, v);
+        }
+#endif
+        for (; i < width; i++) {
+            dst[i * 3] = r[i];
+            dst[i * 3 + 1] = g[i];
+            dst[i * 3 + 2] = b[i];
+        }
+    }
+}
+
+/* unpacks one RLE row into width bytes, 0 if it's broken */
+static int expandRow(unsigned char *dst, int width,
+                     const unsigned char *src, const unsigned char *end) {
+    unsigned char *out = dst, *out_end = dst + width;
+
+    while (src < end) {
+        int n = *src & 0x7f;
+        int literal = *src++ & 0x80;
+
+        if (n == 0)
+            break;
+        if (n > out_end - out)
+            return 0;
+        if (literal) {
+            if (n > end - src)
+                return 0;
+            memcpy(out, src, n);
+            src += n;
+        } else {
+            if (src == end)
+                return 0;
+            memset(out, *src++, n);
+        }
+        out += n;
+    }
+    return out == out_end;
+}
+
 sgi_texture* load_sgi_texture(char *filename) {
-    FILE *f = NULL;
-    unsigned char buf[BUFSIZE];
-    unsigned int x, y, bpc, zsize;
-    long count, bytes;
-    unsigned char *tmp = NULL;
-    int i, j;
+    SgiFile file;
+    const unsigned char *buf;
+    const unsigned char *planes[4];
+    unsigned char *rows = NULL;
+    unsigned int x, y, bpc, zsize, storage;
+    size_t count;
+    unsigned int i, j;
     sgi_texture *tex = NULL;
-    char *resolved = NULL;
 
     // Validate input
     if (!filename) {
@@ -36,167 +196,129 @@ sgi_texture* load_sgi_texture(char *filename) {
         return NULL;
     }
 
-    // Get the full path of the file
-    resolved = getFullPath(filename);
-    if (!resolved) {
-        fprintf(stderr, ERR_PREFIX "could not resolve file '%s'\n", filename);
-        return NULL;
-    }
-
-    fprintf(stderr, ERR_PREFIX "attempting to load: '%s' (resolved: '%s')\n", filename, resolved);
-
-    // Open the file
-    f = fopen(resolved, "rb");
-    if (!f) {
-        fprintf(stderr, ERR_PREFIX "fopen('%s') failed: %s\n", resolved, strerror(errno));
-        free(resolved);
+    // Map the file, from the asset pack if there is one
+    if (!mapSgi(filename, &file))
         return NULL;
-    }
+    buf = file.data;
 
-    // Read the header
-    size_t nread = fread(buf, 1, SGI_HEADER_SIZE, f);
-    if (nread != SGI_HEADER_SIZE) {
-        fprintf(stderr, ERR_PREFIX "failed to read SGI header from '%s' (read %zu bytes, expected %d)\n", 
-                resolved, nread, SGI_HEADER_SIZE);
-        fclose(f);
-        free(resolved);
-        return NULL;
+    if (file.size < SGI_HEADER_SIZE) {
+        fprintf(stderr, ERR_PREFIX "failed to read SGI header from '%s' (%zu bytes, expected %d)\n",
+                filename, file.size, SGI_HEADER_SIZE);
+        goto fail;
     }
 
     // Check the magic number (big-endian format)
-    unsigned short magic = (buf[0] << 8) | buf[1];
-    if (magic != SGI_MAGIC) {
+    if (SGI_SHORT(buf) != SGI_MAGIC) {
         fprintf(stderr, ERR_PREFIX "wrong magic: 0x%04x (expected 0x%04x) for file '%s'\n",
-                magic, SGI_MAGIC, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+                SGI_SHORT(buf), SGI_MAGIC, filename);
+        goto fail;
     }
 
-    // Check for RLE compression (storage type)
-    unsigned char storage = buf[2];
-    if (storage != 0) {
-        fprintf(stderr, ERR_PREFIX "RLE compression (storage=%d) not supported for file '%s'\n", 
-                storage, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+    // Storage type: 0 verbatim, 1 RLE
+    storage = buf[2];
+    if (storage > 1) {
+        fprintf(stderr, ERR_PREFIX "unknown storage type %d for file '%s'\n",
+                storage, filename);
+        goto fail;
     }
 
     // Check bytes per channel
     bpc = buf[3];
     if (bpc != 1) {
-        fprintf(stderr, ERR_PREFIX "BPC is %d - only 1 byte per channel supported for file '%s'\n", 
-                bpc, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+        fprintf(stderr, ERR_PREFIX "BPC is %d - only 1 byte per channel supported for file '%s'\n",
+                bpc, filename);
+        goto fail;
     }
 
-    // Get dimensions (big-endian format)
-    x = (buf[6] << 8) | buf[7];     // xsize
-    y = (buf[8] << 8) | buf[9];     // ysize
-    zsize = (buf[10] << 8) | buf[11]; // zsize (number of channels)
-
-    fprintf(stderr, ERR_PREFIX "image dimensions: %dx%d, channels: %d, bpc: %d\n", 
-            x, y, zsize, bpc);
+    // Get dimensions
+    x = SGI_SHORT(buf + 6);     // xsize
+    y = SGI_SHORT(buf + 8);     // ysize
+    zsize = SGI_SHORT(buf + 10); // zsize (number of channels)
 
     // Validate dimensions
     if (x == 0 || y == 0 || zsize == 0) {
-        fprintf(stderr, ERR_PREFIX "invalid dimensions: %dx%d, channels: %d for file '%s'\n", 
-                x, y, zsize, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+        fprintf(stderr, ERR_PREFIX "invalid dimensions: %dx%d, channels: %d for file '%s'\n",
+                x, y, zsize, filename);
+        goto fail;
     }
 
     // Check for reasonable limits to prevent huge allocations
     if (x > 8192 || y > 8192 || zsize > 4) {
-        fprintf(stderr, ERR_PREFIX "dimensions too large: %dx%d, channels: %d for file '%s'\n", 
-                x, y, zsize, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+        fprintf(stderr, ERR_PREFIX "dimensions too large: %dx%d, channels: %d for file '%s'\n",
+                x, y, zsize, filename);
+        goto fail;
     }
 
     // Support both RGB (3 channels) and RGBA (4 channels)
     if (zsize != 3 && zsize != 4) {
-        fprintf(stderr, ERR_PREFIX "unsupported number of channels: %d (only 3 or 4 supported) for file '%s'\n", 
-                zsize, resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+        fprintf(stderr, ERR_PREFIX "unsupported number of channels: %d (only 3 or 4 supported) for file '%s'\n",
+                zsize, filename);
+        goto fail;
     }
 
-    // Allocate texture structure
-    tex = (sgi_texture*) malloc(sizeof(sgi_texture));
-    if (!tex) {
-        fprintf(stderr, ERR_PREFIX "out of memory allocating texture struct for file '%s'\n", resolved);
-        fclose(f);
-        free(resolved);
-        return NULL;
+    count = (size_t) x * y * zsize;
+    if (storage == 0 && file.size - SGI_HEADER_SIZE < count) {
+        fprintf(stderr, ERR_PREFIX "failed to read texture data for file '%s' (%zu bytes, expected %zu)\n",
+                filename, file.size - SGI_HEADER_SIZE, count);
+        goto fail;
+    }
+    // RLE: row start and length tables, one entry per row and channel
+    if (storage == 1 && (file.size - SGI_HEADER_SIZE) / 8 < (size_t) y * zsize) {
+        fprintf(stderr, ERR_PREFIX "truncated RLE tables in file '%s'\n", filename);
+        goto fail;
     }
 
-    // Initialize structure
-    tex->data = NULL;
+    tex = (sgi_texture*) malloc(sizeof(sgi_texture));
+    if (tex)
+        tex->data = malloc(count);
+    if (storage == 1)
+        rows = malloc((size_t) x * zsize);
+    if (!tex || !tex->data || (storage == 1 && !rows)) {
+        fprintf(stderr, ERR_PREFIX "out of memory allocating %zu bytes for texture data '%s'\n",
+                count, filename);
+        goto fail;
+    }
     tex->width = x;
     tex->height = y;
     tex->channels = zsize;
 
-    // Calculate total size
-    count = x * y * zsize * bpc;
-    
-    // Allocate texture data
-    tex->data = malloc(count);
-    if (!tex->data) {
-        fprintf(stderr, ERR_PREFIX "out of memory allocating %ld bytes for texture data '%s'\n", 
-                count, resolved);
-        free(tex);
-        fclose(f);
-        free(resolved);
-        return NULL;
-    }
-
-    // Allocate temporary buffer for reading
-    tmp = (unsigned char*) malloc(count);
-    if (!tmp) {
-        fprintf(stderr, ERR_PREFIX "out of memory allocating temp buffer for file '%s'\n", resolved);
-        free(tex->data);
-        free(tex);
-        fclose(f);
-        free(resolved);
-        return NULL;
-    }
-
-    // Read texture data
-    bytes = fread(tmp, 1, count, f);
-    if (bytes != count) {
-        fprintf(stderr, ERR_PREFIX "failed to read texture data for file '%s' (read %ld bytes, expected %ld)\n", 
-                resolved, bytes, count);
-        free(tmp);
-        free(tex->data);
-        free(tex);
-        fclose(f);
-        free(resolved);
-        return NULL;
-    }
-
-    // Reorder the data from planar (RRRR...GGGG...BBBB...AAAA) to interleaved (RGBA RGBA RGBA...)
-    // SGI format stores each channel as a separate plane
-    for (i = 0; i < x * y; i++) {
+    // SGI stores each channel as a separate plane (RRRR...GGGG...BBBB...),
+    // interleave them row by row into RGBA RGBA..., bottom row first
+    // like GL wants it
+    for (i = 0; i < y; i++) {
         for (j = 0; j < zsize; j++) {
-            tex->data[i * zsize + j] = tmp[j * x * y + i];
+            if (storage == 0) {
+                planes[j] = buf + SGI_HEADER_SIZE + ((size_t) j * y + i) * x;
+            } else {
+                const unsigned char *table = buf + SGI_HEADER_SIZE + ((size_t) j * y + i) * 4;
+                size_t start = SGI_LONG(table);
+                size_t length = SGI_LONG(table + (size_t) y * zsize * 4);
+                if (start > file.size || length > file.size - start ||
+                    !expandRow(rows + (size_t) j * x, x, buf + start, buf + start + length)) {
+                    fprintf(stderr, ERR_PREFIX "broken RLE row %d in file '%s'\n", i, filename);
+                    goto fail;
+                }
+                planes[j] = rows + (size_t) j * x;
+            }
         }
+        interleaveRow(tex->data + (size_t) i * x * zsize, planes, x, zsize);
     }
 
-    fprintf(stderr, ERR_PREFIX "successfully loaded texture '%s': %dx%d, %d channels, %ld bytes\n", 
-            resolved, x, y, zsize, count);
+    fprintf(stderr, ERR_PREFIX "successfully loaded texture '%s': %dx%d, %d channels%s, %zu bytes\n",
+            filename, x, y, zsize, storage ? " (RLE)" : "", count);
 
-    // Clean up and return
-    free(tmp);
-    fclose(f);
-    free(resolved);
+    free(rows);
+    unmapSgi(&file);
+    memAccount(MEM_TEXTURE, sizeof(sgi_texture) + count);
     return tex;
+
+ fail:
+    free(rows);
+    if (tex)
+        free(tex->data);
+    free(tex);
+    unmapSgi(&file);
+    return NULL;
 }
 
 void unload_sgi_texture(sgi_texture *tex) {
@@ -204,6 +326,8 @@ void unload_sgi_texture(sgi_texture *tex) {
         if (tex->data) {
             free(tex->data);
         }
+        memAccount(MEM_TEXTURE, -(ptrdiff_t) (sizeof(sgi_texture) +
+                   (size_t) tex->width * tex->height * tex->channels));
         free(tex);
     }
 }
@@ -5,6 +5,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+#include "memstat.h"
+#ifndef PATH_MAX
+#define PATH_MAX 1024
+#endif
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, "GLTron", __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "GLTron", __VA_ARGS__)
 
@@ -25,6 +34,70 @@ static GLint a_pos = -1;
 static GLint a_texcoord = -1;
 static GLint a_normal = -1;
 
+// Shadow copy of the GL state set through this file. Only state whose bit
+// is in 'known' is trusted; everything else is written through. Uniform
+// values are only shadowed for the unified program.
+#define STATE_TEXTURE_UNITS 8
+
+#define STATE_PROGRAM        (1u << 0)
+#define STATE_ACTIVE_TEXTURE (1u << 1)
+#define STATE_BLEND          (1u << 2)
+#define STATE_BLEND_FUNC     (1u << 3)
+#define STATE_DEPTH_TEST     (1u << 4)
+#define STATE_DEPTH_MASK     (1u << 5)
+#define STATE_TEXTURE0       (1u << 8)  // one bit per texture unit
+
+#define UNIFORM_PROJ        (1u << 0)
+#define UNIFORM_VIEW        (1u << 1)
+#define UNIFORM_MODEL       (1u << 2)
+#define UNIFORM_NORMAL      (1u << 3)
+#define UNIFORM_COLOR       (1u << 4)
+#define UNIFORM_TEX         (1u << 5)
+#define UNIFORM_IS2D        (1u << 6)
+#define UNIFORM_LIGHT_POS   (1u << 7)
+#define UNIFORM_LIGHT_COLOR (1u << 8)
+#define UNIFORM_AMBIENT     (1u << 9)
+
+static struct {
+    unsigned int known;
+    GLuint program;
+    GLenum activeTexture;
+    GLuint texture2D[STATE_TEXTURE_UNITS];
+    int blend;
+    GLenum blendSrc, blendDst;
+    int depthTest;
+    GLboolean depthMask;
+
+    unsigned int uniforms;
+    GLfloat proj[16], view[16], model[16], normal[16];
+    GLfloat color[4];
+    GLfloat tex, is2D;
+    GLfloat lightPos[3], lightColor[3], ambientLight[3];
+} s_state;
+
+static unsigned int s_skipped = 0;
+
+// Returns 1 if the unified program already holds these uniform values.
+static int uniformUnchanged(GLuint program, unsigned int bit,
+                            GLfloat *shadow, const GLfloat *v, int n) {
+    if (program != g_shader_unified ||
+        !(s_state.known & STATE_PROGRAM) || s_state.program != program)
+        return 0;
+    if ((s_state.uniforms & bit) && memcmp(shadow, v, n * sizeof(GLfloat)) == 0) {
+        s_skipped++;
+        return 1;
+    }
+    memcpy(shadow, v, n * sizeof(GLfloat));
+    s_state.uniforms |= bit;
+    return 0;
+}
+
+static void unbindProgram() {
+    glUseProgram(0);
+    s_state.program = 0;
+    s_state.known |= STATE_PROGRAM;
+}
+
 // Unified vertex shader that handles both 2D and 3D
 static const char* vertexShaderSource =
     "attribute vec3 position;\n"
@@ -115,12 +188,173 @@ static GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
+// Program binary cache (GL_OES_get_program_binary): the linked unified
+// program and its locations, keyed by driver and shader source, so later
+// launches and context losses skip compiling, linking and the queries.
+#define PROGRAM_CACHE_MAGIC "GLTPRG1"
+#define PROGRAM_CACHE_NAME "program.bin"
+
+static GLint* const s_locations[] = {
+    &u_proj, &u_view, &u_model, &u_normal, &u_color, &u_tex,
+    &u_lightPos, &u_lightColor, &u_ambientLight, &u_is2D,
+    &a_pos, &a_texcoord, &a_normal
+};
+#define N_LOCATIONS (sizeof(s_locations) / sizeof(s_locations[0]))
+
+typedef struct {
+    char magic[8];
+    uint32_t key;
+    uint32_t format;
+    int32_t length;
+    GLint locations[N_LOCATIONS];
+} ProgramCacheHeader;
+
+static PFNGLGETPROGRAMBINARYOESPROC pglGetProgramBinaryOES = NULL;
+static PFNGLPROGRAMBINARYOESPROC pglProgramBinaryOES = NULL;
+
+static int programBinarySupported() {
+    const char *ext = (const char*) glGetString(GL_EXTENSIONS);
+    GLint formats = 0;
+
+    if (!ext || !strstr(ext, "GL_OES_get_program_binary"))
+        return 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    if (formats <= 0)
+        return 0;
+    if (!pglGetProgramBinaryOES || !pglProgramBinaryOES) {
+        pglGetProgramBinaryOES = (PFNGLGETPROGRAMBINARYOESPROC)
+            eglGetProcAddress("glGetProgramBinaryOES");
+        pglProgramBinaryOES = (PFNGLPROGRAMBINARYOESPROC)
+            eglGetProcAddress("glProgramBinaryOES");
+    }
+    return pglGetProgramBinaryOES && pglProgramBinaryOES;
+}
+
+static uint32_t hashString(uint32_t h, const char *s) {
+    while (s && *s) {
+        h ^= (unsigned char) *s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// A driver update or a shader change makes old binaries useless
+static uint32_t programCacheKey() {
+    uint32_t h = 2166136261u;
+    h = hashString(h, (const char*) glGetString(GL_VENDOR));
+    h = hashString(h, (const char*) glGetString(GL_RENDERER));
+    h = hashString(h, (const char*) glGetString(GL_VERSION));
+    h = hashString(h, vertexShaderSource);
+    h = hashString(h, fragmentShaderSource);
+    return h;
+}
+
+static void programCachePath(char *buf, size_t size) {
+    extern char s_base_path[]; // android_glue.c
+    snprintf(buf, size, "%s/%s", s_base_path, PROGRAM_CACHE_NAME);
+}
+
+static GLuint loadCachedProgram() {
+    ProgramCacheHeader h;
+    char path[PATH_MAX];
+    void *binary = NULL;
+    GLint linked = GL_FALSE;
+    GLuint program;
+    FILE *f;
+    size_t i;
+
+    if (!programBinarySupported())
+        return 0;
+    programCachePath(path, sizeof(path));
+    f = fopen(path, "rb");
+    if (!f)
+        return 0;
+    if (fread(&h, sizeof(h), 1, f) != 1 ||
+        memcmp(h.magic, PROGRAM_CACHE_MAGIC, 8) != 0 ||
+        h.key != programCacheKey() || h.length <= 0 ||
+        (binary = malloc(h.length)) == NULL ||
+        fread(binary, 1, h.length, f) != (size_t) h.length) {
+        LOGI("Shader program cache is stale, compiling");
+        free(binary);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    program = glCreateProgram();
+    pglProgramBinaryOES(program, h.format, binary, h.length);
+    free(binary);
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // the driver may refuse binaries of another build of itself
+        LOGI("Cached shader program rejected by the driver, compiling");
+        glDeleteProgram(program);
+        remove(path);
+        return 0;
+    }
+
+    for (i = 0; i < N_LOCATIONS; i++)
+        *s_locations[i] = h.locations[i];
+    LOGI("Shader program loaded from cache: %u", program);
+    return program;
+}
+
+static void saveCachedProgram(GLuint program) {
+    ProgramCacheHeader h;
+    char path[PATH_MAX], tmp[PATH_MAX + 4];
+    GLint length = 0;
+    GLenum format = 0;
+    void *binary;
+    size_t i;
+    FILE *f;
+    int ok;
+
+    if (!programBinarySupported())
+        return;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0 || (binary = malloc(length)) == NULL)
+        return;
+    pglGetProgramBinaryOES(program, length, &length, &format, binary);
+    if (glGetError() != GL_NO_ERROR || length <= 0) {
+        free(binary);
+        return;
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PROGRAM_CACHE_MAGIC, 8);
+    h.key = programCacheKey();
+    h.format = format;
+    h.length = length;
+    for (i = 0; i < N_LOCATIONS; i++)
+        h.locations[i] = *s_locations[i];
+
+    // written aside and renamed, a crash never leaves half a binary
+    programCachePath(path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    f = fopen(tmp, "wb");
+    if (f) {
+        ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             fwrite(binary, 1, length, f) == (size_t) length;
+        ok = fclose(f) == 0 && ok;
+        if (ok && rename(tmp, path) == 0)
+            LOGI("Shader program cached: %d bytes", length);
+        else
+            remove(tmp);
+    }
+    free(binary);
+}
+
 static GLuint createUnifiedShaderProgram() {
     // Reset cached locations
     u_proj = u_view = u_model = u_normal = u_color = u_tex = -1;
     u_lightPos = u_lightColor = u_ambientLight = u_is2D = -1;
     a_pos = a_texcoord = a_normal = -1;
 
+    // Previously linked on this driver: one call instead of compiling
+    GLuint cached = loadCachedProgram();
+    if (cached)
+        return cached;
+
     // Compile shaders
     LOGI("Compiling vertex shader...");
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
@@ -177,7 +411,8 @@ static GLuint createUnifiedShaderProgram() {
     glDeleteShader(fragmentShader);
 
     // Cache uniform and attribute locations
-    glUseProgram(shaderProgram);
+    invalidateStateCache();
+    useShaderProgram(shaderProgram);
 
     // Get matrix locations
     u_proj = glGetUniformLocation(shaderProgram, "projectionMatrix");
@@ -205,7 +440,7 @@ static GLuint createUnifiedShaderProgram() {
     // Check if absolutely critical locations were found
     if (u_proj == -1 || u_color == -1 || a_pos == -1) {
         LOGE("Failed to get absolutely critical shader locations: proj=%d, color=%d, pos=%d", u_proj, u_color, a_pos);
-        glUseProgram(0);
+        unbindProgram();
         glDeleteProgram(shaderProgram);
         return 0;
     }
@@ -231,7 +466,9 @@ static GLuint createUnifiedShaderProgram() {
     // Debug logging for all shader locations
     LOGI("Shader locations initialized: proj=%d, view=%d, model=%d, normalMat=%d, color=%d, tex=%d, is2D=%d, pos=%d, texcoord=%d", u_proj, u_view, u_model, u_normal, u_color, u_tex, u_is2D, a_pos, a_texcoord);
 
-    glUseProgram(0);
+    saveCachedProgram(shaderProgram);
+
+    unbindProgram();
     return shaderProgram;
 }
 
@@ -249,6 +486,8 @@ void setRenderMode2D(GLuint program, int is2D) {
         LOGI("is2D uniform not found - shader may not support 2D/3D mode switching");
         return;
     }
+    GLfloat v = is2D ? 1.0f : 0.0f;
+    if (uniformUnchanged(program, UNIFORM_IS2D, &s_state.is2D, &v, 1)) return;
     glUniform1i(u_is2D, is2D ? 1 : 0);
 }
 
@@ -266,6 +505,7 @@ void setProjectionMatrix(GLuint program, float* matrix) {
         LOGE("Failed to get projection matrix location");
         return;
     }
+    if (uniformUnchanged(program, UNIFORM_PROJ, s_state.proj, matrix, 16)) return;
     glUniformMatrix4fv(u_proj, 1, GL_FALSE, matrix);
 }
 
@@ -282,6 +522,7 @@ void setModelMatrix(GLuint program, float* matrix) {
         LOGI("Model matrix location not found - may be optional");
         return;
     }
+    if (uniformUnchanged(program, UNIFORM_MODEL, s_state.model, matrix, 16)) return;
     glUniformMatrix4fv(u_model, 1, GL_FALSE, matrix);
 }
 
@@ -298,6 +539,7 @@ void setViewMatrix(GLuint program, float* matrix) {
         LOGI("View matrix location not found - may be optional for 2D");
         return;
     }
+    if (uniformUnchanged(program, UNIFORM_VIEW, s_state.view, matrix, 16)) return;
     glUniformMatrix4fv(u_view, 1, GL_FALSE, matrix);
 }
 
@@ -336,7 +578,8 @@ void setNormalMatrix(GLuint program, float* matrix) {
         if (program != g_shader_unified || u_normal == -1) {
             u_normal = glGetUniformLocation(program, "normalMatrix");
         }
-        if (u_normal != -1) {
+        if (u_normal != -1 &&
+            !uniformUnchanged(program, UNIFORM_NORMAL, s_state.normal, identity, 16)) {
             glUniformMatrix4fv(u_normal, 1, GL_FALSE, identity);
         }
         return;
@@ -380,6 +623,7 @@ void setNormalMatrix(GLuint program, float* matrix) {
         LOGI("Normal matrix location not found - may be optional for 2D");
         return;
     }
+    if (uniformUnchanged(program, UNIFORM_NORMAL, s_state.normal, normalMatrix4x4, 16)) return;
     glUniformMatrix4fv(u_normal, 1, GL_FALSE, normalMatrix4x4);
 }
 
@@ -395,6 +639,8 @@ void setColor(GLuint program, float r, float g, float b, float a) {
         LOGE("Failed to get color location");
         return;
     }
+    GLfloat v[4] = { r, g, b, a };
+    if (uniformUnchanged(program, UNIFORM_COLOR, s_state.color, v, 4)) return;
     glUniform4f(u_color, r, g, b, a);
 }
 
@@ -411,6 +657,8 @@ void setTexture(GLuint program, GLuint textureUnit) {
         LOGI("Texture uniform not found - solid color rendering will be used");
         return;
     }
+    GLfloat v = (GLfloat)textureUnit;
+    if (uniformUnchanged(program, UNIFORM_TEX, &s_state.tex, &v, 1)) return;
     glUniform1i(u_tex, (GLint)textureUnit);
 }
 
@@ -426,6 +674,8 @@ void setLightPosition(GLuint program, float x, float y, float z) {
         // Lighting uniforms are optional in 2D mode
         return;
     }
+    GLfloat v[3] = { x, y, z };
+    if (uniformUnchanged(program, UNIFORM_LIGHT_POS, s_state.lightPos, v, 3)) return;
     glUniform3f(u_lightPos, x, y, z);
 }
 
@@ -441,6 +691,8 @@ void setLightColor(GLuint program, float r, float g, float b) {
         // Lighting uniforms are optional in 2D mode
         return;
     }
+    GLfloat v[3] = { r, g, b };
+    if (uniformUnchanged(program, UNIFORM_LIGHT_COLOR, s_state.lightColor, v, 3)) return;
     glUniform3f(u_lightColor, r, g, b);
 }
 
@@ -456,6 +708,8 @@ void setAmbientLight(GLuint program, float r, float g, float b) {
         // Lighting uniforms are optional in 2D mode
         return;
     }
+    GLfloat v[3] = { r, g, b };
+    if (uniformUnchanged(program, UNIFORM_AMBIENT, s_state.ambientLight, v, 3)) return;
     glUniform3f(u_ambientLight, r, g, b);
 }
 
@@ -531,14 +785,12 @@ void init_shaders_android() {
         LOGI("Unified shader created successfully: %u", g_shader_unified);
     }
 
-    // Bind once and set defaults
-    glUseProgram(g_shader_unified);
+    // Bind once and set defaults (the fallback shader has different locations)
+    invalidateStateCache();
+    useShaderProgram(g_shader_unified);
 
     // Set default texture unit
-    GLint texLoc = glGetUniformLocation(g_shader_unified, "texture");
-    if (texLoc != -1) {
-        glUniform1i(texLoc, 0);
-    }
+    setTexture(g_shader_unified, 0);
 
     // Set default to 3D mode
     setRenderMode2D(g_shader_unified, 0);
@@ -551,13 +803,14 @@ void init_shaders_android() {
     // Set default color
     setColor(g_shader_unified, 1.0f, 1.0f, 1.0f, 1.0f);
 
-    glUseProgram(0);
+    unbindProgram();
 }
 
 void shutdown_shaders_android() {
     if (g_shader_unified) {
         glDeleteProgram(g_shader_unified);
         g_shader_unified = 0;
+        invalidateStateCache();
     }
 }
 
@@ -574,11 +827,7 @@ void ensureShaderBound() {
         init_shaders_android();
     }
     if (g_shader_unified != 0) {
-        GLint currentProgram = 0;
-        glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
-        if (currentProgram != (GLint)g_shader_unified) {
-            glUseProgram(g_shader_unified);
-        }
+        useShaderProgram(g_shader_unified);
     } else {
         LOGE("Failed to ensure shader is bound - shader initialization failed");
     }
@@ -626,14 +875,121 @@ void useShaderProgram(GLuint program) {
         LOGE("Invalid shader program");
         return;
     }
+    if ((s_state.known & STATE_PROGRAM) && s_state.program == program) {
+        s_skipped++;
+        return;
+    }
     glUseProgram(program);
+    s_state.program = program;
+    s_state.known |= STATE_PROGRAM;
+}
+
+void setActiveTexture(GLenum unit) {
+    if ((s_state.known & STATE_ACTIVE_TEXTURE) && s_state.activeTexture == unit) {
+        s_skipped++;
+        return;
+    }
+    glActiveTexture(unit);
+    s_state.activeTexture = unit;
+    s_state.known |= STATE_ACTIVE_TEXTURE;
+}
+
+void bindTexture2D(GLuint texture) {
+    int unit = -1;
+    unsigned int bit;
+
+    if (s_state.known & STATE_ACTIVE_TEXTURE)
+        unit = (int)(s_state.activeTexture - GL_TEXTURE0);
+    if (unit < 0 || unit >= STATE_TEXTURE_UNITS) {
+        // unknown unit, can't tell what is bound
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+    bit = STATE_TEXTURE0 << unit;
+    if ((s_state.known & bit) && s_state.texture2D[unit] == texture) {
+        s_skipped++;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    s_state.texture2D[unit] = texture;
+    s_state.known |= bit;
+}
+
+void setBlend(int enabled) {
+    enabled = enabled ? 1 : 0;
+    if ((s_state.known & STATE_BLEND) && s_state.blend == enabled) {
+        s_skipped++;
+        return;
+    }
+    if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    s_state.blend = enabled;
+    s_state.known |= STATE_BLEND;
+}
+
+void setBlendFunc(GLenum sfactor, GLenum dfactor) {
+    if ((s_state.known & STATE_BLEND_FUNC) &&
+        s_state.blendSrc == sfactor && s_state.blendDst == dfactor) {
+        s_skipped++;
+        return;
+    }
+    glBlendFunc(sfactor, dfactor);
+    s_state.blendSrc = sfactor;
+    s_state.blendDst = dfactor;
+    s_state.known |= STATE_BLEND_FUNC;
+}
+
+void setDepthTest(int enabled) {
+    enabled = enabled ? 1 : 0;
+    if ((s_state.known & STATE_DEPTH_TEST) && s_state.depthTest == enabled) {
+        s_skipped++;
+        return;
+    }
+    if (enabled) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    s_state.depthTest = enabled;
+    s_state.known |= STATE_DEPTH_TEST;
+}
+
+void setDepthMask(GLboolean flag) {
+    flag = flag ? GL_TRUE : GL_FALSE;
+    if ((s_state.known & STATE_DEPTH_MASK) && s_state.depthMask == flag) {
+        s_skipped++;
+        return;
+    }
+    glDepthMask(flag);
+    s_state.depthMask = flag;
+    s_state.known |= STATE_DEPTH_MASK;
+}
+
+// Forget everything shadowed, e.g. after a new context was made current or
+// textures/programs were deleted behind our back.
+void invalidateStateCache() {
+    s_state.known = 0;
+    s_state.uniforms = 0;
+}
+
+unsigned int getSkippedStateCalls() {
+    return s_skipped;
+}
+
+int getShadowMatrix(int matrixType, float *matrix) {
+    switch (matrixType) {
+        case MATRIX_PROJECTION:
+            if (!(s_state.uniforms & UNIFORM_PROJ)) return 0;
+            memcpy(matrix, s_state.proj, sizeof(s_state.proj));
+            return 1;
+        case MATRIX_VIEW:
+            if (!(s_state.uniforms & UNIFORM_VIEW)) return 0;
+            memcpy(matrix, s_state.view, sizeof(s_state.view));
+            return 1;
+    }
+    return 0;
 }
 
 GLuint createWhiteTexture() {
     GLuint tex = 0;
     unsigned char white[4] = {255,255,255,255};
     glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
+    bindTexture2D(tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -729,7 +1085,7 @@ GLuint createFontTexture() {
 
     GLuint texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    bindTexture2D(texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -737,6 +1093,7 @@ GLuint createFontTexture() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, fontData);
+    memGpuObject(MEM_GPU_TEXTURE, texture, TEXTURE_WIDTH * TEXTURE_HEIGHT * 4);
     
     free(fontData);
     return texture;
@@ -46,4 +46,32 @@ void setRenderMode2D(GLuint program, int is2D);
 void setup2DRendering();
 void setup3DRendering();
 
+// GL state shadowing: on Android the program, texture bindings, blend and
+// depth state and the unified shader's uniforms are mirrored in shaders.c
+// and redundant calls are skipped. Anything touching that state has to go
+// through these helpers (or call invalidateStateCache() afterwards).
+// On desktop they map straight to GL so shared code can use them too.
+#ifdef ANDROID
+void setActiveTexture(GLenum unit);
+void bindTexture2D(GLuint texture);
+void setBlend(int enabled);
+void setBlendFunc(GLenum sfactor, GLenum dfactor);
+void setDepthTest(int enabled);
+void setDepthMask(GLboolean flag);
+void invalidateStateCache();
+unsigned int getSkippedStateCalls();
+// Last projection or view matrix given to the unified program, for other
+// programs drawing in the same space. 0 if it isn't known.
+int getShadowMatrix(int matrixType, float *matrix);
+#else
+static inline void setActiveTexture(GLenum unit) { glActiveTexture(unit); }
+static inline void bindTexture2D(GLuint texture) { glBindTexture(GL_TEXTURE_2D, texture); }
+static inline void setBlend(int enabled) { if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND); }
+static inline void setBlendFunc(GLenum sfactor, GLenum dfactor) { glBlendFunc(sfactor, dfactor); }
+static inline void setDepthTest(int enabled) { if (enabled) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST); }
+static inline void setDepthMask(GLboolean flag) { glDepthMask(flag); }
+static inline void invalidateStateCache() { }
+static inline unsigned int getSkippedStateCalls() { return 0; }
+#endif
+
 #endif // SHADERS_H
@@ -0,0 +1,302 @@
+/*
+  simulation thread
+
+  While a round is played the game logic (movement, collisions, AI)
+  ticks on its own thread at a fixed rate, on the players' sim data.
+  After every tick it publishes a snapshot of that data into a triple
+  buffer: the tick writes one slot, the render side reads another and
+  the third holds the newest finished one. Handing slots over is a
+  single atomic exchange, so neither side ever waits for the other.
+
+  The render side copies the newest snapshot into the players' data,
+  which is what the drawing code, the cameras and the menus look at.
+  Trail segments before the current one never change during a round,
+  so only the current segment and the new ones are copied.
+
+  What the tick can't do on its own thread (sound effects, switching
+  to the pause screen) travels with the snapshots as well, and so do
+  the players left in the round and its winner: the tick keeps its own
+  copies and never writes game->running, game->winner or
+  game->pauseflag. Turns are stamped with the ticks' own clock.
+
+  Captures need every frame to see exactly one tick, and WIN32 has no
+  threads here, so those run each tick right before the frame instead.
+*/
+
+#include "gltron.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define SIM_TICK_MS 10
+/* after a stall, ticks older than this are dropped instead of caught up */
+#define SIM_MAX_BEHIND_MS 100
+#define SIM_MAX_TURNS 16
+
+/* or'ed into shared while the slot there is unread */
+#define SIM_FRESH 4
+
+typedef struct SimSnapshot {
+  int round;    /* snapshots of an earlier round are stale */
+  int crashes;  /* since the round started */
+  int finished;
+  int running;  /* players not gone yet */
+  int winner;
+  Data data[MAX_PLAYERS];
+} SimSnapshot;
+
+static SimSnapshot slots[3];
+static int back = 0, shared = 1, front = 2;
+
+static int sim_round = 0; /* bumped by simStart() */
+static int ticks = 0;
+static long long busy_us = 0; /* spent in the thread's ticks */
+static int crashes, finished, played;
+static int alive, winner;   /* the tick's game->running and game->winner */
+static int sim_clock;       /* ms, like getElapsedTime() */
+
+#ifndef WIN32
+static pthread_t thread;
+static pthread_mutex_t turn_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct { int player, direction; } turns[SIM_MAX_TURNS];
+static int nTurns = 0;
+#endif
+static int running = 0;
+
+static int threaded(void) {
+#ifdef WIN32
+  return 0;
+#else
+  return !capturing;
+#endif
+}
+
+/* copies a player's data, trail segments from first on */
+static void copyData(Data *to, const Data *from, int first) {
+  int n = from->trail - from->trails + 1;
+
+  memcpy(to, from, offsetof(Data, trails));
+  if(first < 0)
+    first = 0;
+  if(first < n)
+    memcpy(to->trails + first, from->trails + first,
+           (n - first) * sizeof(line));
+  to->trail = to->trails + (n - 1);
+}
+
+/* the current segment of a copy is the first that may have changed */
+static int current(const Data *data) {
+  return data->trail - data->trails;
+}
+
+static void publish(void) {
+  SimSnapshot *s = slots + back;
+  int i, same = s->round == sim_round;
+
+  for(i = 0; i < game->players; i++)
+    copyData(s->data + i, game->player[i].sim,
+             same ? current(s->data + i) : 0);
+  s->round = sim_round;
+  s->crashes = crashes;
+  s->finished = finished;
+  s->running = alive;
+  s->winner = winner;
+  back = __atomic_exchange_n(&shared, back | SIM_FRESH, __ATOMIC_ACQ_REL) & 3;
+}
+
+/* one tick at sim_clock */
+static void tick(double step) {
+#ifndef WIN32
+  int i;
+
+  pthread_mutex_lock(&turn_lock);
+  for(i = 0; i < nTurns; i++)
+    turn(game->player[turns[i].player].sim, turns[i].direction, sim_clock);
+  nTurns = 0;
+  pthread_mutex_unlock(&turn_lock);
+#endif
+  tickGame(step);
+  publish();
+  __atomic_add_fetch(&ticks, 1, __ATOMIC_RELAXED);
+}
+
+/* the thread keeps its clock itself, off GLUT */
+void simTick(double step) {
+  sim_clock = getElapsedTime();
+  tick(step);
+}
+
+int simTicks(void) {
+  return __atomic_load_n(&ticks, __ATOMIC_RELAXED);
+}
+
+int simTime(void) {
+  return sim_clock;
+}
+
+double simBusyMs(void) {
+  return __atomic_load_n(&busy_us, __ATOMIC_RELAXED) / 1000.0;
+}
+
+#ifndef WIN32
+static double simClock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void* simThread(void *unused) {
+  double next = simClock(), now;
+  /* getElapsedTime() when the thread started */
+  int start = sim_clock;
+  double start_ms = next;
+  struct timespec ts;
+
+  while(__atomic_load_n(&running, __ATOMIC_ACQUIRE) && !finished) {
+    now = simClock();
+    if(now < next) {
+      ts.tv_sec = 0;
+      ts.tv_nsec = (long) ((next - now) * 1000000);
+      nanosleep(&ts, NULL);
+      continue;
+    }
+    if(now - next > SIM_MAX_BEHIND_MS)
+      next = now;
+    next += SIM_TICK_MS;
+    sim_clock = start + (int) (now - start_ms);
+    tick(SIM_TICK_MS);
+    __atomic_add_fetch(&busy_us, (long long) ((simClock() - now) * 1000),
+                       __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+#endif
+
+void simStart(void) {
+  int i;
+
+  if(running)
+    return;
+  sim_round++;
+  for(i = 0; i < game->players; i++)
+    copyData(game->player[i].sim, game->player[i].data, 0);
+  crashes = played = finished = 0;
+  alive = game->running;
+  winner = game->winner;
+  sim_clock = getElapsedTime();
+
+#ifndef WIN32
+  nTurns = 0;
+  if(threaded()) {
+    running = 1;
+    if(pthread_create(&thread, NULL, simThread, NULL) != 0) {
+      fprintf(stderr, "can't start the simulation thread\n");
+      running = 0;
+    }
+  }
+#endif
+}
+
+void simStop(void) {
+  int i;
+
+  if(!running)
+    return;
+#ifndef WIN32
+  __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+  pthread_join(thread, NULL);
+#endif
+  /* the game state is all ours again */
+  for(i = 0; i < game->players; i++)
+    copyData(game->player[i].data, game->player[i].sim, 0);
+  game->running = alive;
+  game->winner = winner;
+}
+
+void simScreen(callbacks *screen) {
+  if(screen == &gameCallbacks)
+    simStart();
+  else
+    simStop();
+}
+
+int simThreaded(void) {
+  return running;
+}
+
+void simTurn(int player, int direction) {
+  if(player >= game->players)
+    return;
+#ifndef WIN32
+  if(running) {
+    pthread_mutex_lock(&turn_lock);
+    if(nTurns < SIM_MAX_TURNS) {
+      turns[nTurns].player = player;
+      turns[nTurns].direction = direction;
+      nTurns++;
+    } else
+      fprintf(stderr, "sim: %d turns queued for one tick, "
+              "dropped one of player %d\n", SIM_MAX_TURNS, player);
+    pthread_mutex_unlock(&turn_lock);
+    return;
+  }
+#endif
+  turn(game->player[player].sim, direction, getElapsedTime());
+}
+
+void simEvent(int event) {
+  if(running) {
+    /* picked up by simView() */
+    crashes++;
+    return;
+  }
+#ifdef SOUND
+  playSampleEffect(crash_sfx);
+#endif
+}
+
+int simGone(void) {
+  return --alive;
+}
+
+void simFinished(int w) {
+  winner = w;
+  if(running) {
+    finished = 1; /* picked up by simView() */
+    return;
+  }
+  game->running = alive;
+  game->winner = winner;
+  finishGame();
+}
+
+void simView(void) {
+  SimSnapshot *s;
+  int i;
+
+  if(__atomic_load_n(&shared, __ATOMIC_ACQUIRE) & SIM_FRESH)
+    front = __atomic_exchange_n(&shared, front, __ATOMIC_ACQ_REL) & 3;
+  s = slots + front;
+  /* nothing new since simStart() synced the players' data */
+  if(sim_round == 0 || s->round != sim_round)
+    return;
+
+  for(i = 0; i < game->players; i++)
+    copyData(game->player[i].data, s->data + i,
+             current(game->player[i].data));
+  game->running = s->running;
+
+  for(; played < s->crashes; played++) {
+#ifdef SOUND
+    playSampleEffect(crash_sfx);
+#endif
+  }
+  if(s->finished && running) {
+    game->winner = s->winner;
+    finishGame();
+  }
+}
@@ -1,7 +1,9 @@
 #include "sound.h"
 #include "globals.h"
+#include "pack.h"
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 
 #ifdef SOUND_BACKEND_OPENMPT
 #include "sound_backend.h"
@@ -71,9 +73,113 @@ SAMPLE* engine_sfx = NULL;
 SAMPLE* start_sfx = NULL;
 SAMPLE* action_sfx = NULL;
 
+// sample data as MikMod keeps it, for the memory report
+static ptrdiff_t sampleBytes(SAMPLE* s) {
+    ptrdiff_t bytes = sizeof(SAMPLE) + (ptrdiff_t)s->length;
+    if (s->flags & SF_16BITS) bytes += s->length;
+    if (s->flags & SF_STEREO) bytes *= 2;
+    return bytes;
+}
+
+static ptrdiff_t moduleBytes(MODULE* m) {
+    ptrdiff_t bytes = sizeof(MODULE);
+    for (int i=0; i<m->numsmp; ++i)
+        bytes += sampleBytes(&m->samples[i]);
+    return bytes;
+}
+
+static void freeSample(SAMPLE* s) {
+    if (!s) return;
+    memAccount(MEM_SOUND, -sampleBytes(s));
+    Sample_Free(s);
+}
+
+// MikMod reads packed files straight from the mapped pack
+typedef struct PackReader {
+    MREADER core;
+    const unsigned char* data;
+    long size, pos;
+} PackReader;
+
+static int packSeek(MREADER* r, long offset, int whence) {
+    PackReader* p = (PackReader*)r;
+    long to = whence == SEEK_SET ? offset :
+              whence == SEEK_CUR ? p->pos + offset : p->size + offset;
+    if (to < 0 || to > p->size) return -1;
+    p->pos = to;
+    return 0;
+}
+
+static long packTell(MREADER* r) {
+    return ((PackReader*)r)->pos;
+}
+
+static BOOL packRead(MREADER* r, void* dest, size_t length) {
+    PackReader* p = (PackReader*)r;
+    size_t left = (size_t)(p->size - p->pos);
+    size_t n = length < left ? length : left;
+    memcpy(dest, p->data + p->pos, n);
+    p->pos += (long)n;
+    return n == length;
+}
+
+static int packGet(MREADER* r) {
+    PackReader* p = (PackReader*)r;
+    return p->pos < p->size ? p->data[p->pos++] : EOF;
+}
+
+static BOOL packEof(MREADER* r) {
+    PackReader* p = (PackReader*)r;
+    return p->pos >= p->size;
+}
+
+// a reader over name in the pack, 0 if it isn't packed
+static int openPacked(PackReader* p, const char* name) {
+    size_t size;
+    memset(p, 0, sizeof(*p));
+    p->data = packData(name, &size);
+    if (!p->data || size == 0 || size > LONG_MAX) return 0;
+    p->size = (long)size;
+    p->core.Seek = packSeek;
+    p->core.Tell = packTell;
+    p->core.Read = packRead;
+    p->core.Get = packGet;
+    p->core.Eof = packEof;
+    return 1;
+}
+
+static MODULE* loadPackedModule(const char* name) {
+    PackReader p;
+    if (!openPacked(&p, name)) return NULL;
+    return Player_LoadGeneric(&p.core, 64, 0);
+}
+
+static SAMPLE* loadPackedSample(const char* name) {
+    PackReader p;
+    if (!openPacked(&p, name)) return NULL;
+    return Sample_LoadGeneric(&p.core);
+}
+
 // helper to load music module by common names/paths
 static int loadMusicModule(void) {
     if (sound_module) return 0; // already loaded
+    {
+        // the pack first, without probing the data directories
+        const char* names[] = {"gltron", "music", NULL};
+        const char* exts[] = {".it", ".xm", ".s3m", ".mod", NULL};
+        char cand[128];
+        for (int n=0; names[n]; ++n) {
+            for (int e=0; exts[e]; ++e) {
+                snprintf(cand, sizeof(cand), "%s%s", names[n], exts[e]);
+                sound_module = loadPackedModule(cand);
+                if (sound_module) {
+                    memAccount(MEM_SOUND, moduleBytes(sound_module));
+                    printf("Successfully loaded music: %s (packed)\n", cand);
+                    return 0;
+                }
+            }
+        }
+    }
 #ifdef ANDROID
     // Try APK assets via getFullPath() first, extracting to internal storage if needed
     const char* names[] = {"gltron", "music", NULL};
@@ -87,6 +193,7 @@ static int loadMusicModule(void) {
                 printf("Attempting to load music from: %s\n", p);
                 sound_module = Player_Load(p, 64, 0);
                 if (sound_module) {
+                    memAccount(MEM_SOUND, moduleBytes(sound_module));
                     printf("Successfully loaded music: %s\n", p);
                     free(p);
                     return 0;
@@ -109,6 +216,7 @@ static int loadMusicModule(void) {
                 printf("Attempting to load music from: %s\n", full);
                 sound_module = Player_Load(full, 64, 0);
                 if (sound_module) {
+                    memAccount(MEM_SOUND, moduleBytes(sound_module));
                     printf("Successfully loaded music: %s\n", full);
                     return 0;
                 }
@@ -213,6 +321,21 @@ int initSound(void) {
 
 // Load a sample (SFX) from file
 int loadSampleEffect(char* name, SAMPLE** sfx_out) {
+    {
+        // the pack first, without probing the data directories
+        const char* exts[] = {".wav", ".aiff", ".aif", ".au", NULL};
+        char cand[256];
+        for (int e=0; exts[e]; ++e) {
+            snprintf(cand, sizeof(cand), "%s%s", name, exts[e]);
+            SAMPLE* s = loadPackedSample(cand);
+            if (s) {
+                *sfx_out = s;
+                memAccount(MEM_SOUND, sampleBytes(s));
+                printf("Successfully loaded sample: %s (packed)\n", cand);
+                return 0;
+            }
+        }
+    }
 #ifdef ANDROID
     const char* exts[] = {".wav", ".aiff", ".aif", ".au", NULL};
     *sfx_out = NULL;
@@ -225,6 +348,7 @@ int loadSampleEffect(char* name, SAMPLE** sfx_out) {
             SAMPLE* s = Sample_Load(p);
             if (s) {
                 *sfx_out = s;
+                memAccount(MEM_SOUND, sampleBytes(s));
                 printf("Successfully loaded sample: %s\n", p);
                 free(p);
                 return 0;
@@ -252,6 +376,7 @@ int loadSampleEffect(char* name, SAMPLE** sfx_out) {
             SAMPLE* s = Sample_Load(full);
             if (s) {
                 *sfx_out = s;
+                memAccount(MEM_SOUND, sampleBytes(s));
                 printf("Successfully loaded sample: %s\n", full);
                 return 0;
             }
@@ -283,6 +408,7 @@ int loadSound(char* name) {
         printf("Could not load module: %s\n", MikMod_strerror(MikMod_errno));
         return 1;
     }
+    memAccount(MEM_SOUND, moduleBytes(sound_module));
     return 0;
 }
 
@@ -334,17 +460,19 @@ void deleteSound(void) {
         Player_Stop();
 
     // Free the main sound module
-    if (sound_module)
+    if (sound_module) {
+        memAccount(MEM_SOUND, -moduleBytes(sound_module));
         Player_Free(sound_module);
+    }
 
     // Free sound effects
-    if (crash_sfx) Sample_Free(crash_sfx);
-    if (lose_sfx) Sample_Free(lose_sfx);
-    if (win_sfx) Sample_Free(win_sfx);
-    if (highlight_sfx) Sample_Free(highlight_sfx);
-    if (engine_sfx) Sample_Free(engine_sfx);
-    if (start_sfx) Sample_Free(start_sfx);
-    if (action_sfx) Sample_Free(action_sfx);
+    freeSample(crash_sfx);
+    freeSample(lose_sfx);
+    freeSample(win_sfx);
+    freeSample(highlight_sfx);
+    freeSample(engine_sfx);
+    freeSample(start_sfx);
+    freeSample(action_sfx);
 
     // Exit MikMod
     MikMod_Exit();
@@ -0,0 +1,271 @@
+#include "gltron.h"
+#include "sgi_texture.h"
+#include "startup.h"
+#include <string.h>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#define LOCK() pthread_mutex_lock(&lock)
+#define UNLOCK() pthread_mutex_unlock(&lock)
+#define WAIT() pthread_cond_wait(&changed, &lock)
+#define SIGNAL() pthread_cond_broadcast(&changed)
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+#else
+/* no workers: the main thread runs every task when it needs it */
+#define LOCK()
+#define UNLOCK()
+#define WAIT()
+#define SIGNAL()
+#endif
+
+#define MAX_WORKERS 4
+
+enum { TASK_HELD, TASK_WAITING, TASK_RUNNING, TASK_DONE };
+
+typedef struct StartupTask {
+  const char *name;
+  void* (*run)(const char *name);
+  const char *after; /* task that has to be done first */
+  int sound;         /* held until startupSound() */
+  int state;
+  void *result;
+  double ms;
+} StartupTask;
+
+static void* loadTextureTask(const char *name) {
+  /* precompiled ones are uploaded straight from the file */
+  if(hasTextureFile(name))
+    return NULL;
+  return load_sgi_texture((char*) name);
+}
+
+static void* loadFontTask(const char *name) {
+  return ftxLoadFont((char*) name);
+}
+
+static void* loadModelTask(const char *name) {
+  return getModel(name, CYCLE_HEIGHT, 1);
+}
+
+#ifdef SOUND
+static void* initSoundTask(const char *name) {
+  printf("initializing sound\n");
+  initSound();
+  return NULL;
+}
+
+/* non-NULL if the music could be loaded */
+static void* loadMusicTask(const char *name) {
+  char *path = getFullPath((char*) name);
+  int failed = path == 0 || loadSound(path);
+
+  free(path);
+  if(failed) {
+    printf("error trying to load sound\n");
+    return NULL;
+  }
+  return (void*) name;
+}
+#endif
+
+/* slow ones first, the workers take them in order */
+static StartupTask tasks[] = {
+#ifdef SOUND
+  { "sound", initSoundTask, NULL, 1 },
+  { "gltron.it", loadMusicTask, "sound", 1 },
+#endif
+  { "xenotron.ftx", loadFontTask },
+  { "gltron_floor.sgi", loadTextureTask },
+  { "gltron.sgi", loadTextureTask },
+  { "gltron_wall.sgi", loadTextureTask },
+  { "gltron_crash.sgi", loadTextureTask },
+  { "t-u-low.obj", loadModelTask }
+};
+#define N_TASKS ((int) (sizeof(tasks) / sizeof(tasks[0])))
+
+#ifndef WIN32
+static pthread_t workers[MAX_WORKERS];
+#endif
+static int nWorkers = 0;
+static int started = 0;
+static double begin = -1;
+
+static double startupMs(void) {
+#ifdef WIN32
+  return GetTickCount();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+static StartupTask* findTask(const char *name) {
+  int i;
+  for(i = 0; i < N_TASKS; i++)
+    if(strcmp(tasks[i].name, name) == 0)
+      return tasks + i;
+  return NULL;
+}
+
+/* the first task t depends on that can run now, NULL if none */
+static StartupTask* readyTask(StartupTask *t) {
+  while(t != NULL && t->state != TASK_DONE) {
+    StartupTask *dep = t->after ? findTask(t->after) : NULL;
+    if(dep == NULL || dep->state == TASK_DONE)
+      return t->state == TASK_WAITING ? t : NULL;
+    t = dep;
+  }
+  return NULL;
+}
+
+static StartupTask* nextTask(void) {
+  StartupTask *t;
+  int i;
+  for(i = 0; i < N_TASKS; i++)
+    if((t = readyTask(tasks + i)) != NULL)
+      return t;
+  return NULL;
+}
+
+static int pending(void) {
+  int i;
+  for(i = 0; i < N_TASKS; i++)
+    if(tasks[i].state != TASK_DONE)
+      return 1;
+  return 0;
+}
+
+/* called locked, returns locked */
+static void runTask(StartupTask *t) {
+  double start;
+
+  t->state = TASK_RUNNING;
+  UNLOCK();
+  start = startupMs();
+  t->result = t->run(t->name);
+  t->ms = startupMs() - start;
+  LOCK();
+  t->state = TASK_DONE;
+  SIGNAL();
+}
+
+#ifndef WIN32
+static void* worker(void *unused) {
+  StartupTask *t;
+
+  LOCK();
+  while(pending()) {
+    if((t = nextTask()) != NULL)
+      runTask(t);
+    else
+      WAIT();
+  }
+  UNLOCK();
+  return NULL;
+}
+#endif
+
+void startupBegin(void) {
+  begin = startupMs();
+}
+
+void startupTasks(void) {
+  int i;
+
+  for(i = 0; i < N_TASKS; i++) {
+    tasks[i].state = tasks[i].sound ? TASK_HELD : TASK_WAITING;
+    tasks[i].result = NULL;
+  }
+  started = 1;
+
+  /* map the pack before anyone asks for a file from it */
+  initPack();
+
+#ifndef WIN32
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = cpus > MAX_WORKERS ? MAX_WORKERS : cpus > 1 ? cpus : 1;
+
+    for(nWorkers = 0; nWorkers < n; nWorkers++)
+      if(pthread_create(&workers[nWorkers], NULL, worker, NULL) != 0)
+        break;
+  }
+#endif
+}
+
+void startupSound(void) {
+  int i;
+
+  LOCK();
+  for(i = 0; i < N_TASKS; i++)
+    if(tasks[i].state == TASK_HELD)
+      tasks[i].state = TASK_WAITING;
+  SIGNAL();
+  UNLOCK();
+}
+
+void* startupResult(const char *name) {
+  StartupTask *t = findTask(name), *ready;
+  void *result;
+
+  if(!started || t == NULL || t->state == TASK_HELD)
+    return NULL;
+
+  /* rather than wait for a worker, do it ourselves */
+  LOCK();
+  while(t->state != TASK_DONE) {
+    if((ready = readyTask(t)) != NULL)
+      runTask(ready);
+    else
+      WAIT();
+  }
+  result = t->result;
+  t->result = NULL;
+  UNLOCK();
+  return result;
+}
+
+void startupWait(void) {
+  StartupTask *t;
+  double busy = 0;
+  int i;
+
+  if(!started)
+    return;
+
+  LOCK();
+  /* never released: skipped */
+  for(i = 0; i < N_TASKS; i++)
+    if(tasks[i].state == TASK_HELD)
+      tasks[i].state = TASK_DONE;
+  SIGNAL();
+  while(pending()) {
+    if((t = nextTask()) != NULL)
+      runTask(t);
+    else
+      WAIT();
+  }
+  UNLOCK();
+
+#ifndef WIN32
+  for(i = 0; i < nWorkers; i++)
+    pthread_join(workers[i], NULL);
+#endif
+  started = 0;
+
+  for(i = 0; i < N_TASKS; i++)
+    busy += tasks[i].ms;
+  LOGI("startup: %.0f ms of loading on %d threads, done after %.0f ms\n",
+       busy, nWorkers + 1, startupMs() - begin);
+}
+
+void startupFrame(void) {
+  if(begin < 0)
+    return;
+  LOGI("startup: first menu frame after %.0f ms\n", startupMs() - begin);
+  begin = -1;
+}
@@ -0,0 +1,25 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+/*
+  startup tasks: loading and decoding the game data (textures, font,
+  cycle model, sound) on worker threads while the main thread parses
+  the menu and brings up the window. Anything touching GL stays on the
+  main thread, which picks the decoded data up by file name.
+*/
+
+extern void startupBegin(void);
+/* starts the workers on the data files */
+extern void startupTasks(void);
+/* lets the sound tasks run; the menu may play or stop sound while it
+   is loaded, so they are held back until then */
+extern void startupSound(void);
+/* result of the task for name, waiting for it if it still runs; the
+   caller owns it. NULL if there is no such task or it was taken. */
+extern void* startupResult(const char *name);
+/* finishes the remaining tasks and stops the workers */
+extern void startupWait(void);
+/* logs the time to the first menu frame, once */
+extern void startupFrame(void);
+
+#endif
@@ -0,0 +1,333 @@
+/*
+  render stress scenes
+
+  Builds arenas that a normal match rarely reaches: every player with a
+  long, dense zigzag trail, some of them crashing, split over several
+  viewports. A scripted chase camera laps the arena through drawCam()
+  and every configuration reports its render time, draw calls, render
+  commands, state changes and polygons per frame. Runs offscreen
+  through the capture mode.
+
+  gltron --stress [--players=1,4] [--segments=100,999] [--crashing=0,2]
+                  [--viewports=1,4] [--frames=N] [--size=WxH]
+                  [--capture=DIR] [--null]
+
+  Each option takes a comma separated list, all combinations are run.
+  With --null only the culling and the command list of the world
+  buffer are run, into the null render backend: the CPU side of the
+  scene without any drawing.
+*/
+
+#include "gltron.h"
+
+#ifdef CAPTURE
+
+#include <string.h>
+
+#define STRESS_VALUES 8
+#define STRESS_MARGIN 2.0   /* trails keep off the arena walls */
+#define STRESS_LAP 20.0     /* camera lap distance from the walls */
+#define STRESS_WARMUP 5     /* untimed frames per configuration */
+
+typedef struct StressList {
+  int n;
+  int v[STRESS_VALUES];
+} StressList;
+
+static int stressing = 0;
+static int stress_null = 0;
+static StressList stress_players = { 2, { 1, 4 } };
+static StressList stress_segments = { 2, { 100, MAX_TRAIL - 1 } };
+static StressList stress_crashing = { 2, { 0, 2 } };
+static StressList stress_viewports = { 2, { 1, 4 } };
+
+/* 1, 2 or 4 viewports -> display_type */
+static int displayType(int viewports) {
+  int i;
+  for(i = 0; i < 3; i++)
+    if(vp_max[i] == viewports)
+      return i;
+  return -1;
+}
+
+static void parseList(StressList *l, char *s, char *name, int lo, int hi) {
+  char *end;
+  long v;
+
+  l->n = 0;
+  while(*s) {
+    v = strtol(s, &end, 10);
+    if(end == s || (*end != ',' && *end != 0) || v < lo || v > hi ||
+       l->n == STRESS_VALUES) {
+      fprintf(stderr, "stress: --%s takes up to %d values in %d..%d\n",
+              name, STRESS_VALUES, lo, hi);
+      exit(1);
+    }
+    l->v[l->n++] = v;
+    s = (*end == ',') ? end + 1 : end;
+  }
+  if(l->n == 0) {
+    fprintf(stderr, "stress: --%s is empty\n", name);
+    exit(1);
+  }
+}
+
+int stressArg(char *arg) {
+  int i;
+
+  if(strcmp(arg, "--stress") == 0)
+    ;
+  else if(strcmp(arg, "--null") == 0)
+    stress_null = 1;
+  else if(strncmp(arg, "--players=", 10) == 0)
+    parseList(&stress_players, arg + 10, "players", 1, MAX_PLAYERS);
+  else if(strncmp(arg, "--segments=", 11) == 0)
+    parseList(&stress_segments, arg + 11, "segments", 1, MAX_TRAIL - 1);
+  else if(strncmp(arg, "--crashing=", 11) == 0)
+    parseList(&stress_crashing, arg + 11, "crashing", 0, MAX_PLAYERS);
+  else if(strncmp(arg, "--viewports=", 12) == 0) {
+    parseList(&stress_viewports, arg + 12, "viewports", 1, MAX_PLAYERS);
+    for(i = 0; i < stress_viewports.n; i++)
+      if(displayType(stress_viewports.v[i]) < 0) {
+        fprintf(stderr, "stress: --viewports must be 1, 2 or 4\n");
+        exit(1);
+      }
+  } else
+    return 0;
+
+  stressing = 1;
+  return 1;
+}
+
+int stressEnabled() {
+  return stressing;
+}
+
+/* boustrophedon over the player's horizontal band of the arena: long
+   runs alternating with short steps, so no two segments merge */
+static void zigzag(Data *data, int band, int bands, int segments) {
+  float h = (float) GSIZE / bands;
+  float x = STRESS_MARGIN;
+  float y = band * h + STRESS_MARGIN;
+  float dy = (h - 2 * STRESS_MARGIN) / (segments / 2 > 0 ? segments / 2 : 1);
+  int right = 1;
+  line *l = data->trails;
+  int k;
+
+  for(k = 0; k < segments; k++, l++) {
+    l->sx = x;
+    l->sy = y;
+    if(k % 2 == 0) {
+      x = right ? GSIZE - STRESS_MARGIN : STRESS_MARGIN;
+      data->dir = right ? 3 : 1;
+      right = !right;
+    } else {
+      y += dy;
+      data->dir = 2;
+    }
+    l->ex = x;
+    l->ey = y;
+  }
+
+  data->trail = l - 1;
+  data->posx = x;
+  data->posy = y;
+  data->last_dir = data->dir;
+}
+
+static void buildScene(int players, int segments, int crashing,
+                       int viewports) {
+  Data *data;
+  int i;
+
+  game->players = players;
+  initData();
+
+  game->settings->display_type = displayType(viewports);
+  for(i = 0; i < viewports; i++)
+    game->settings->content[i] = i;
+  changeDisplay();
+
+  /* the last players are the crashing ones, viewers come first */
+  for(i = 0; i < players; i++) {
+    data = game->player[i].data;
+    zigzag(data, i, players, segments);
+    data->turn_time = getElapsedTime() - 10000; /* no turn animation */
+    if(i >= players - crashing) {
+      data->speed = SPEED_CRASHED;
+      data->exp_radius = 1;
+    }
+  }
+  game->running = players - crashing;
+}
+
+/* puts a viewer on a lap around the arena, t in [0, 1) */
+static void placeViewer(Player *p, float t) {
+  static int legdir[] = { 3, 2, 1, 0 };
+  float lo = STRESS_LAP, hi = GSIZE - STRESS_LAP;
+  float s = t * 4;
+  int leg = (int) s & 3;
+  float f = (s - (int) s) * (hi - lo);
+  Data *data = p->data;
+  Camera *cam = p->camera;
+
+  switch(leg) {
+  case 0: data->posx = lo + f; data->posy = lo; break;
+  case 1: data->posx = hi; data->posy = lo + f; break;
+  case 2: data->posx = hi - f; data->posy = hi; break;
+  default: data->posx = lo; data->posy = hi - f; break;
+  }
+  data->dir = data->last_dir = legdir[leg];
+
+  /* the chase camera of drawCam(), also used for the light */
+  cam->cam[0] = data->posx - dirsX[data->dir] * CAM_FOLLOW_DIST;
+  cam->cam[1] = data->posy - dirsY[data->dir] * CAM_FOLLOW_DIST;
+  cam->cam[2] = CAM_FOLLOW_Z;
+  cam->target[0] = data->posx;
+  cam->target[1] = data->posy;
+  cam->target[2] = 0;
+}
+
+static void stressFrames(int frames, int viewports, double *ms, double *worst,
+                         int *draws, int *commands, int *changes, int *polys) {
+  double t;
+  int f, i, n, c;
+  Data *data;
+
+  *ms = *worst = 0;
+  *draws = *commands = *changes = *polys = 0;
+  for(f = -STRESS_WARMUP; f < frames; f++) {
+    for(i = 0; i < viewports; i++)
+      placeViewer(&(game->player[i]),
+                  (float) ((f + frames) % frames) / frames +
+                  (float) i / viewports);
+
+    /* keep the explosions going */
+    for(i = 0; i < game->players; i++) {
+      data = game->player[i].data;
+      if(data->speed == SPEED_CRASHED)
+        data->exp_radius = 1 + (f + STRESS_WARMUP + 7 * i) %
+          (EXP_RADIUS_MAX - 2);
+    }
+
+    drawcalls = 0;
+    renderStats(&n, &c); /* counts from here on */
+    t = captureMs();
+    if(stress_null) {
+      polycount = 0;
+      arenaReset(&frame_arena);
+      prepareWorld();
+      for(i = 0; i < viewports; i++)
+        traverseWorld(&(game->player[i]), game->player[i].display);
+    } else {
+      displayGame();
+      glFinish();
+    }
+    t = captureMs() - t;
+    renderStats(&n, &c);
+
+    if(f >= 0) {
+      *ms += t;
+      if(t > *worst)
+        *worst = t;
+      *draws += drawcalls;
+      *commands += n;
+      *changes += c;
+      *polys += polycount;
+    }
+  }
+  *ms /= frames;
+  *draws /= frames;
+  *commands /= frames;
+  *changes /= frames;
+  *polys /= frames;
+}
+
+/* back to a normal match */
+static void leaveScene(int display_type, const int *content) {
+  game->players = PLAYERS;
+  game->settings->display_type = display_type;
+  memcpy(game->settings->content, content, sizeof(game->settings->content));
+  initData();
+  changeDisplay();
+}
+
+void runStress(int frames, FILE *csv) {
+  int a, b, c, d;
+  int players, segments, crashing, viewports;
+  int draws, commands, changes, polys, skipped = 0;
+  int display_type = game->settings->display_type;
+  int content[4];
+  double ms, worst;
+
+  memcpy(content, game->settings->content, sizeof(content));
+
+  printf("stress: %d frames per configuration, %dx%d%s\n",
+         frames, game->screen->w, game->screen->h,
+         stress_null ? ", null backend" : "");
+  printf("players segments crashing viewports   ms/frame   worst  draws"
+         "   cmds  states  polys\n");
+  if(csv != NULL)
+    fprintf(csv, "players,segments,crashing,viewports,"
+            "ms_frame,ms_worst,draws,commands,state_changes,polys\n");
+  if(stress_null)
+    renderBackend(RENDER_NULL);
+
+  for(a = 0; a < stress_players.n; a++)
+    for(b = 0; b < stress_segments.n; b++)
+      for(c = 0; c < stress_crashing.n; c++)
+        for(d = 0; d < stress_viewports.n; d++) {
+          players = stress_players.v[a];
+          segments = stress_segments.v[b];
+          crashing = stress_crashing.v[c];
+          viewports = stress_viewports.v[d];
+          /* every viewport follows its own player */
+          if(crashing > players || viewports > players) {
+            skipped++;
+            continue;
+          }
+
+          buildScene(players, segments, crashing, viewports);
+          stressFrames(frames, viewports, &ms, &worst,
+                       &draws, &commands, &changes, &polys);
+
+          printf("%7d %8d %8d %9d %10.3f %7.3f %6d %6d %7d %6d\n",
+                 players, segments, crashing, viewports,
+                 ms, worst, draws, commands, changes, polys);
+          if(csv != NULL)
+            fprintf(csv, "%d,%d,%d,%d,%.3f,%.3f,%d,%d,%d,%d\n",
+                    players, segments, crashing, viewports,
+                    ms, worst, draws, commands, changes, polys);
+        }
+
+  renderBackend(RENDER_GL);
+  if(skipped)
+    printf("stress: skipped %d configurations with more crashing players "
+           "or viewports than players\n", skipped);
+
+  leaveScene(display_type, content);
+}
+
+/* ms per frame of one configuration, for perf.c */
+double stressMs(int players, int segments, int crashing, int viewports,
+                int frames, int null_backend) {
+  int draws, commands, changes, polys;
+  int display_type = game->settings->display_type;
+  int content[4];
+  int was_null = stress_null;
+  double ms, worst;
+
+  memcpy(content, game->settings->content, sizeof(content));
+  stress_null = null_backend;
+  if(stress_null)
+    renderBackend(RENDER_NULL);
+  buildScene(players, segments, crashing, viewports);
+  stressFrames(frames, viewports, &ms, &worst,
+               &draws, &commands, &changes, &polys);
+  renderBackend(RENDER_GL);
+  stress_null = was_null;
+  leaveScene(display_type, content);
+  return ms;
+}
+
+#endif
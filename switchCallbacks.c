@@ -16,26 +16,32 @@ void switchCallbacks(callbacks *new) {
 #else
   last_callback = current_callback;
   current_callback = new;
+  /* rounds are played on the simulation thread */
+  simScreen(new);
 
-  glutIdleFunc(new->idle);
-  glutDisplayFunc(new->display);
-  glutKeyboardFunc(new->keyboard);
-  glutSpecialFunc(new->special);
-  /* register mouse handlers depending on mode */
-  /* always register reshape */
-  glutReshapeFunc(onReshape);
-  if (new == &guiCallbacks) {
-    glutMouseFunc(mouseGui);
-    glutMotionFunc(motionGui);
-    glutPassiveMotionFunc(motionGui);
-  } else if (new == &gameCallbacks) {
-    glutMouseFunc(mouseGame);
-    glutMotionFunc(motionGame);
-    glutPassiveMotionFunc(motionGame);
-  } else if (new == &pauseCallbacks) {
-    glutMouseFunc(mousePause);
-    glutMotionFunc(motionPause);
-    glutPassiveMotionFunc(motionPause);
+  /* offscreen captures drive the callbacks themselves */
+  if (!capturing) {
+    /* the menu and pause screens only redraw when something changes */
+    glutIdleFunc(redrawOnDemand(new) ? NULL : new->idle);
+    glutDisplayFunc(new->display);
+    glutKeyboardFunc(new->keyboard);
+    glutSpecialFunc(new->special);
+    /* register mouse handlers depending on mode */
+    /* always register reshape */
+    glutReshapeFunc(onReshape);
+    if (new == &guiCallbacks) {
+      glutMouseFunc(mouseGui);
+      glutMotionFunc(motionGui);
+      glutPassiveMotionFunc(motionGui);
+    } else if (new == &gameCallbacks) {
+      glutMouseFunc(mouseGame);
+      glutMotionFunc(motionGame);
+      glutPassiveMotionFunc(motionGame);
+    } else if (new == &pauseCallbacks) {
+      glutMouseFunc(mousePause);
+      glutMotionFunc(motionPause);
+      glutPassiveMotionFunc(motionPause);
+    }
   }
   lasttime = getElapsedTime();
 
@@ -51,7 +57,7 @@ void updateCallbacks() {
 #ifdef ANDROID
   android_updateCallbacks();
 #else
-  glutIdleFunc(current_callback->idle);
+  glutIdleFunc(redrawOnDemand(current_callback) ? NULL : current_callback->idle);
   glutDisplayFunc(current_callback->display);
   glutKeyboardFunc(current_callback->keyboard);
   glutSpecialFunc(current_callback->special);
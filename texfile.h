@@ -0,0 +1,55 @@
+#ifndef TEXFILE_H
+#define TEXFILE_H
+
+#include <stdint.h>
+
+/*
+  precompiled textures (.gtx), written by tools/mktex.c from an .sgi:
+  the whole mip chain down to 1x1, either as RGBA bytes or in one of the
+  GPU block formats, ready for glTexImage2D / glCompressedTexImage2D.
+
+  TexHeader | levels * TexLevel | level data (16 byte aligned)
+
+  Offsets are from the start of the file. Block formats store 4x4 pixel
+  blocks, levels smaller than that still take a whole block.
+
+  foo.sgi comes as foo.gtx (RGBA), foo.bc.gtx (BC1 / BC3) and
+  foo.etc.gtx (ETC1 / ETC2 + EAC); the game takes the first one the GL
+  can use, the compressed ones first.
+*/
+#define TEX_MAGIC "GLTTEX1"
+
+enum {
+  TEX_RGBA8,    /* 4 bytes per pixel */
+  TEX_BC1,      /* DXT1, opaque: 8 bytes per block */
+  TEX_BC3,      /* DXT5: 16 bytes per block */
+  TEX_ETC1,     /* opaque, also valid ETC2 RGB8: 8 bytes per block */
+  TEX_ETC2_EAC  /* EAC alpha + ETC colour: 16 bytes per block */
+};
+
+typedef struct {
+  char magic[8];
+  int32_t format;
+  int32_t width;
+  int32_t height;
+  int32_t levels;
+} TexHeader;
+
+typedef struct {
+  int32_t width;
+  int32_t height;
+  uint32_t offset;
+  uint32_t size;
+} TexLevel;
+
+/* bytes of a w x h level */
+static inline uint32_t texLevelSize(int format, int w, int h) {
+  uint32_t blocks = ((w + 3) / 4) * ((h + 3) / 4);
+  switch(format) {
+  case TEX_RGBA8: return (uint32_t) w * h * 4;
+  case TEX_BC1: case TEX_ETC1: return blocks * 8;
+  default: return blocks * 16;
+  }
+}
+
+#endif
@@ -1,29 +1,204 @@
 #include "gltron.h"
 #include "sgi_texture.h"
+#include "texfile.h"
+#include "shaders.h"
+#include <string.h>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
 
 void deleteTextures(gDisplay *d) {
+  memGpuObject(MEM_GPU_TEXTURE, d->texFloor, 0);
+  memGpuObject(MEM_GPU_TEXTURE, d->texWall, 0);
+  memGpuObject(MEM_GPU_TEXTURE, d->texGui, 0);
+  memGpuObject(MEM_GPU_TEXTURE, d->texCrash, 0);
   glDeleteTextures(1, &(d->texFloor));
   glDeleteTextures(1, &(d->texWall));
   glDeleteTextures(1, &(d->texGui));
   glDeleteTextures(1, &(d->texCrash));
+  /* deleted names may come back from glGenTextures */
+  invalidateStateCache();
 }
 
-void loadTexture(char *filename, int format) {
-    char *path;
-    sgi_texture *tex;
+/* GL formats for the .gtx block formats, 0 if the GL can't take one */
+static GLenum block_formats[TEX_ETC2_EAC + 1];
+
+static void initBlockFormats(void) {
+  block_formats[TEX_RGBA8] = GL_RGBA;
+#ifndef WIN32
+  /* opengl32.dll has no glCompressedTexImage2D, only the RGBA mips there */
+  const char *extensions = (const char*) glGetString(GL_EXTENSIONS);
+  const char *version = (const char*) glGetString(GL_VERSION);
+  int s3tc = extensions && strstr(extensions, "GL_EXT_texture_compression_s3tc");
+  int etc2;
 
 #ifdef ANDROID
-    __android_log_print(ANDROID_LOG_INFO, "GLTron", "loadTexture: requesting '%s'", filename);
+  etc2 = version && strncmp(version, "OpenGL ES 3", 11) == 0;
+  if(etc2)
+    block_formats[TEX_ETC1] = GL_COMPRESSED_RGB8_ETC2;
+  else if(extensions && strstr(extensions, "GL_OES_compressed_ETC1_RGB8_texture"))
+    block_formats[TEX_ETC1] = GL_ETC1_RGB8_OES;
+#else
+  {
+    int major = 0, minor = 0;
+    if(version)
+      sscanf(version, "%d.%d", &major, &minor);
+    etc2 = major * 10 + minor >= 43 ||
+      (extensions && strstr(extensions, "GL_ARB_ES3_compatibility"));
+  }
+  if(etc2)
+    block_formats[TEX_ETC1] = GL_COMPRESSED_RGB8_ETC2;
+#endif
+  if(etc2)
+    block_formats[TEX_ETC2_EAC] = GL_COMPRESSED_RGBA8_ETC2_EAC;
+  if(s3tc) {
+    block_formats[TEX_BC1] = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    block_formats[TEX_BC3] = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  }
 #endif
-    path = getFullPath(filename);
+}
+
+/* checks a .gtx before anything is read from it */
+static int texValid(const unsigned char *data, size_t size) {
+  const TexHeader *h = (const TexHeader*) data;
+  const TexLevel *l = (const TexLevel*) (h + 1);
+  int i;
+
+  if(size < sizeof(TexHeader) || memcmp(h->magic, TEX_MAGIC, 8) != 0)
+    return 0;
+  if(h->format < TEX_RGBA8 || h->format > TEX_ETC2_EAC ||
+     h->levels <= 0 ||
+     (size_t) h->levels > (size - sizeof(TexHeader)) / sizeof(TexLevel))
+    return 0;
+  for(i = 0; i < h->levels; i++)
+    if(l[i].width <= 0 || l[i].height <= 0 || l[i].offset > size ||
+       l[i].size != texLevelSize(h->format, l[i].width, l[i].height) ||
+       l[i].size > size - l[i].offset)
+      return 0;
+  return 1;
+}
+
+/* foo.sgi -> foo<variant>.gtx */
+static int texFileName(const char *filename, const char *variant,
+                       char *name, size_t size) {
+  const char *dot = strrchr(filename, '.');
+  int n = dot ? dot - filename : (int) strlen(filename);
+
+  return snprintf(name, size, "%.*s%s.gtx", n, filename, variant) < (int) size;
+}
+
+int hasTextureFile(const char *filename) {
+  char name[120];
+  size_t size;
+  FILE *f;
+
+  if(!texFileName(filename, "", name, sizeof(name)))
+    return 0;
+  if(packData(name, &size) != NULL)
+    return 1;
+  f = openAsset(name);
+  if(f != NULL)
+    fclose(f);
+  return f != NULL;
+}
+
+static GLuint boundTexture(void) {
+  GLint name = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &name);
+  return name;
+}
+
+/* uploads the precompiled mip chain of filename in the first variant the
+   GL takes, returns the number of levels, 0 if there was none */
+static int loadTextureFile(char *filename, int format) {
 #ifdef ANDROID
-    __android_log_print(ANDROID_LOG_INFO, "GLTron", "loadTexture: resolved path '%s'", path ? path : "(null)");
+  static const char *variants[] = { ".etc", ".bc", "" };
+#else
+  static const char *variants[] = { ".bc", ".etc", "" };
 #endif
-    if(path != 0)
-        tex = load_sgi_texture(path);
-    else {
+  static int initialized = 0;
+  const TexHeader *h;
+  const TexLevel *l;
+  const unsigned char *data;
+  char name[120];
+  char *blob;
+  size_t len;
+  int v, i;
+
+  if(!initialized) {
+    initBlockFormats();
+    initialized = 1;
+  }
+
+  for(v = 0; v < 3; v++) {
+    if(!texFileName(filename, variants[v], name, sizeof(name)))
+      return 0;
+    data = (const unsigned char*) loadModelFile(name, &len, &blob);
+    if(data == NULL)
+      continue;
+    if(!texValid(data, len)) {
+      fprintf(stderr, "ignoring broken %s\n", name);
+      free(blob);
+      continue;
+    }
+    h = (const TexHeader*) data;
+    if(block_formats[h->format] == 0) {
+      free(blob);
+      continue;
+    }
+
+    l = (const TexLevel*) (h + 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(i = 0; i < h->levels; i++) {
+#ifndef WIN32
+      if(h->format != TEX_RGBA8)
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, block_formats[h->format],
+                               l[i].width, l[i].height, 0, l[i].size,
+                               data + l[i].offset);
+      else
+#endif
+        glTexImage2D(GL_TEXTURE_2D, i, format, l[i].width, l[i].height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, data + l[i].offset);
+    }
+    LOGI("loaded %s, %d levels\n", name, h->levels);
+    memGpuObject(MEM_GPU_TEXTURE, boundTexture(),
+                 l[h->levels - 1].offset + l[h->levels - 1].size - l[0].offset);
+    i = h->levels;
+    free(blob);
+    return i;
+  }
+  return 0;
+}
+
+/* returns the number of mip levels */
+int loadTexture(char *filename, int format) {
+    sgi_texture *tex;
+    int levels;
+
 #ifdef ANDROID
-        __android_log_print(ANDROID_LOG_ERROR, "GLTron", "loadTexture: getFullPath failed for '%s'", filename);
+    __android_log_print(ANDROID_LOG_INFO, "GLTron", "loadTexture: requesting '%s'", filename);
+#endif
+    /* decoded by a startup task while the window came up */
+    tex = startupResult(filename);
+    levels = loadTextureFile(filename, format);
+    if(levels > 0) {
+        unload_sgi_texture(tex);
+        return levels;
+    }
+    if(tex == NULL)
+        tex = load_sgi_texture(filename);
+    if(tex == NULL) {
+#ifdef ANDROID
+        __android_log_print(ANDROID_LOG_ERROR, "GLTron", "loadTexture: can't load '%s'", filename);
 #endif
         fprintf(stderr, "fatal: could not load %s, exiting...\n", filename);
         exit(1);
@@ -37,53 +212,60 @@ void loadTexture(char *filename, int format) {
     GLint boundTex = 0; glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTex);
     __android_log_print(ANDROID_LOG_INFO, "GLTron", "loadTexture: uploaded '%s' to GL id %d (%dx%d)", filename, boundTex, tex->width, tex->height);
 #endif
-    free(tex->data);
-    free(tex);
+    memGpuObject(MEM_GPU_TEXTURE, boundTexture(),
+                 (size_t) tex->width * tex->height * 4);
+    unload_sgi_texture(tex);
+    return 1;
+}
+
+/* filters between the mip levels where there are some */
+static void setFilters(int levels) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 }
 
 void initTexture(gDisplay *d) {
+    int levels;
+
     checkGLError("texture.c initTexture - start");
 
     /* floor texture */
     glGenTextures(1, &(d->texFloor));
-    glBindTexture(GL_TEXTURE_2D, d->texFloor);
-    loadTexture("gltron_floor.sgi", GL_RGB);  // Changed from GL_RGB16 to GL_RGB
+    bindTexture2D(d->texFloor);
+    levels = loadTexture("gltron_floor.sgi", GL_RGB);  // Changed from GL_RGB16 to GL_RGB
     // Removed glTexEnvi calls
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    setFilters(levels);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     checkGLError("texture.c initTextures - floor");
 
     /* menu icon */
     glGenTextures(1, &(d->texGui));
-    glBindTexture(GL_TEXTURE_2D, d->texGui);
-    loadTexture("gltron.sgi", GL_RGBA);
+    bindTexture2D(d->texGui);
+    levels = loadTexture("gltron.sgi", GL_RGBA);
     // Removed glTexEnvi calls
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    setFilters(levels);
 
     checkGLError("texture.c initTextures - gui");
 
     /* wall texture */
     glGenTextures(1, &(d->texWall));
-    glBindTexture(GL_TEXTURE_2D, d->texWall);
-    loadTexture("gltron_wall.sgi", GL_RGBA);
+    bindTexture2D(d->texWall);
+    levels = loadTexture("gltron_wall.sgi", GL_RGBA);
     // Removed glTexEnvi calls
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    setFilters(levels);
 
     /* crash texture */
     glGenTextures(1, &(d->texCrash));
-    glBindTexture(GL_TEXTURE_2D, d->texCrash);
-    loadTexture("gltron_crash.sgi", GL_RGBA);
+    bindTexture2D(d->texCrash);
+    levels = loadTexture("gltron_crash.sgi", GL_RGBA);
     // Removed glTexEnvi calls
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    setFilters(levels);
 
     checkGLError("texture.c initTextures - end");
 }
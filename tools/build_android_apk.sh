@@ -191,6 +191,38 @@ cp -a "$ROOT_DIR"/*.sgi "$STAGE_DIR/assets/" 2>/dev/null || true
 cp -a "$ROOT_DIR"/*.ftx "$STAGE_DIR/assets/" 2>/dev/null || true
 cp -a "$ROOT_DIR"/*.wav "$STAGE_DIR/assets/" 2>/dev/null || true
 
+# Pack the read-only data into gltron.pak, which the game maps in place
+# instead of extracting every file (see pack.h), the music and the sound
+# effects included. The loose files stay as a fallback; settings.txt is
+# still read from them.
+HOST_CC="${HOST_CC:-cc}"
+if command -v "$HOST_CC" >/dev/null 2>&1; then
+  log "Building gltron.pak"
+  "$HOST_CC" -O2 -o "$STAGE_DIR/mkpack" "$ROOT_DIR/tools/mkpack.c" &&
+  "$HOST_CC" -O2 -o "$STAGE_DIR/mkmesh" "$ROOT_DIR/tools/mkmesh.c" \
+    "$ROOT_DIR/model.c" "$ROOT_DIR/mtllib.c" "$ROOT_DIR/geom.c" "$ROOT_DIR/memstat.c" -lm &&
+  "$HOST_CC" -O2 -o "$STAGE_DIR/mktex" "$ROOT_DIR/tools/mktex.c" \
+    "$ROOT_DIR/sgi_texture.c" "$ROOT_DIR/memstat.c" &&
+  (cd "$ROOT_DIR" && "$STAGE_DIR/mkmesh" t-u-low.obj "$STAGE_DIR/t-u-low.mesh" 8 1 &&
+   # mip mapped textures, ETC for GLES, the others where it's missing
+   for tex in gltron gltron_floor gltron_wall gltron_crash; do
+     "$STAGE_DIR/mktex" -etc $tex.sgi "$STAGE_DIR/$tex.etc.gtx" &&
+     "$STAGE_DIR/mktex" -bc $tex.sgi "$STAGE_DIR/$tex.bc.gtx" &&
+     "$STAGE_DIR/mktex" $tex.sgi "$STAGE_DIR/$tex.gtx" || exit 1
+   done &&
+   "$STAGE_DIR/mkpack" "$STAGE_DIR/assets/gltron.pak" \
+    menu.txt tron.mtl t-u-low.obj xenotron.ftx xenotron.0.sgi xenotron.1.sgi \
+    gltron.sgi gltron_floor.sgi gltron_wall.sgi gltron_crash.sgi \
+    gltron.it game_crash.wav game_lose.wav game_win.wav menu_highlight.wav \
+    game_engine.wav game_start.wav menu_action.wav \
+    "$STAGE_DIR/t-u-low.mesh" "$STAGE_DIR"/*.gtx) ||
+    err "Failed to build gltron.pak"
+  rm -f "$STAGE_DIR/mkpack" "$STAGE_DIR/mkmesh" "$STAGE_DIR/mktex" \
+    "$STAGE_DIR/t-u-low.mesh" "$STAGE_DIR"/*.gtx
+else
+  log "No host compiler ($HOST_CC), skipping gltron.pak"
+fi
+
 # Create strings.xml
 STRINGS_TEMP=$(mktemp)
 cat > "$STRINGS_TEMP" <<EOF
@@ -237,7 +269,7 @@ rm -f "$APK_OUT"
 
 if [[ -x "$AAPT" ]]; then
   log "Building APK with aapt (preferred for v1+v2 signing)"
-  "$AAPT" package -f \
+  "$AAPT" package -f -0 pak \
     -M "$STAGE_DIR/AndroidManifest.xml" \
     -S "$STAGE_DIR/res" \
     -A "$STAGE_DIR/assets" \
@@ -270,7 +302,8 @@ elif [[ -x "$AAPT2" ]]; then
   
   # Add assets and native libraries to the APK
   log "Adding assets and native libraries to APK..."
-  (cd "$STAGE_DIR" && zip -qur "$UNALIGNED_APK" assets lib || {
+  # the pack has to stay uncompressed to be mapped
+  (cd "$STAGE_DIR" && zip -qur -n .pak "$UNALIGNED_APK" assets lib || {
     err "Failed to add assets and libs to APK"
   })
 else
@@ -0,0 +1,183 @@
+/*
+  mkmesh: precompiles an .obj model into the binary .mesh format (see
+  model.h), so the game doesn't have to parse it at startup
+
+  mkmesh IN.obj OUT.mesh SIZE FLAGS
+  mkmesh -b OUT.obj TRIANGLES
+
+  SIZE and FLAGS are the loadModel() arguments the game uses for the
+  model (t-u-low.obj: 8 1); a .mesh built with other values is ignored
+  and the .obj is loaded instead. Build together with model.c, mtllib.c
+  and geom.c.
+
+  -b writes a synthetic model with about TRIANGLES triangles to OUT.obj
+  (and its .mesh) and prints how long loading either of them takes.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../model.h"
+#include "../pack.h"
+
+/* the loaders read plain files here, from the current directory */
+const void* packData(const char *name, size_t *size) {
+  return NULL;
+}
+
+FILE* openAsset(const char *filename) {
+  return fopen(filename, "rb");
+}
+
+static uint32_t align(uint32_t v) {
+  return (v + 15) & ~(uint32_t) 15;
+}
+
+static int writeMesh(Mesh *mesh, char *path, float size, int flags) {
+  MeshHeader header;
+  MeshFileMaterial *m;
+  FILE *out;
+  uint32_t offset;
+  int i, tris = 0;
+  static const char zero[16];
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MESH_MAGIC, 8);
+  header.size = size;
+  header.flags = flags;
+  header.nFaces = mesh->nFaces;
+  header.nMaterials = mesh->nMaterials;
+  memcpy(header.bbox, mesh->bbox, sizeof(header.bbox));
+
+  /* face counts first, then the triangles of every part */
+  m = calloc(mesh->nMaterials, sizeof(MeshFileMaterial));
+  offset = sizeof(header) + mesh->nMaterials * sizeof(MeshFileMaterial);
+  for(i = 0; i < mesh->nMaterials; i++) {
+    m[i].nFaces = mesh->meshparts[i].nFaces;
+    m[i].facetris = offset;
+    offset += m[i].nFaces;
+  }
+  for(i = 0; i < mesh->nMaterials; i++) {
+    Material *mat = mesh->materials + i;
+
+    if(strlen(mat->name) >= sizeof(m[i].name)) {
+      fprintf(stderr, "mkmesh: material name '%s' too long\n", mat->name);
+      return 1;
+    }
+    strcpy(m[i].name, mat->name);
+    memcpy(m[i].ambient, mat->ambient, sizeof(m[i].ambient));
+    memcpy(m[i].diffuse, mat->diffuse, sizeof(m[i].diffuse));
+    memcpy(m[i].specular, mat->specular, sizeof(m[i].specular));
+    m[i].nTriangles = mesh->meshparts[i].nTriangles;
+    m[i].triangles = offset = align(offset);
+    offset += m[i].nTriangles * 3 * MESH_STRIDE * sizeof(float);
+    tris += m[i].nTriangles;
+  }
+
+  out = fopen(path, "wb");
+  if(out == NULL) {
+    perror(path);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(m, sizeof(MeshFileMaterial), mesh->nMaterials, out);
+  for(i = 0; i < mesh->nMaterials; i++)
+    fwrite(mesh->meshparts[i].facetris, 1, m[i].nFaces, out);
+  offset = ftell(out);
+  for(i = 0; i < mesh->nMaterials; i++) {
+    fwrite(zero, align(offset) - offset, 1, out);
+    fwrite(mesh->meshparts[i].triangles, 3 * MESH_STRIDE * sizeof(float),
+           m[i].nTriangles, out);
+    offset = m[i].triangles + m[i].nTriangles * 3 * MESH_STRIDE * sizeof(float);
+  }
+  free(m);
+  if(fclose(out) != 0) {
+    perror(path);
+    return 1;
+  }
+
+  printf("mkmesh: %s, %d materials, %d faces, %d triangles, %u bytes\n",
+         path, mesh->nMaterials, mesh->nFaces, tris, offset);
+  return 0;
+}
+
+static double msSince(clock_t start) {
+  return (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/* a wavy n x n grid of quads with vertex normals */
+static int benchmark(char *path, long triangles) {
+  char meshpath[256];
+  FILE *f;
+  Mesh *mesh;
+  clock_t start;
+  int n, x, y;
+
+  for(n = 2; 2L * n * n < triangles; n++)
+    ;
+  f = fopen(path, "w");
+  if(f == NULL) {
+    perror(path);
+    return 1;
+  }
+  for(y = 0; y <= n; y++)
+    for(x = 0; x <= n; x++) {
+      float h = sin(x * 0.1) * cos(y * 0.1);
+      fprintf(f, "v %f %f %f\n", (float) x, (float) y, h);
+      fprintf(f, "vn %f %f %f\n", -cos(x * 0.1) * cos(y * 0.1) * 0.1,
+              sin(x * 0.1) * sin(y * 0.1) * 0.1, 1.0);
+    }
+  for(y = 0; y < n; y++)
+    for(x = 0; x < n; x++) {
+      int a = y * (n + 1) + x + 1, b = a + n + 1;
+      fprintf(f, "f %d//%d %d//%d %d//%d %d//%d\n",
+              a, a, a + 1, a + 1, b + 1, b + 1, b, b);
+    }
+  if(fclose(f) != 0) {
+    perror(path);
+    return 1;
+  }
+
+  start = clock();
+  mesh = loadModelObj(path, 8, 1);
+  if(mesh == NULL)
+    return 1;
+  printf("mkmesh: parsed %s, %d triangles in %.1f ms\n",
+         path, mesh->meshparts[0].nTriangles, msSince(start));
+
+  snprintf(meshpath, sizeof(meshpath), "%.*s.mesh",
+           (int) (strrchr(path, '.') ? strrchr(path, '.') - path : strlen(path)),
+           path);
+  if(writeMesh(mesh, meshpath, 8, 1) != 0)
+    return 1;
+  unloadModel(mesh);
+
+  start = clock();
+  mesh = loadModel(path, 8, 1);
+  printf("mkmesh: loaded %s in %.1f ms\n", meshpath, msSince(start));
+  unloadModel(mesh);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  Mesh *mesh;
+  float size;
+  int flags;
+
+  if(argc == 4 && strcmp(argv[1], "-b") == 0)
+    return benchmark(argv[2], atol(argv[3]));
+  if(argc != 5) {
+    fprintf(stderr, "usage: %s IN.obj OUT.mesh SIZE FLAGS\n"
+            "       %s -b OUT.obj TRIANGLES\n", argv[0], argv[0]);
+    return 1;
+  }
+  size = atof(argv[3]);
+  flags = atoi(argv[4]);
+
+  mesh = loadModelObj(argv[1], size, flags);
+  if(mesh == NULL)
+    return 1;
+  return writeMesh(mesh, argv[2], size, flags);
+}
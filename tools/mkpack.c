@@ -0,0 +1,132 @@
+/*
+  mkpack: builds gltron.pak (see pack.h) from the game data files
+
+  mkpack OUT.pak FILE...
+
+  Files are stored under their base name, which is how the game asks
+  for them.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../pack.h"
+
+typedef struct {
+  char *name;
+  unsigned char *data;
+  uint32_t size;
+} PackFile;
+
+static unsigned char* readFile(char *path, uint32_t *size) {
+  FILE *f = fopen(path, "rb");
+  unsigned char *data;
+  long len;
+
+  if(f == NULL) {
+    perror(path);
+    exit(1);
+  }
+  fseek(f, 0, SEEK_END);
+  len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  data = malloc(len > 0 ? len : 1);
+  if(data == NULL || fread(data, 1, len, f) != (size_t) len) {
+    fprintf(stderr, "mkpack: can't read %s\n", path);
+    exit(1);
+  }
+  fclose(f);
+  *size = len;
+  return data;
+}
+
+static char* baseName(char *path) {
+  char *s = strrchr(path, '/');
+#ifdef WIN32
+  char *b = strrchr(path, '\\');
+  if(b > s) s = b;
+#endif
+  return s ? s + 1 : path;
+}
+
+static uint32_t align(uint32_t v) {
+  return (v + PACK_ALIGN - 1) & ~(uint32_t) (PACK_ALIGN - 1);
+}
+
+int main(int argc, char *argv[]) {
+  PackHeader header;
+  PackEntry *table;
+  PackFile *files;
+  FILE *out;
+  uint32_t slots, names, offset, i, j, n;
+  static const char zero[PACK_ALIGN];
+
+  if(argc < 3) {
+    fprintf(stderr, "usage: %s OUT.pak FILE...\n", argv[0]);
+    return 1;
+  }
+
+  n = argc - 2;
+  files = calloc(n, sizeof(PackFile));
+  for(i = 0; i < n; i++) {
+    files[i].name = baseName(argv[i + 2]);
+    files[i].data = readFile(argv[i + 2], &files[i].size);
+    for(j = 0; j < i; j++)
+      if(strcmp(files[i].name, files[j].name) == 0) {
+        fprintf(stderr, "mkpack: %s given twice\n", files[i].name);
+        return 1;
+      }
+  }
+
+  /* at most half full, probes stay short */
+  for(slots = 1; slots < 2 * n; slots *= 2)
+    ;
+  table = calloc(slots, sizeof(PackEntry));
+
+  names = sizeof(PackHeader) + slots * sizeof(PackEntry);
+  offset = names;
+  for(i = 0; i < n; i++)
+    offset += strlen(files[i].name) + 1;
+
+  for(i = 0; i < n; i++) {
+    uint32_t hash = packHash(files[i].name);
+    PackEntry *e;
+
+    for(j = hash & (slots - 1); table[j].name != 0; j = (j + 1) & (slots - 1))
+      ;
+    e = &table[j];
+    e->hash = hash;
+    e->name = names;
+    e->offset = offset = align(offset);
+    e->size = files[i].size;
+    names += strlen(files[i].name) + 1;
+    offset += files[i].size;
+  }
+
+  memcpy(header.magic, PACK_MAGIC, 8);
+  header.slots = slots;
+  header.count = n;
+
+  out = fopen(argv[1], "wb");
+  if(out == NULL) {
+    perror(argv[1]);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(table, sizeof(PackEntry), slots, out);
+  for(i = 0; i < n; i++)
+    fwrite(files[i].name, strlen(files[i].name) + 1, 1, out);
+  offset = ftell(out);
+  for(i = 0; i < n; i++) {
+    fwrite(zero, align(offset) - offset, 1, out);
+    fwrite(files[i].data, files[i].size, 1, out);
+    offset = align(offset) + files[i].size;
+  }
+  if(fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  printf("mkpack: %s, %u files, %u bytes\n", argv[1], n, offset);
+  return 0;
+}
@@ -0,0 +1,453 @@
+/*
+  mktex: precompiles an .sgi texture into the .gtx format (see
+  texfile.h), with all mip levels and optionally in a GPU block format
+
+  mktex [-bc | -etc] IN.sgi OUT.gtx
+
+  Without a flag the levels are plain RGBA. -bc writes BC1 (BC3 if the
+  texture has alpha), -etc ETC1 (ETC2 RGBA with EAC alpha). The levels
+  are box filtered from the one above. Build together with
+  sgi_texture.c.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../sgi_texture.h"
+#include "../texfile.h"
+
+/* the loader reads plain files here, from the current directory */
+const void* packData(const char *name, size_t *size) {
+  return NULL;
+}
+
+FILE* openAsset(const char *filename) {
+  return fopen(filename, "rb");
+}
+
+typedef struct {
+  int w, h;
+  unsigned char *rgba;
+} Level;
+
+static int clamp255(int v) {
+  return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static uint32_t align(uint32_t v) {
+  return (v + 15) & ~(uint32_t) 15;
+}
+
+/* 2x2 box filter, a side that is down to 1 stays 1 */
+static Level halve(const Level *l) {
+  Level h;
+  int x, y, c, dx = l->w > 1, dy = l->h > 1;
+
+  h.w = l->w > 1 ? l->w / 2 : 1;
+  h.h = l->h > 1 ? l->h / 2 : 1;
+  h.rgba = malloc(h.w * h.h * 4);
+  for(y = 0; y < h.h; y++)
+    for(x = 0; x < h.w; x++)
+      for(c = 0; c < 4; c++) {
+        const unsigned char *p = l->rgba + ((y * (dy + 1)) * l->w + x * (dx + 1)) * 4 + c;
+        h.rgba[(y * h.w + x) * 4 + c] =
+          (p[0] + p[dx * 4] + p[dy * l->w * 4] + p[(dy * l->w + dx) * 4] + 2) / 4;
+      }
+  return h;
+}
+
+/* the 4x4 block at bx, by, edges repeated for levels smaller than that */
+static void fetchBlock(const Level *l, int bx, int by, unsigned char px[16][4]) {
+  int x, y, sx, sy;
+
+  for(y = 0; y < 4; y++)
+    for(x = 0; x < 4; x++) {
+      sx = bx * 4 + x < l->w ? bx * 4 + x : l->w - 1;
+      sy = by * 4 + y < l->h ? by * 4 + y : l->h - 1;
+      memcpy(px[y * 4 + x], l->rgba + (sy * l->w + sx) * 4, 4);
+    }
+}
+
+static int colorError(const unsigned char *a, const int *b) {
+  int r = a[0] - b[0], g = a[1] - b[1], bl = a[2] - b[2];
+  return r * r + g * g + bl * bl;
+}
+
+/* BC1 / BC3 */
+
+static int to565(const int *c) {
+  return (c[0] >> 3) << 11 | (c[1] >> 2) << 5 | c[2] >> 3;
+}
+
+static void from565(int v, int *c) {
+  c[0] = (v >> 11 & 31) * 255 / 31;
+  c[1] = (v >> 5 & 63) * 255 / 63;
+  c[2] = (v & 31) * 255 / 31;
+}
+
+/* colour endpoints from the bounding box, inset a little */
+static void encodeBC1(unsigned char px[16][4], unsigned char *out) {
+  int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+  int pal[4][3], c0, c1, i, k, best, e, be;
+  uint32_t bits = 0;
+
+  for(i = 0; i < 16; i++)
+    for(k = 0; k < 3; k++) {
+      if(px[i][k] < lo[k]) lo[k] = px[i][k];
+      if(px[i][k] > hi[k]) hi[k] = px[i][k];
+    }
+  for(k = 0; k < 3; k++) {
+    int inset = (hi[k] - lo[k]) / 16;
+    hi[k] -= inset;
+    lo[k] += inset;
+  }
+  c0 = to565(hi);
+  c1 = to565(lo);
+  /* c0 > c1 selects the four colour mode */
+  if(c0 < c1) {
+    int t = c0; c0 = c1; c1 = t;
+  }
+  from565(c0, pal[0]);
+  from565(c1, pal[1]);
+  for(k = 0; k < 3; k++) {
+    pal[2][k] = (2 * pal[0][k] + pal[1][k]) / 3;
+    pal[3][k] = (pal[0][k] + 2 * pal[1][k]) / 3;
+  }
+  if(c0 != c1)
+    for(i = 0; i < 16; i++) {
+      best = 0;
+      be = colorError(px[i], pal[0]);
+      for(k = 1; k < 4; k++)
+        if((e = colorError(px[i], pal[k])) < be) {
+          be = e;
+          best = k;
+        }
+      bits |= (uint32_t) best << (2 * i);
+    }
+  out[0] = c0; out[1] = c0 >> 8;
+  out[2] = c1; out[3] = c1 >> 8;
+  for(i = 0; i < 4; i++)
+    out[4 + i] = bits >> (8 * i);
+}
+
+static void encodeBC3Alpha(unsigned char px[16][4], unsigned char *out) {
+  int lo = 255, hi = 0, pal[8], i, k, best, e, be;
+  uint64_t bits = 0;
+
+  for(i = 0; i < 16; i++) {
+    if(px[i][3] < lo) lo = px[i][3];
+    if(px[i][3] > hi) hi = px[i][3];
+  }
+  /* a0 > a1: six interpolated values between them */
+  pal[0] = hi;
+  pal[1] = lo;
+  for(k = 1; k < 7; k++)
+    pal[k + 1] = ((7 - k) * hi + k * lo) / 7;
+  if(hi != lo)
+    for(i = 0; i < 16; i++) {
+      best = 0;
+      be = abs(px[i][3] - pal[0]);
+      for(k = 1; k < 8; k++)
+        if((e = abs(px[i][3] - pal[k])) < be) {
+          be = e;
+          best = k;
+        }
+      bits |= (uint64_t) best << (3 * i);
+    }
+  out[0] = hi;
+  out[1] = lo;
+  for(i = 0; i < 6; i++)
+    out[2 + i] = bits >> (8 * i);
+}
+
+/* ETC1 / EAC */
+
+static const int etcTables[8][2] = {
+  { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+  { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static const int eacTables[16][8] = {
+  { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+  { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+  { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+  { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+  { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+  { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+  { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+  { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+/* pixel index i of half h of a block, column-major as ETC numbers them */
+static int etcPixel(int flip, int h, int i) {
+  int x = flip ? i % 4 : h * 2 + i / 4;
+  int y = flip ? h * 2 + i / 4 : i % 4;
+  return x * 4 + y;
+}
+
+/* best table for a half block around base, fills in the 2 bit indices */
+static int etcHalf(unsigned char px[16][4], int flip, int h, const int *base,
+                   int *table, int idx[16]) {
+  int t, i, k, e, be, best, total, besttotal = -1;
+  int sel[8];
+
+  for(t = 0; t < 8; t++) {
+    total = 0;
+    for(i = 0; i < 8; i++) {
+      int p = etcPixel(flip, h, i);
+      const unsigned char *c = px[(p % 4) * 4 + p / 4];
+      /* modifier indices 0..3: +a, +b, -a, -b */
+      static const int sign[4] = { 1, 1, -1, -1 };
+      be = -1;
+      best = 0;
+      for(k = 0; k < 4; k++) {
+        int m = sign[k] * etcTables[t][k & 1], v[3];
+        v[0] = clamp255(base[0] + m);
+        v[1] = clamp255(base[1] + m);
+        v[2] = clamp255(base[2] + m);
+        e = colorError(c, v);
+        if(be < 0 || e < be) {
+          be = e;
+          best = k;
+        }
+      }
+      sel[i] = best;
+      total += be;
+    }
+    if(besttotal < 0 || total < besttotal) {
+      besttotal = total;
+      *table = t;
+      for(i = 0; i < 8; i++)
+        idx[etcPixel(flip, h, i)] = sel[i];
+    }
+  }
+  return besttotal;
+}
+
+static void halfAverage(unsigned char px[16][4], int flip, int h, int *avg) {
+  int i, k, p;
+
+  avg[0] = avg[1] = avg[2] = 0;
+  for(i = 0; i < 8; i++) {
+    p = etcPixel(flip, h, i);
+    for(k = 0; k < 3; k++)
+      avg[k] += px[(p % 4) * 4 + p / 4][k];
+  }
+  for(k = 0; k < 3; k++)
+    avg[k] = (avg[k] + 4) / 8;
+}
+
+/* tries both splits, differential mode where the halves are close */
+static void encodeETC1(unsigned char px[16][4], unsigned char *out) {
+  int flip, h, k, e, best = -1;
+  uint64_t block = 0;
+
+  for(flip = 0; flip < 2; flip++) {
+    int avg[2][3], q[2][3], base[2][3], table[2], idx[16];
+    int diff = 1;
+    uint64_t b = 0;
+
+    for(h = 0; h < 2; h++)
+      halfAverage(px, flip, h, avg[h]);
+    for(k = 0; k < 3; k++) {
+      q[0][k] = (avg[0][k] * 31 + 127) / 255;
+      q[1][k] = (avg[1][k] * 31 + 127) / 255;
+      if(q[1][k] - q[0][k] < -4 || q[1][k] - q[0][k] > 3)
+        diff = 0;
+    }
+    for(h = 0; h < 2; h++)
+      for(k = 0; k < 3; k++) {
+        if(diff) {
+          base[h][k] = q[h][k] << 3 | q[h][k] >> 2;
+        } else {
+          q[h][k] = (avg[h][k] * 15 + 127) / 255;
+          base[h][k] = q[h][k] << 4 | q[h][k];
+        }
+      }
+
+    e = etcHalf(px, flip, 0, base[0], &table[0], idx) +
+      etcHalf(px, flip, 1, base[1], &table[1], idx);
+    if(best >= 0 && e >= best)
+      continue;
+    best = e;
+
+    for(k = 0; k < 3; k++) {
+      if(diff)
+        b |= (uint64_t) (q[0][k] << 3 | ((q[1][k] - q[0][k]) & 7)) << (56 - 8 * k);
+      else
+        b |= (uint64_t) (q[0][k] << 4 | q[1][k]) << (56 - 8 * k);
+    }
+    b |= (uint64_t) table[0] << 37 | (uint64_t) table[1] << 34 |
+      (uint64_t) diff << 33 | (uint64_t) flip << 32;
+    for(k = 0; k < 16; k++)
+      b |= (uint64_t) (idx[k] >> 1) << (16 + k) | (uint64_t) (idx[k] & 1) << k;
+    block = b;
+  }
+  for(k = 0; k < 8; k++)
+    out[k] = block >> (56 - 8 * k);
+}
+
+static void encodeEAC(unsigned char px[16][4], unsigned char *out) {
+  int lo = 255, hi = 0, t, m, i, k, e, be, best;
+  int bestErr = -1, bestBase = 0, bestMul = 1, bestTable = 13;
+  int sel[16], bestSel[16];
+  uint64_t b;
+
+  for(i = 0; i < 16; i++) {
+    if(px[i][3] < lo) lo = px[i][3];
+    if(px[i][3] > hi) hi = px[i][3];
+  }
+  for(i = 0; i < 16; i++)
+    bestSel[i] = 4; /* table 13, index 4 adds 0 */
+  bestBase = lo;
+
+  if(hi != lo)
+    for(t = 0; t < 16; t++) {
+      int range = eacTables[t][7] - eacTables[t][3];
+      int guess = (hi - lo + range / 2) / range;
+      for(m = guess - 1; m <= guess + 1; m++) {
+        int base, total = 0;
+        if(m < 1 || m > 15)
+          continue;
+        /* the lowest value lands on the smallest modifier */
+        base = clamp255(lo - eacTables[t][3] * m);
+        for(i = 0; i < 16; i++) {
+          be = -1;
+          best = 0;
+          for(k = 0; k < 8; k++) {
+            e = abs(px[i][3] - clamp255(base + eacTables[t][k] * m));
+            if(be < 0 || e < be) {
+              be = e;
+              best = k;
+            }
+          }
+          sel[i] = best;
+          total += be * be;
+        }
+        if(bestErr < 0 || total < bestErr) {
+          bestErr = total;
+          bestBase = base;
+          bestMul = m;
+          bestTable = t;
+          memcpy(bestSel, sel, sizeof(sel));
+        }
+      }
+    }
+
+  b = (uint64_t) bestBase << 56 | (uint64_t) bestMul << 52 |
+    (uint64_t) bestTable << 48;
+  /* pixels column-major, px is row-major */
+  for(i = 0; i < 16; i++)
+    b |= (uint64_t) bestSel[(i % 4) * 4 + i / 4] << (45 - 3 * i);
+  for(k = 0; k < 8; k++)
+    out[k] = b >> (56 - 8 * k);
+}
+
+static void encodeLevel(const Level *l, int format, unsigned char *out) {
+  unsigned char px[16][4];
+  int bx, by;
+
+  if(format == TEX_RGBA8) {
+    memcpy(out, l->rgba, l->w * l->h * 4);
+    return;
+  }
+  for(by = 0; by < (l->h + 3) / 4; by++)
+    for(bx = 0; bx < (l->w + 3) / 4; bx++) {
+      fetchBlock(l, bx, by, px);
+      switch(format) {
+      case TEX_BC1: encodeBC1(px, out); out += 8; break;
+      case TEX_BC3: encodeBC3Alpha(px, out); encodeBC1(px, out + 8); out += 16; break;
+      case TEX_ETC1: encodeETC1(px, out); out += 8; break;
+      default: encodeEAC(px, out); encodeETC1(px, out + 8); out += 16; break;
+      }
+    }
+}
+
+static int writeTexture(Level *level, int levels, int format, char *path) {
+  static const char zero[16];
+  TexHeader header;
+  TexLevel *l;
+  FILE *out;
+  uint32_t offset;
+  unsigned char *data;
+  int i;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TEX_MAGIC, 8);
+  header.format = format;
+  header.width = level[0].w;
+  header.height = level[0].h;
+  header.levels = levels;
+
+  l = calloc(levels, sizeof(TexLevel));
+  offset = sizeof(header) + levels * sizeof(TexLevel);
+  for(i = 0; i < levels; i++) {
+    l[i].width = level[i].w;
+    l[i].height = level[i].h;
+    l[i].offset = offset = align(offset);
+    l[i].size = texLevelSize(format, level[i].w, level[i].h);
+    offset += l[i].size;
+  }
+
+  out = fopen(path, "wb");
+  if(out == NULL) {
+    perror(path);
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(l, sizeof(TexLevel), levels, out);
+  offset = sizeof(header) + levels * sizeof(TexLevel);
+  for(i = 0; i < levels; i++) {
+    fwrite(zero, l[i].offset - offset, 1, out);
+    data = malloc(l[i].size);
+    encodeLevel(level + i, format, data);
+    fwrite(data, l[i].size, 1, out);
+    free(data);
+    offset = l[i].offset + l[i].size;
+  }
+  free(l);
+  if(fclose(out) != 0) {
+    perror(path);
+    return 1;
+  }
+  printf("mktex: %s, %dx%d, %d levels, %u bytes\n",
+         path, header.width, header.height, levels, offset);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  Level level[16];
+  sgi_texture *tex;
+  int levels, i, opaque = 1, format = TEX_RGBA8;
+  char *flag = argc == 4 ? argv[1] : "";
+
+  if((argc != 3 && argc != 4) ||
+     (argc == 4 && strcmp(flag, "-bc") != 0 && strcmp(flag, "-etc") != 0)) {
+    fprintf(stderr, "usage: %s [-bc | -etc] IN.sgi OUT.gtx\n", argv[0]);
+    return 1;
+  }
+  tex = load_sgi_texture(argv[argc - 2]);
+  if(tex == NULL)
+    return 1;
+
+  /* RGBA, the way the game uploads .sgi files */
+  level[0].w = tex->width;
+  level[0].h = tex->height;
+  level[0].rgba = malloc(tex->width * tex->height * 4);
+  for(i = 0; i < tex->width * tex->height; i++) {
+    memcpy(level[0].rgba + i * 4, tex->data + i * tex->channels, 3);
+    level[0].rgba[i * 4 + 3] = tex->channels == 4 ? tex->data[i * 4 + 3] : 255;
+    if(level[0].rgba[i * 4 + 3] != 255)
+      opaque = 0;
+  }
+  unload_sgi_texture(tex);
+
+  for(levels = 1; level[levels - 1].w > 1 || level[levels - 1].h > 1; levels++)
+    level[levels] = halve(level + levels - 1);
+
+  if(strcmp(flag, "-bc") == 0)
+    format = opaque ? TEX_BC1 : TEX_BC3;
+  else if(strcmp(flag, "-etc") == 0)
+    format = opaque ? TEX_ETC1 : TEX_ETC2_EAC;
+  return writeTexture(level, levels, format, argv[argc - 1]);
+}